@@ -6,20 +6,110 @@
 enum BoundaryType : uint8_t
 {
   BOUNDARY_CIRCULAR = 0,
-  BOUNDARY_RECTANGULAR = 1
+  BOUNDARY_RECTANGULAR = 1,
+  // Table-driven shapes (see BoundaryCell).
+  BOUNDARY_ROUNDED_RECT = 2,
+  BOUNDARY_HALF_CIRCLE = 3
 };
 
+static constexpr uint8_t BOUNDARY_SHAPE_COUNT = 4;
+// Side of the signed-distance table; it covers [0,1]^2 plus a margin (see Boundary.cpp).
+static constexpr uint8_t BOUNDARY_FIELD_SIZE = 64;
+
+// One signed-distance sample at a cell center: distance (positive outside) in
+// 1/BOUNDARY_DIST_SCALE units and the outward normal in 1/127 units.
+struct BoundaryCell
+{
+  int16_t dist;
+  int8_t nx;
+  int8_t ny;
+};
+
+static constexpr float BOUNDARY_DIST_SCALE = 16384.0f;
+// Steps of the circle's repulsion falloff table (sampled in squared distance).
+static constexpr uint8_t BOUNDARY_FALLOFF_STEPS = 32;
+
+// Config snapshot taken once per step so per-particle enforcement reads no config fields.
+struct BoundaryParams
+{
+  uint8_t shape;
+  uint8_t mode;
+  float radius;
+  float radiusSq;
+  float damping;
+  // Contact: outward normal velocity *= -bounce (restitution x damping), tangential *= friction.
+  float bounce;
+  float friction;
+  // Near-wall zone (bounce mode only): velocity kick repulsion * u^2 per timeStep, u = 0 at the
+  // inner edge of the zone and 1 at the wall. repulsion == 0 disables the zone.
+  float repulsion;
+  float zone;
+  float invZone;
+  // Circle: zone starts at innerSq; falloff[k] holds u^2 / d at d^2 = innerSq + k / falloffScale,
+  // so the kick is (dx, dy) * falloff[k] with no sqrt or divide.
+  float innerSq;
+  float falloffScale;
+  const float *falloff;
+  // Signed-distance table for the table-driven shapes, nullptr for circle and rectangle.
+  const BoundaryCell *field;
+};
+
+// Bounce mode: contact splits the velocity into restitution on the normal and
+// friction on the tangent, and boundaryRepulsion adds a soft zone inside the wall
+// (15% of the radius for the circle, 10% of the side otherwise) so particles
+// ease off before they touch.
+//
+// Circle and rectangle are analytic. Any other shape is baked into a
+// BOUNDARY_FIELD_SIZE^2 table of distance + normal whenever the shape or scale
+// changes; containment is then one table fetch plus a first-order correction
+// from the cell center, exact along straight edges.
 class Boundary
 {
 public:
   explicit Boundary(SimConfig *config) : config_(config) {}
 
-  void enforce(float &x, float &y, float &vx, float &vy) const;
+  void enforce(float &x, float &y, float &vx, float &vy);
+  // Snapshot for a step of dt; rebakes the tables when the shape or scale changed.
+  BoundaryParams getParams(float dt);
+  static void enforce(const BoundaryParams &p, float &x, float &y, float &vx, float &vy);
+  // Zone kicks, shared by the scalar and the vector paths (call only for particles inside).
+  static inline void repelCircle(const BoundaryParams &p, float dx, float dy, float d2, float &vx, float &vy)
+  {
+    if (d2 > p.innerSq)
+    {
+      const float k = p.repulsion * p.falloff[(int)((d2 - p.innerSq) * p.falloffScale + 0.5f)];
+      vx -= dx * k;
+      vy -= dy * k;
+    }
+  }
+  static inline void repelRect(const BoundaryParams &p, float x, float y, float &vx, float &vy)
+  {
+    vx += wallKick(p, x) - wallKick(p, 1.0f - x);
+    vy += wallKick(p, y) - wallKick(p, 1.0f - y);
+  }
   BoundaryType getBoundaryType() const;
   float getRadius() const;
+  // Exact signed distance to the current shape (positive outside), used for spawning.
+  float signedDistance(float x, float y) const;
 
 private:
+  // Kick away from a wall at distance `gap` (positive inside).
+  static inline float wallKick(const BoundaryParams &p, float gap)
+  {
+    const float u = 1.0f - gap * p.invZone;
+    return u > 0.0f ? p.repulsion * u * u : 0.0f;
+  }
+  static void enforceField(const BoundaryParams &p, float &x, float &y, float &vx, float &vy);
+  float shapeDistance(BoundaryType shape, float x, float y, float &nx, float &ny) const;
+  void bakeField(BoundaryType shape);
+  void bakeFalloff(float radius, float zone);
+
   SimConfig *config_;
+  BoundaryCell field_[BOUNDARY_FIELD_SIZE * BOUNDARY_FIELD_SIZE];
+  uint8_t fieldShape_ = 0xFF;
+  float fieldScale_ = 0.0f;
+  float falloff_[BOUNDARY_FALLOFF_STEPS + 1];
+  float falloffRadius_ = 0.0f;
 };
 
 #endif
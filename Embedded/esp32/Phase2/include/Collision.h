@@ -1,21 +1,149 @@
 #ifndef PHASE2_COLLISION_H
 #define PHASE2_COLLISION_H
 
+#include <atomic>
+
+#include "NeighborGrid.h"
+#include "ParticleArena.h"
 #include "SimConfig.h"
+#include "WorkerPool.h"
 
-static constexpr uint16_t MAX_PARTICLES = 300;
-static constexpr uint8_t MAX_COLLISION_GRID = 16;
-static constexpr uint8_t MAX_CELL_PARTICLES = 32;
+// Auto sizing can go this fine with small radii; the manual collisionGridSize stays 4-16.
+// Collision grids are NeighborGrids, so they share its ceiling.
+static constexpr uint8_t MAX_COLLISION_GRID = MAX_NEIGHBOR_GRID;
+static constexpr uint16_t MAX_COLLISION_CELLS = (uint16_t)MAX_COLLISION_GRID * MAX_COLLISION_GRID;
+// Size levels of the mixed-radius broadphase (cells halve per level).
+static constexpr uint8_t COLLISION_LEVELS = 3;
+// Independent cell sets per pass (3 columns x 2 rows, see Collision.cpp).
+static constexpr uint8_t COLLISION_COLORS = 6;
+// Verlet list budget; a denser scene falls back to a grid rebuild every step until it fits.
+static constexpr uint8_t COLLISION_PAIRS_PER_PARTICLE = 6;
 
+// Counters since the last consumeStats(). steps counts resolve() calls that ran; rebuilds
+// counts grid builds, so rebuilds == steps when the Verlet list is off or overflowing.
+struct CollisionStats
+{
+  uint32_t steps;
+  uint32_t rebuilds;
+  uint32_t pairsTested;
+  uint32_t contacts;
+  uint32_t overflows;
+  uint32_t passes;
+  // Grid side used by the latest build (not reset by consumeStats()).
+  uint8_t gridSize;
+};
+
+// Particle-particle overlap resolution over the shared NeighborGrid (SimCore's, bound in
+// begin()). Cells are never smaller than the pair cutoff (2r, plus the skin with the Verlet
+// list), since the 3x3 stencil only sees pairs up to one cell apart. With collisionGridAuto
+// the grid is as fine as that allows, up to about two cells per particle; otherwise
+// collisionGridSize is used, coarsened when needed. A grid that is still valid for these
+// positions and coarse enough is used as is; otherwise resolve() rebuilds it. Every particle
+// is tested (no per-cell cap) and a cell's members are contiguous.
+//
+// With collisionSkin > 0 the grid pass stores every pair closer than 2r + skin
+// in a Verlet list, and later steps only walk that list. The list stays valid
+// until some particle has moved more than skin / 2 from where it was at the
+// rebuild, or the count or radius changes. A scene that keeps forcing rebuilds
+// drops back to the plain grid path for a while.
+//
+// Mixed radii (per-particle radius column): pairs touch at r[i] + r[j]. List rebuilds
+// search COLLISION_LEVELS grids so small particles only scan small cells; growing
+// particles eat into the skin like moving ones.
+//
+// Response: each overlapping pair is projected apart and, when approaching, gets an
+// impulse scaled by (1 + particleRestitution), both split by inverse mass. Up to
+// collisionIterations relaxation passes run per step, stopping early once the largest
+// correction falls below collisionTolerance of a particle diameter.
+//
+// Each pass walks the grid (or list) color by color on collisionThreads workers.
+// Results do not depend on the worker count.
 class Collision
 {
 public:
   explicit Collision(SimConfig *cfg) : config_(cfg) {}
 
-  void resolve(float *x, float *y, float *vx, float *vy, uint16_t count, float particleRadius) const;
+  // Bytes begin() takes for the mixed-radius level index and for the Verlet list (always
+  // ARENA_BULK). Both include the per-cell arrays for MAX_COLLISION_CELLS.
+  static size_t indexStorageBytes(uint16_t capacity);
+  static size_t listStorageBytes(uint16_t capacity);
+  // Carves the per-particle arrays and binds the grid the uniform path searches; resolve()
+  // is a no-op until this succeeds. Without room for the Verlet list, the grid path runs
+  // every step.
+  bool begin(ParticleArena &arena, ArenaRegion indexRegion, uint16_t capacity, NeighborGrid &grid);
+  // Grid side resolve() would build for these particles; SimCore bins the shared grid with it
+  // so the next resolve() can take it as is.
+  uint8_t preferredGridSize(uint16_t count, float particleRadius, const float *radius) const;
+
+  // radius / mass are optional per-particle columns (nullptr: every particle has particleRadius
+  // and equal mass). particleRadius still scales the skin and the tolerance.
+  void resolve(float *x, float *y, float *vx, float *vy, uint16_t count, float particleRadius,
+               const float *radius = nullptr, const float *mass = nullptr);
+  // Forces a Verlet rebuild; call whenever particle indices are reshuffled.
+  void invalidate() { listValid_ = false; }
+  // Fresh start for a respawn: also drops the busy-scene backoff, so the next run does not
+  // depend on the previous one.
+  void reset()
+  {
+    listValid_ = false;
+    rebuildStreak_ = 0;
+    busyBackoff_ = 0;
+  }
+
+  // Safe to call from another core than the one running resolve().
+  CollisionStats consumeStats();
 
 private:
+  uint8_t chooseGridSize(uint16_t count, float cutoff) const;
+  // Makes grid_ hold these positions with cells spanning cutoff; returns the grid side.
+  uint8_t prepareGrid(const float *x, const float *y, uint16_t count, float cutoff);
+  bool listNeedsRebuild(const float *x, const float *y, const float *radius, uint16_t count, float cutoff, float skin) const;
+  // Builds the grid and the Verlet list; false when the list overflowed.
+  bool buildList(const float *x, const float *y, uint16_t count, float cutoff);
+  // Mixed radii: level-grid search, pairs bucketed by owner cell of a base grid. Leaves no
+  // usable grid behind, so an overflow is followed by prepareGrid().
+  bool buildMixedList(const float *x, const float *y, const float *radius, uint16_t count, float skin, float rMin,
+                      float rMax);
+  // One relaxation pass for one worker; barriers between cell colors.
+  static void passEntry(void *ctx, uint8_t worker, uint8_t workers);
+  void runPass(struct ResolveVisitor &resolver, uint8_t worker, uint8_t workers);
+
   SimConfig *config_;
+  NeighborGrid *grid_ = nullptr;
+  // Level-grid sort of the mixed-radius list build (NeighborGrid::sortByCell()):
+  // cellStart_[c]..cellStart_[c + 1] is the slice of order_ holding level cell c.
+  uint16_t *cellOf_ = nullptr;
+  uint16_t *order_ = nullptr;
+  uint16_t *cellStart_ = nullptr;
+  uint16_t capacity_ = 0;
+
+  // Verlet list: pairs as (i << 16 | j), plus positions (and radii) at the last rebuild.
+  uint32_t *pairs_ = nullptr;
+  uint32_t pairCapacity_ = 0;
+  uint32_t pairCount_ = 0;
+  float *refX_ = nullptr;
+  float *refY_ = nullptr;
+  float *refR_ = nullptr;
+  uint16_t listCount_ = 0;
+  float listCutoff_ = 0.0f;
+  bool listValid_ = false;
+  bool listMixed_ = false;
+  uint8_t rebuildStreak_ = 0;
+  uint8_t busyBackoff_ = 0;
+  // slotStart_[s]..slotStart_[s + 1] are the list pairs of the s-th cell in color order;
+  // colorSlot_[c] is the first slot of color c.
+  uint32_t *slotStart_ = nullptr;
+  uint16_t colorSlot_[COLLISION_COLORS + 1];
+
+  WorkerPool pool_;
+
+  std::atomic<uint32_t> steps_{0};
+  std::atomic<uint32_t> rebuilds_{0};
+  std::atomic<uint32_t> pairsTested_{0};
+  std::atomic<uint32_t> contacts_{0};
+  std::atomic<uint32_t> overflows_{0};
+  std::atomic<uint32_t> passes_{0};
+  std::atomic<uint8_t> reportedGrid_{0};
 };
 
 #endif
@@ -1,21 +1,101 @@
 #ifndef PHASE2_FLUID_FLIP_H
 #define PHASE2_FLUID_FLIP_H
 
+#include "Boundary.h"
 #include "SimConfig.h"
 
+// Cells per side over [0,1]^2; faces carry velocity, cell centers pressure and density.
 static constexpr uint8_t FLIP_GRID = 16;
+static constexpr uint16_t FLIP_CELLS = (uint16_t)FLIP_GRID * FLIP_GRID;
+// Horizontal faces sit on FLIP_GRID + 1 columns, vertical ones on FLIP_GRID + 1 rows.
+static constexpr uint16_t FLIP_FACES = (uint16_t)(FLIP_GRID + 1) * FLIP_GRID;
 
+// Counters since the last consumeStats(). Divergences are RMS over fluid cells, in
+// velocity units, summed over steps; divide by steps for the average.
+struct FluidStats
+{
+  uint32_t steps;
+  uint32_t fluidCells;
+  uint32_t sweeps;
+  float divergenceIn;
+  float divergenceOut;
+};
+
+// PIC/FLIP pass ported from Sim/src/simulation/core/fluidFLIP.js: particle velocities are
+// splatted onto a staggered FLIP_GRID^2 grid, made divergence-free by red-black SOR, and read
+// back as picFlipRatio x grid velocity (PIC) plus the rest as the particle's own velocity plus
+// the grid's change (FLIP). Runs only while picFlipRatio > 0.
+//
+// Cells whose center lies outside the boundary are solid: faces touching them carry no
+// normal flow. Cells holding a particle are fluid; the rest are air (free surface).
+// restDensity is the particle count per cell the solve pushes crowded cells back toward.
+//
+// The solve starts from the previous step's pressure and sweeps until the RMS residual falls
+// below fluidTolerance of the divergence it started from, or fluidIterations sweeps.
+//
+// All grids are members, so a step allocates nothing.
 class FluidFLIP
 {
 public:
   explicit FluidFLIP(SimConfig *cfg) : config_(cfg) {}
   void clear();
-  void step(float dt);
+  // Reads x / y and rewrites vx / vy for count particles.
+  void step(const Boundary &boundary, const float *x, const float *y, float *vx, float *vy, uint16_t count, float dt);
+  FluidStats consumeStats();
 
 private:
+  enum CellType : uint8_t
+  {
+    CELL_AIR = 0,
+    CELL_FLUID = 1,
+    CELL_SOLID = 2
+  };
+
+  // Bits of open_: which neighbors are not solid.
+  enum OpenSide : uint8_t
+  {
+    OPEN_LEFT = 1,
+    OPEN_RIGHT = 2,
+    OPEN_DOWN = 4,
+    OPEN_UP = 8
+  };
+
+  void markSolids(const Boundary &boundary);
+  void transferToGrid(const float *x, const float *y, const float *vx, const float *vy, uint16_t count);
+  void applyBoundaryConditions();
+  void solveIncompressibility(float posScale);
+  // Pressure impulse p on cell (i, j): outflow through its open faces rises by p each.
+  void push(int i, int j, uint8_t open, float p);
+  // Target outflow minus actual outflow of cell (i, j).
+  float residual(int i, int j) const;
+  void transferToParticles(const float *x, const float *y, float *vx, float *vy, uint16_t count) const;
+  bool isOpen(int i, int j) const;
+
   SimConfig *config_;
-  float pressure_[FLIP_GRID * FLIP_GRID] = {0.0f};
-  float divergence_[FLIP_GRID * FLIP_GRID] = {0.0f};
+  // u_ at (i, j + 0.5) * h, index j * (FLIP_GRID + 1) + i; v_ at (i + 0.5, j) * h, index j * FLIP_GRID + i.
+  float u_[FLIP_FACES];
+  float v_[FLIP_FACES];
+  // Face velocities before the solve (the FLIP delta) and splat weights; after the transfer
+  // the weights hold 1 for faces next to a fluid cell and 0 elsewhere.
+  float prevU_[FLIP_FACES];
+  float prevV_[FLIP_FACES];
+  float weightU_[FLIP_FACES];
+  float weightV_[FLIP_FACES];
+  // Pressure impulse (kept for the next step's warm start) and divergence before the solve, per cell.
+  float pressure_[FLIP_CELLS] = {0.0f};
+  float divergence_[FLIP_CELLS] = {0.0f};
+  // Particles per cell, splatted to cell centers, and the outflow the solve aims for:
+  // zero, or a push out of cells above restDensity.
+  float density_[FLIP_CELLS];
+  float target_[FLIP_CELLS];
+  uint8_t cellType_[FLIP_CELLS];
+  uint8_t solid_[FLIP_CELLS];
+  // Per cell, rebuilt with solid_: open sides and overrelaxation / open side count.
+  uint8_t open_[FLIP_CELLS];
+  float relax_[FLIP_CELLS];
+  uint8_t solidShape_ = 0xFF;
+  float solidScale_ = 0.0f;
+  FluidStats stats_ = {};
 };
 
 #endif
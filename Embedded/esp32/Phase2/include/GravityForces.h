@@ -5,6 +5,7 @@
 
 namespace GravityForces
 {
+// Velocity columns must be 16-byte aligned and padded to SIMD_WIDTH (see SimdF4.h).
 void apply(float gx, float gy, float dt, float *velX, float *velY, uint16_t count);
 }
 
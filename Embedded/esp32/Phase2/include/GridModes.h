@@ -2,30 +2,60 @@
 #define PHASE2_GRID_MODES_H
 
 #include "GridGeometry.h"
-#include "SimCore.h"
+#include "NeighborGrid.h"
+#include "ParticleArena.h"
+#include "ParticleView.h"
 
+// Particle -> cell value modes. Every mode except Proximity (an unbounded Gaussian) only sees
+// particles whose support reaches the cell, so cells gather their candidates from a
+// NeighborGrid instead of scanning every particle. ProximityB takes its pairs from the same
+// grid once per frame; Collision pairs up a cell's candidates. The grid is the view's (the sim's own,
+// single core) or, for a snapshot, one binned here once per compute().
 class GridModes
 {
 public:
   explicit GridModes(SimConfig *cfg) : config_(cfg) {}
 
-  void compute(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeProximity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeProximityB(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeDensity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeVelocity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computePressure(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeCollision(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
-  void computeOverlap(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  // Reserves the fallback grid and the per-particle scratch for capacity particles. Until this
+  // succeeds, the grid-backed modes output zeros.
+  bool begin(uint16_t capacity);
+
+  void compute(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeProximity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeProximityB(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeDensity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeVelocity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computePressure(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeCollision(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  void computeOverlap(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
+  // Mean automata state of the particles covering a cell (ParticleView::getStates()), faded by
+  // coverage; zeros when the view carries no states.
+  void computeAutomata(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount);
 
 private:
   uint16_t activeCellCount(const GridGeometry &geom, uint16_t outCount) const;
+  // The view's grid, else grid_ binned over the view for pairs up to cutoff; nullptr without storage.
+  const NeighborGrid *neighborsFor(const ParticleView &sim, float cutoff);
+  float maxRadius(const ParticleView &sim) const;
+  // Candidates for cell (cellX, cellY): particles in grid cells within reach of its rectangle,
+  // written to near_. Returns how many.
+  uint16_t gatherCell(const NeighborGrid &grid, float cellX, float cellY, float halfW, float halfH, float reach);
+  // Per-particle radius from the view, SimConfig::particleRadius when it has none.
+  float radiusOf(const float *radius, uint16_t i) const;
   float cellContribution(float px, float py, float cellX, float cellY, float cellHalfWidth, float cellHalfHeight, float radius) const;
   void smoothAndStore(const float *target, uint16_t cells, uint8_t *outValues, uint16_t outCount);
   void clearToZero(uint16_t cells, uint8_t *outValues, uint16_t outCount);
 
   SimConfig *config_;
   float smooth_[MAX_GRID_CELLS] = {0.0f};
+  ParticleArena arena_;
+  NeighborGrid grid_;
+  uint16_t capacity_ = 0;
+  // Per-particle scratch: a cell's candidates and two accumulators (ProximityB: closeness sum
+  // and pair count per particle; Collision: weight per candidate).
+  uint16_t *near_ = nullptr;
+  float *sum_ = nullptr;
+  float *weight_ = nullptr;
 };
 
 #endif
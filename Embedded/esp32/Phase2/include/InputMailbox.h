@@ -0,0 +1,39 @@
+#ifndef PHASE2_INPUT_MAILBOX_H
+#define PHASE2_INPUT_MAILBOX_H
+
+#include <atomic>
+#include <stdint.h>
+
+// One sample of the inputs a sim frame reads, taken together on the core that updates them.
+struct SimInputs
+{
+  uint16_t touchX;
+  uint16_t touchY;
+  bool touching;
+  float accelX;
+  float accelY;
+  float accelZ;
+};
+
+// Latest-value hand-off of SimInputs from loop() to stepSimulation(), with the three-slot
+// exchange of SnapshotBuffer: the writer fills a slot the reader is not holding, so a frame
+// always sees one whole sample and neither side waits (single producer, single consumer).
+// Used in both core modes, so single- and dual-core frames get their inputs the same way.
+class InputMailbox
+{
+public:
+  void publish(const SimInputs &in);
+  // Newest sample published; all zeros before the first publish().
+  const SimInputs &acquire();
+
+private:
+  static constexpr uint8_t kSlotCount = 3;
+  static constexpr uint8_t kFreshBit = 0x80;
+
+  SimInputs slots_[kSlotCount] = {};
+  uint8_t back_ = 0;
+  uint8_t front_ = 1;
+  std::atomic<uint8_t> ready_{2};
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef PHASE2_NEIGHBOR_GRID_H
+#define PHASE2_NEIGHBOR_GRID_H
+
+#include "ParticleArena.h"
+
+// Finest binning over [0,1]^2; the same ceiling as the collision grid it replaces.
+static constexpr uint8_t MAX_NEIGHBOR_GRID = 48;
+static constexpr uint16_t MAX_NEIGHBOR_CELLS = (uint16_t)MAX_NEIGHBOR_GRID * MAX_NEIGHBOR_GRID;
+
+// Counting-sort uniform grid over particle positions, the C++ counterpart of
+// Sim/src/simulation/behaviors/neighborSearch.js. build() bins count particles into gridSize^2
+// cells: getCellStart()[c]..getCellStart()[c + 1] is the slice of getOrder() holding cell c,
+// in ascending particle order. Queries work for any radius; a radius larger than a cell
+// just scans more cells.
+//
+// SimCore owns one instance and rebuilds it at most once per set of positions (see
+// SimCore::getNeighbors()); collision, the organic behaviors and single-core GridModes all
+// read that one. A snapshot rendered on the other core has its own positions, so GridModes
+// bins it into a second instance once per render frame.
+class NeighborGrid
+{
+public:
+  static size_t storageBytes(uint16_t capacity);
+  // Carves the index arrays; build() is a no-op until this succeeds.
+  bool begin(ParticleArena &arena, ArenaRegion region, uint16_t capacity);
+  bool isReady() const { return order_ != nullptr; }
+
+  // Finest grid whose cells span cutoff.
+  static uint8_t fitCutoff(float cutoff);
+  // fitCutoff(), capped at about two cells per particle.
+  static uint8_t fitGridSize(float cutoff, uint16_t count);
+  // Counting sort of the indices 0..count-1 by cellOf[] into cellCount cells: cellStart (cellCount
+  // + 1 entries) and order as described above. build() and Collision's mixed-radius levels use it.
+  static void sortByCell(const uint16_t *cellOf, uint16_t count, uint16_t cellCount, uint16_t *cellStart, uint16_t *order);
+  // Bins x / y (clamped to the edge cells) and keeps the pointers for the queries below.
+  void build(const float *x, const float *y, uint16_t count, uint8_t gridSize);
+  // Call whenever positions move or indices are reshuffled after build().
+  void invalidate() { valid_ = false; }
+  bool isValid() const { return valid_; }
+  // True while the grid still bins exactly these columns.
+  bool matches(const float *x, const float *y, uint16_t count) const
+  {
+    return valid_ && x_ == x && y_ == y && count_ == count;
+  }
+
+  uint8_t getGridSize() const { return gridSize_; }
+  uint16_t getCount() const { return count_; }
+  uint32_t getBuilds() const { return builds_; }
+  const uint16_t *getOrder() const { return order_; }
+  const uint16_t *getCellStart() const { return cellStart_; }
+  uint8_t cellCoord(float v) const
+  {
+    const int c = (int)(v * gridSize_);
+    return (uint8_t)(c < 0 ? 0 : (c >= gridSize_ ? gridSize_ - 1 : c));
+  }
+
+  // Calls visit(j) for every particle in the cells overlapping [x0, x1] x [y0, y1]. A superset
+  // of the particles inside the box; the visitor does the exact test.
+  template <typename Visitor>
+  void forEachInBox(float x0, float y0, float x1, float y1, Visitor &visit) const
+  {
+    const uint8_t cx0 = cellCoord(x0);
+    const uint8_t cx1 = cellCoord(x1);
+    const uint8_t cy1 = cellCoord(y1);
+    for (uint8_t cy = cellCoord(y0); cy <= cy1; ++cy)
+    {
+      // Cells of one row are contiguous in order_.
+      const uint16_t row = (uint16_t)cy * gridSize_;
+      const uint16_t end = cellStart_[row + cx1 + 1];
+      for (uint16_t b = cellStart_[row + cx0]; b < end; ++b)
+      {
+        visit(order_[b]);
+      }
+    }
+  }
+
+  // Calls visit(j, dx, dy, d2) for every particle j with d2 = |p_j - (px, py)|^2 < radius^2,
+  // (dx, dy) pointing from (px, py) to p_j. A particle at (px, py) itself is visited too.
+  template <typename Visitor>
+  void forEachNear(float px, float py, float radius, Visitor &visit) const
+  {
+    RadiusFilter<Visitor> filter = {x_, y_, px, py, radius * radius, &visit};
+    forEachInBox(px - radius, py - radius, px + radius, py + radius, filter);
+  }
+
+  // Writes up to maxOut indices within radius of (px, py) to out; returns how many were found,
+  // which can exceed maxOut.
+  uint16_t queryRadius(float px, float py, float radius, uint16_t *out, uint16_t maxOut) const;
+  // Up to k particles other than self within radius of (px, py), nearest first: indices to out,
+  // squared distances to outD2 (both k long). Walks rings of cells outward and stops once k are
+  // closer than the next ring, so a crowded neighbourhood costs about k candidates instead of
+  // everything inside radius. Returns how many were written.
+  uint8_t queryNearest(float px, float py, float radius, uint16_t self, uint8_t k, uint16_t *out, float *outD2) const;
+
+  // Calls visit(i, j, dx, dy, d2) once for every pair closer than cutoff, i < j, (dx, dy) = p_j - p_i.
+  template <typename Visitor>
+  void forEachPair(float cutoff, Visitor &visit) const
+  {
+    const float cutoffSq = cutoff * cutoff;
+    for (uint16_t i = 0; i < count_; ++i)
+    {
+      const float xi = x_[i];
+      const float yi = y_[i];
+      const uint8_t cx0 = cellCoord(xi - cutoff);
+      const uint8_t cx1 = cellCoord(xi + cutoff);
+      const uint8_t cy1 = cellCoord(yi + cutoff);
+      for (uint8_t cy = cellCoord(yi - cutoff); cy <= cy1; ++cy)
+      {
+        const uint16_t row = (uint16_t)cy * gridSize_;
+        const uint16_t end = cellStart_[row + cx1 + 1];
+        for (uint16_t b = cellStart_[row + cx0]; b < end; ++b)
+        {
+          const uint16_t j = order_[b];
+          if (j <= i)
+          {
+            continue;
+          }
+          const float dx = x_[j] - xi;
+          const float dy = y_[j] - yi;
+          const float d2 = dx * dx + dy * dy;
+          if (d2 < cutoffSq)
+          {
+            visit(i, j, dx, dy, d2);
+          }
+        }
+      }
+    }
+  }
+
+private:
+  template <typename Visitor>
+  struct RadiusFilter
+  {
+    const float *x;
+    const float *y;
+    float px;
+    float py;
+    float radiusSq;
+    Visitor *visit;
+
+    void operator()(uint16_t j)
+    {
+      const float dx = x[j] - px;
+      const float dy = y[j] - py;
+      const float d2 = dx * dx + dy * dy;
+      if (d2 < radiusSq)
+      {
+        (*visit)(j, dx, dy, d2);
+      }
+    }
+  };
+
+  uint16_t *cellOf_ = nullptr;
+  uint16_t *order_ = nullptr;
+  // MAX_NEIGHBOR_CELLS + 1 entries.
+  uint16_t *cellStart_ = nullptr;
+  uint16_t capacity_ = 0;
+  const float *x_ = nullptr;
+  const float *y_ = nullptr;
+  uint16_t count_ = 0;
+  uint8_t gridSize_ = 1;
+  bool valid_ = false;
+  uint32_t builds_ = 0;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PHASE2_NOISE_H
+#define PHASE2_NOISE_H
+
+#include <stdint.h>
+
+// 3D simplex noise on an integer hash (no tables, no sinf), in [-1, 1]. Continuous with a
+// bounded gradient, so animating z (time) moves the field smoothly instead of re-rolling it.
+namespace Noise
+{
+float simplex3(float x, float y, float z, uint32_t seed);
+// Batch form for a row of points sharing z: out[i] = simplex3(x[i], y[i], z, seed).
+// Four points per Simd::F4 iteration (masks and selects, integer-lane hashes), scalar for the
+// last count % 4; bit-identical to the scalar call. No alignment requirement.
+void simplex3(const float *x, const float *y, float z, float *out, uint16_t count, uint32_t seed);
+}
+
+#endif
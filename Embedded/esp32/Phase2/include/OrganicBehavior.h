@@ -1,14 +1,122 @@
 #ifndef PHASE2_ORGANIC_BEHAVIOR_H
 #define PHASE2_ORGANIC_BEHAVIOR_H
 
+#include "ParticleArena.h"
+#include "SimConfig.h"
 #include "SimCore.h"
 
+// SimConfig::organicBehavior values. The JS Fluid behavior is FluidFLIP here.
+enum OrganicMode : uint8_t
+{
+  ORGANIC_NONE = 0,
+  ORGANIC_SWARM = 1,
+  ORGANIC_CHAIN = 2,
+  ORGANIC_AUTOMATA = 3
+};
+
+// Upper bound of SimConfig::swarmNeighbors; sizes the per-query scratch.
+static constexpr uint8_t SWARM_MAX_NEIGHBORS = 24;
+// Link slots per particle, the upper bound of SimConfig::chainBranches.
+static constexpr uint8_t CHAIN_MAX_LINKS = 4;
+
+// Counters since the last consumeStats().
+struct OrganicStats
+{
+  uint32_t steps;
+  uint32_t particles;
+  // Neighbours that contributed to a force, summed over particles.
+  uint32_t neighbors;
+  uint32_t linksMade;
+  uint32_t linksBroken;
+};
+
+// Velocity-level behaviors ported from Sim/src/simulation/behaviors/organicBehavior.js and
+// forces/organicForces.js, applied once per frame after SimCore has stepped. Neighbours come
+// from SimCore::getNeighbors(), so the grid binned for collision is reused rather than rebuilt.
+//
+// Swarm (calculateSwarmForces): each particle steers toward the centroid and the mean heading of
+// its neighbours and away from the closest ones, each term a unit direction weighted by
+// swarmCohesion / swarmAlignment / swarmSeparation * 0.05, clamped to swarmMaxSpeed and damped
+// by 0.85, then added as velocity += force * dt. The JS takes every particle within
+// organicRadius; here a particle only sees its swarmNeighbors nearest, found by a ring query that
+// stops once they are known, so a dense flock costs about swarmNeighbors candidates per
+// particle and a step stays linear in particle count. All forces are gathered into SoA
+// columns before any velocity changes, as the alignment term reads the neighbours' velocities.
+//
+// Chain (calculateChainForces): particles link to their two nearest neighbours while both ends
+// have fewer than chainBranches links, and each link is a spring toward chainLinkDistance; with
+// chainAlignment, a particle holding two links is pushed sideways to straighten them. The JS
+// rebuilds every particle's links each frame. Here links persist in CHAIN_MAX_LINKS uint16 slots
+// per particle, stored on both ends: a frame drops the links stretched past organicRadius, tops
+// up particles with a free slot, and evaluates springs only over the links that exist. A
+// particle-count change drops all links, since removal reshuffles indices.
+//
+// Automata (automataRules.js, calculateAutomataForces): every particle carries a state; within
+// organicRadius, neighbours whose state differs by less than automataThreshold attract with
+// automataAttraction and the rest repel with automataRepulsion, both fading linearly to the
+// radius, each component clamped to 0.5 and scaled by 0.1 * 0.85. A state moves a tenth of the
+// way toward its neighbours' mean when the gap exceeds the threshold. The JS keeps float states
+// in a Map; here they are PARTICLE_STATE_BITS-wide levels packed into uint32 words, in two
+// buffers: a frame reads the front one and writes whole words of the back one, then swaps, so
+// the update needs no copy of the old states. One forEachPair() pass over the shared grid
+// gathers both the symmetric forces and each particle's neighbour count and state sum. A step
+// toward the mean moves at least one level. The front buffer is handed to
+// SimCore::setParticleStates(), so views and snapshots carry it as GridModes' Automata channel,
+// and SimCore's swap-removal moves a particle's level along with its columns.
 class OrganicBehavior
 {
 public:
+  explicit OrganicBehavior(SimConfig *cfg) : config_(cfg) {}
+
+  // Reserves the force columns and link slots for capacity particles; apply() is a no-op until
+  // this succeeds. Nothing is allocated after it.
+  bool begin(uint16_t capacity);
+  // Runs the behavior selected by SimConfig::organicBehavior.
+  void apply(SimCore &sim, float dt);
   void applySwarm(SimCore &sim, float dt);
   void applyChain(SimCore &sim, float dt);
   void applyAutomata(SimCore &sim, float dt);
+  // Drops every chain link.
+  void clearLinks();
+  uint8_t getLinkCount(uint16_t i) const { return linkCount_ ? linkCount_[i] : 0; }
+  const uint16_t *getLinks(uint16_t i) const { return links_ + (size_t)i * CHAIN_MAX_LINKS; }
+  // Current automata states, packed as in ParticleView.h; nullptr before begin().
+  const uint32_t *getStates() const { return states_[front_]; }
+  uint8_t getState(uint16_t i) const { return readParticleState(states_[front_], i); }
+  // Random states for particles [from, count), as the JS initializeStates().
+  void seedStates(uint16_t from, uint16_t count);
+  OrganicStats consumeStats();
+
+private:
+  bool isLinked(uint16_t i, uint16_t j) const;
+  void link(uint16_t i, uint16_t j);
+  // Removes j from i's slots (order is not kept).
+  void dropLink(uint16_t i, uint16_t j);
+  void updateLinks(SimCore &sim, uint8_t branches);
+  // velocity += force * dt over the first count particles.
+  void applyForces(SimCore &sim, uint16_t count, float dt);
+  // Writes the back buffer from the front one and the tallies, then swaps them.
+  void updateStates(uint16_t count);
+
+  SimConfig *config_;
+  ParticleArena arena_;
+  uint16_t capacity_ = 0;
+  float *forceX_ = nullptr;
+  float *forceY_ = nullptr;
+  // CHAIN_MAX_LINKS slots per particle; the first linkCount_[i] hold i's partners.
+  uint16_t *links_ = nullptr;
+  uint8_t *linkCount_ = nullptr;
+  // Particle count the links were made for, and the behavior of the previous apply().
+  uint16_t linkedCount_ = 0;
+  uint8_t lastMode_ = ORGANIC_NONE;
+  // Front and back automata state buffers, particleStateWords(capacity) words each.
+  uint32_t *states_[2] = {nullptr, nullptr};
+  uint8_t front_ = 0;
+  // Per particle: neighbour count in the low 14 bits, their state sum above.
+  uint32_t *tally_ = nullptr;
+  // Particles the states were seeded for.
+  uint16_t seededCount_ = 0;
+  OrganicStats stats_ = {};
 };
 
 #endif
@@ -0,0 +1,51 @@
+#ifndef PHASE2_PARTICLE_ARENA_H
+#define PHASE2_PARTICLE_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bump allocator for runtime-sized particle storage.
+// Both regions are reserved once in begin() and never freed; alloc() only carves them up.
+// HOT lives in internal DRAM; BULK uses PSRAM when the board has it, DRAM otherwise.
+enum ArenaRegion : uint8_t
+{
+  ARENA_HOT = 0,
+  ARENA_BULK = 1
+};
+
+static constexpr size_t ARENA_ALIGN = 16;
+
+struct ArenaBudget
+{
+  size_t hotBytes;
+  size_t hotUsed;
+  size_t bulkBytes;
+  size_t bulkUsed;
+  bool bulkInPsram;
+};
+
+class ParticleArena
+{
+public:
+  bool begin(size_t hotBytes, size_t bulkBytes);
+  bool isReady() const { return ready_; }
+
+  // Returns ARENA_ALIGN-aligned storage, or nullptr when the region is exhausted.
+  void *alloc(ArenaRegion region, size_t bytes);
+  size_t available(ArenaRegion region) const;
+  ArenaBudget getBudget() const;
+
+private:
+  struct Region
+  {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+  };
+
+  Region regions_[2] = {{nullptr, 0, 0}, {nullptr, 0, 0}};
+  bool bulkInPsram_ = false;
+  bool ready_ = false;
+};
+
+#endif
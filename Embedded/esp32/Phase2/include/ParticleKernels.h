@@ -0,0 +1,184 @@
+#ifndef PHASE2_PARTICLE_KERNELS_H
+#define PHASE2_PARTICLE_KERNELS_H
+
+#include "Boundary.h"
+#include "SimdF4.h"
+
+// Per-step constants for damping, velocity clamp and position integration.
+struct IntegrateParams
+{
+  float damping;
+  float vmax;
+  float vmax2;
+  float posScale;
+};
+
+// Array kernels over SoA particle columns. The vector versions process
+// Simd::paddedCount(count) lanes, so columns must be 16-byte aligned and padded.
+// The *Scalar versions are the per-particle reference used by the host check.
+namespace ParticleKernels
+{
+void integrate(const IntegrateParams &p, float *x, float *y, float *vx, float *vy, uint16_t count);
+void enforceBoundary(const BoundaryParams &p, float *x, float *y, float *vx, float *vy, uint16_t count);
+
+void integrateScalar(const IntegrateParams &p, float *x, float *y, float *vx, float *vy, uint16_t count);
+void enforceBoundaryScalar(const BoundaryParams &p, float *x, float *y, float *vx, float *vy, uint16_t count);
+
+// Lane-level building blocks, inlined into the fused SimCore pass.
+inline void integrateLanes(const IntegrateParams &p, Simd::F4 &px, Simd::F4 &py, Simd::F4 &vx, Simd::F4 &vy)
+{
+  using namespace Simd;
+  const F4 damping = set1(p.damping);
+  vx = mul(vx, damping);
+  vy = mul(vy, damping);
+  const F4 v2 = add(mul(vx, vx), mul(vy, vy));
+  const M4 over = gt(v2, set1(p.vmax2));
+  if (any(over))
+  {
+    const F4 inv = div(set1(p.vmax), sqrt(max(v2, set1(1e-20f))));
+    vx = select(over, mul(vx, inv), vx);
+    vy = select(over, mul(vy, inv), vy);
+  }
+  const F4 posScale = set1(p.posScale);
+  px = add(px, mul(vx, posScale));
+  py = add(py, mul(vy, posScale));
+}
+
+inline void enforceBoundaryLanes(const BoundaryParams &p, Simd::F4 &px, Simd::F4 &py, Simd::F4 &vx, Simd::F4 &vy)
+{
+  using namespace Simd;
+  if (p.field)
+  {
+    // Table lookups are a gather; round-trip the four lanes through the stack.
+    alignas(16) float lx[SIMD_WIDTH];
+    alignas(16) float ly[SIMD_WIDTH];
+    alignas(16) float lvx[SIMD_WIDTH];
+    alignas(16) float lvy[SIMD_WIDTH];
+    store(lx, px);
+    store(ly, py);
+    store(lvx, vx);
+    store(lvy, vy);
+    for (uint8_t l = 0; l < SIMD_WIDTH; ++l)
+    {
+      Boundary::enforce(p, lx[l], ly[l], lvx[l], lvy[l]);
+    }
+    px = load(lx);
+    py = load(ly);
+    vx = load(lvx);
+    vy = load(lvy);
+    return;
+  }
+  const F4 zero = set1(0.0f);
+  const F4 one = set1(1.0f);
+  if (p.shape == BOUNDARY_RECTANGULAR)
+  {
+    const M4 lowX = lt(px, zero);
+    const M4 highX = gt(px, one);
+    const M4 lowY = lt(py, zero);
+    const M4 highY = gt(py, one);
+    const M4 outX = orMask(lowX, highX);
+    const M4 outY = orMask(lowY, highY);
+    if (p.mode == 0)
+    {
+      const F4 bounce = set1(-p.bounce);
+      const F4 friction = set1(p.friction);
+      const M4 movingX = orMask(andMask(lowX, lt(vx, zero)), andMask(highX, gt(vx, zero)));
+      vx = select(movingX, mul(vx, bounce), vx);
+      vy = select(outX, mul(vy, friction), vy);
+      const M4 movingY = orMask(andMask(lowY, lt(vy, zero)), andMask(highY, gt(vy, zero)));
+      vy = select(movingY, mul(vy, bounce), vy);
+      vx = select(outY, mul(vx, friction), vx);
+      if (p.repulsion > 0.0f)
+      {
+        const F4 zone = set1(p.zone);
+        const F4 far = set1(1.0f - p.zone);
+        const M4 near = orMask(orMask(lt(px, zone), gt(px, far)), orMask(lt(py, zone), gt(py, far)));
+        if (any(near))
+        {
+          // Zone kicks are per wall; round-trip the lanes that did not touch one.
+          alignas(16) float lx[SIMD_WIDTH];
+          alignas(16) float ly[SIMD_WIDTH];
+          alignas(16) float lvx[SIMD_WIDTH];
+          alignas(16) float lvy[SIMD_WIDTH];
+          alignas(16) float lout[SIMD_WIDTH];
+          store(lx, px);
+          store(ly, py);
+          store(lvx, vx);
+          store(lvy, vy);
+          store(lout, select(orMask(outX, outY), one, zero));
+          for (uint8_t l = 0; l < SIMD_WIDTH; ++l)
+          {
+            if (lout[l] == 0.0f)
+            {
+              Boundary::repelRect(p, lx[l], ly[l], lvx[l], lvy[l]);
+            }
+          }
+          vx = load(lvx);
+          vy = load(lvy);
+        }
+      }
+      px = min(max(px, zero), one);
+      py = min(max(py, zero), one);
+    }
+    else
+    {
+      px = select(lowX, one, select(highX, zero, px));
+      py = select(lowY, one, select(highY, zero, py));
+    }
+    return;
+  }
+
+  const F4 center = set1(0.5f);
+  const F4 dx = sub(px, center);
+  const F4 dy = sub(py, center);
+  const F4 d2 = add(mul(dx, dx), mul(dy, dy));
+  const M4 outside = gt(d2, set1(p.radiusSq));
+  if (p.repulsion > 0.0f && any(gt(d2, set1(p.innerSq))))
+  {
+    // Table lookups are a gather; only lanes inside the zone ever get here.
+    alignas(16) float ldx[SIMD_WIDTH];
+    alignas(16) float ldy[SIMD_WIDTH];
+    alignas(16) float ld2[SIMD_WIDTH];
+    alignas(16) float lvx[SIMD_WIDTH];
+    alignas(16) float lvy[SIMD_WIDTH];
+    store(ldx, dx);
+    store(ldy, dy);
+    store(ld2, d2);
+    store(lvx, vx);
+    store(lvy, vy);
+    for (uint8_t l = 0; l < SIMD_WIDTH; ++l)
+    {
+      if (ld2[l] <= p.radiusSq)
+      {
+        Boundary::repelCircle(p, ldx[l], ldy[l], ld2[l], lvx[l], lvy[l]);
+      }
+    }
+    vx = load(lvx);
+    vy = load(lvy);
+  }
+  if (!any(outside))
+  {
+    return;
+  }
+  if (p.mode == 1)
+  {
+    px = select(outside, sub(center, dx), px);
+    py = select(outside, sub(center, dy), py);
+    return;
+  }
+
+  const F4 dist = sqrt(max(d2, set1(1e-20f)));
+  const F4 nx = div(dx, dist);
+  const F4 ny = div(dy, dist);
+  const F4 radius = set1(p.radius);
+  const F4 friction = set1(p.friction);
+  const F4 dot = add(mul(vx, nx), mul(vy, ny));
+  const F4 vn = select(gt(dot, zero), mul(dot, set1(-p.bounce)), dot);
+  px = select(outside, add(center, mul(nx, radius)), px);
+  py = select(outside, add(center, mul(ny, radius)), py);
+  vx = select(outside, add(mul(nx, vn), mul(sub(vx, mul(dot, nx)), friction)), vx);
+  vy = select(outside, add(mul(ny, vn), mul(sub(vy, mul(dot, ny)), friction)), vy);
+}
+}
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PHASE2_PARTICLE_VIEW_H
+#define PHASE2_PARTICLE_VIEW_H
+
+#include <stdint.h>
+
+class NeighborGrid;
+
+// Per-particle automata states (see OrganicBehavior.h), PARTICLE_STATE_BITS each, packed into
+// uint32 words with particle i in bits (i % PARTICLE_STATES_PER_WORD) * PARTICLE_STATE_BITS.
+static constexpr uint8_t PARTICLE_STATE_BITS = 4;
+static constexpr uint8_t PARTICLE_STATE_MAX = (1u << PARTICLE_STATE_BITS) - 1;
+static constexpr uint8_t PARTICLE_STATES_PER_WORD = 32 / PARTICLE_STATE_BITS;
+
+static inline uint16_t particleStateWords(uint16_t count)
+{
+  return (uint16_t)((count + PARTICLE_STATES_PER_WORD - 1) / PARTICLE_STATES_PER_WORD);
+}
+
+static inline uint8_t readParticleState(const uint32_t *words, uint16_t i)
+{
+  return (uint8_t)((words[i / PARTICLE_STATES_PER_WORD] >> ((i % PARTICLE_STATES_PER_WORD) * PARTICLE_STATE_BITS)) &
+                   PARTICLE_STATE_MAX);
+}
+
+static inline void writeParticleState(uint32_t *words, uint16_t i, uint8_t state)
+{
+  const uint8_t shift = (uint8_t)((i % PARTICLE_STATES_PER_WORD) * PARTICLE_STATE_BITS);
+  uint32_t &word = words[i / PARTICLE_STATES_PER_WORD];
+  word = (word & ~((uint32_t)PARTICLE_STATE_MAX << shift)) | ((uint32_t)(state & PARTICLE_STATE_MAX) << shift);
+}
+
+// Read-only window onto particle columns: either live SimCore state or a
+// published SnapshotBuffer slot. Consumers (GridModes, validation) only see this.
+// getRadius() is nullptr while every particle has SimConfig::particleRadius; getNeighbors() is
+// the sim's neighbor grid when it bins exactly these columns, nullptr otherwise (snapshots).
+// getStates() is the packed automata state channel, nullptr unless that behavior is running.
+class ParticleView
+{
+public:
+  ParticleView() = default;
+  ParticleView(const float *x, const float *y, const float *vx, const float *vy, uint16_t count,
+               const float *radius = nullptr, const NeighborGrid *neighbors = nullptr, const uint32_t *states = nullptr)
+      : x_(x), y_(y), vx_(vx), vy_(vy), radius_(radius), neighbors_(neighbors), states_(states), count_(count)
+  {
+  }
+
+  uint16_t getCount() const { return count_; }
+  const float *getX() const { return x_; }
+  const float *getY() const { return y_; }
+  const float *getVx() const { return vx_; }
+  const float *getVy() const { return vy_; }
+  const float *getRadius() const { return radius_; }
+  const NeighborGrid *getNeighbors() const { return neighbors_; }
+  const uint32_t *getStates() const { return states_; }
+
+private:
+  const float *x_ = nullptr;
+  const float *y_ = nullptr;
+  const float *vx_ = nullptr;
+  const float *vy_ = nullptr;
+  const float *radius_ = nullptr;
+  const NeighborGrid *neighbors_ = nullptr;
+  const uint32_t *states_ = nullptr;
+  uint16_t count_ = 0;
+};
+
+#endif
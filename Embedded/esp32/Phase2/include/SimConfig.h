@@ -4,6 +4,20 @@
 #include <Arduino.h>
 #include <stddef.h>
 
+// Particle storage capacity, set per board in platformio.ini.
+#ifndef SIM_PARTICLE_CAPACITY
+#define SIM_PARTICLE_CAPACITY 300
+#endif
+
+// Collision workers, caller included (WorkerPool): one per core on device.
+#ifndef SIM_MAX_POOL_WORKERS
+#if SIM_NATIVE
+#define SIM_MAX_POOL_WORKERS 4
+#else
+#define SIM_MAX_POOL_WORKERS 2
+#endif
+#endif
+
 enum ParamType : uint8_t
 {
   PARAM_UINT8,
@@ -20,11 +34,25 @@ struct SimConfig
   float velocityDamping = 0.995f;
   float maxVelocity = 2.0f;
   uint16_t particleCount = 50;
+  // Read once by SimCore::init() to size the particle arena; later changes need a reboot.
+  uint16_t particleCapacity = SIM_PARTICLE_CAPACITY;
   float particleRadius = 0.03f;
   float restDensity = 2.0f;
   float picFlipRatio = 0.0f;
+  // Pressure sweeps per step at most; stops early once the residual is below fluidTolerance
+  // of the divergence the solve started from.
+  uint8_t fluidIterations = 40;
+  float fluidTolerance = 0.05f;
+  // Single-pass particle update; off selects the staged path for A/B comparison.
+  bool fusedStep = true;
+  // Each frame is split so no particle moves more than substepCfl * particleRadius (the
+  // smallest radius with per-particle sizes) per substep; 1.0 keeps the fastest particle
+  // from skipping past a neighbour's diameter.
+  float substepCfl = 1.0f;
+  uint8_t maxSubsteps = 4;
 
   uint8_t boundaryMode = 0;
+  // 0 circle, 1 rectangle, 2 rounded rectangle, 3 half circle (see Boundary.h).
   uint8_t boundaryShape = 0;
   float boundaryScale = 1.03f;
   float boundaryDamping = 0.8f;
@@ -37,9 +65,18 @@ struct SimConfig
 
   bool collisionEnabled = true;
   uint8_t collisionGridSize = 8;
+  // Size collision cells from particleRadius and count instead of collisionGridSize.
+  bool collisionGridAuto = true;
   float collisionRepulsion = 0.5f;
   float particleRestitution = 0.8f;
   float collisionDamping = 0.98f;
+  // Verlet skin as a multiple of particleRadius; 0 rebuilds the collision grid every step.
+  float collisionSkin = 0.5f;
+  // Relaxation passes per step; stops early once corrections fall below collisionTolerance diameters.
+  uint8_t collisionIterations = 4;
+  float collisionTolerance = 0.01f;
+  // Workers for the collision passes (caller included), 1..SIM_MAX_POOL_WORKERS.
+  uint8_t collisionThreads = 1;
 
   uint8_t gridMode = 1;
   // Keep idle output darker; touch/forces should drive highlights.
@@ -77,7 +114,8 @@ struct SimConfig
   float turbPullFactor = 1.0f;
   bool turbAffectPosition = false;
   bool turbScaleField = false;
-  bool turbAffectScale = true;
+  // Per-particle radii from the turbulence size field (see SimCore::hasParticleSizes()).
+  bool turbAffectScale = false;
   float turbMinScale = 0.008f;
   float turbMaxScale = 0.03f;
   uint8_t turbPatternStyle = 0;
@@ -94,6 +132,43 @@ struct SimConfig
   float turbPhase = 0.0f;
   float turbPhaseSpeed = -1.0f;
   float turbBlurAmount = 0.8f;
+  // Bakes per second of the turbulence field (see TurbulenceField).
+  float turbFieldRate = 20.0f;
+  // Share of the previous field that survives each timeStep (0 = every bake replaces it).
+  float turbFieldPersistence = 0.0f;
+
+  // Voronoi edge field (see Voronoi.h); off by default like turbulence.
+  float voronoiStrength = 0.0f;
+  float voronoiEdgeWidth = 0.3f;
+  float voronoiAttraction = 1.0f;
+  // Seeds, 2..VORONOI_MAX_SEEDS; the jump-flood cost does not depend on it.
+  uint8_t voronoiCellCount = 10;
+  float voronoiCellSpeed = 0.2f;
+  float voronoiDecayRate = 0.99f;
+  float voronoiBlend = 0.7f;
+  bool voronoiPullMode = false;
+
+  // Organic behaviors (see OrganicBehavior.h): 0 none, 1 swarm, 2 chain, 3 automata.
+  uint8_t organicBehavior = 0;
+  // Neighbourhood radius in [0,1] units; the JS's 30 px on its 240 px canvas.
+  float organicRadius = 0.125f;
+  float swarmCohesion = 1.0f;
+  float swarmAlignment = 0.7f;
+  float swarmSeparation = 1.2f;
+  // Cap on the steering force magnitude (the JS's Swarm maxSpeed).
+  float swarmMaxSpeed = 0.5f;
+  // Nearest neighbours a particle steers by, 1..SWARM_MAX_NEIGHBORS.
+  uint8_t swarmNeighbors = 12;
+  // Spring rest length in [0,1] units (the JS's linkDistance, 0 px by default).
+  float chainLinkDistance = 0.0f;
+  float chainLinkStrength = 10.0f;
+  float chainAlignment = 0.5f;
+  // Links per particle, 1..CHAIN_MAX_LINKS; 2 makes strands (the JS's branchProb).
+  uint8_t chainBranches = 2;
+  float automataRepulsion = 0.8f;
+  float automataAttraction = 0.5f;
+  // State gap in [0,1] below which neighbours attract and above which states converge.
+  float automataThreshold = 0.2f;
 
   // Placeholders for future particle rendering path on ESP32.
   bool particleColorWhite = true;
@@ -117,13 +192,18 @@ static const ParamDef kParamRegistry[] = {
     {50, "Time Scale", "Simulation", PARAM_FLOAT, 0.1f, 8.0f, 0.01f, (uint16_t)offsetof(SimConfig, timeScale)},
     {51, "Velocity Damping", "Simulation", PARAM_FLOAT, 0.8f, 1.0f, 0.001f, (uint16_t)offsetof(SimConfig, velocityDamping)},
     {52, "Max Velocity", "Simulation", PARAM_FLOAT, 0.1f, 8.0f, 0.1f, (uint16_t)offsetof(SimConfig, maxVelocity)},
-    {53, "Particle Count", "Simulation", PARAM_UINT16, 2.0f, 200.0f, 1.0f, (uint16_t)offsetof(SimConfig, particleCount)},
+    {53, "Particle Count", "Simulation", PARAM_UINT16, 2.0f, (float)SIM_PARTICLE_CAPACITY, 1.0f, (uint16_t)offsetof(SimConfig, particleCount)},
     {55, "Particle Radius", "Simulation", PARAM_FLOAT, 0.002f, 0.15f, 0.001f, (uint16_t)offsetof(SimConfig, particleRadius)},
     {56, "Rest Density", "Simulation", PARAM_FLOAT, 0.0f, 40.0f, 0.1f, (uint16_t)offsetof(SimConfig, restDensity)},
     {57, "PicFlipRatio", "Simulation", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, picFlipRatio)},
+    {58, "Fused Step", "Simulation", PARAM_BOOL, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, fusedStep)},
+    {59, "Substep CFL", "Simulation", PARAM_FLOAT, 0.1f, 2.0f, 0.05f, (uint16_t)offsetof(SimConfig, substepCfl)},
+    {60, "Max Substeps", "Simulation", PARAM_UINT8, 1.0f, 16.0f, 1.0f, (uint16_t)offsetof(SimConfig, maxSubsteps)},
+    {61, "Fluid Iterations", "Simulation", PARAM_UINT8, 1.0f, 100.0f, 1.0f, (uint16_t)offsetof(SimConfig, fluidIterations)},
+    {62, "Fluid Tolerance", "Simulation", PARAM_FLOAT, 0.0f, 0.5f, 0.01f, (uint16_t)offsetof(SimConfig, fluidTolerance)},
 
     {70, "Boundary Mode", "Boundary", PARAM_UINT8, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, boundaryMode)},
-    {71, "Boundary Shape", "Boundary", PARAM_UINT8, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, boundaryShape)},
+    {71, "Boundary Shape", "Boundary", PARAM_UINT8, 0.0f, 3.0f, 1.0f, (uint16_t)offsetof(SimConfig, boundaryShape)},
     {72, "Boundary Scale", "Boundary", PARAM_FLOAT, 0.6f, 1.2f, 0.01f, (uint16_t)offsetof(SimConfig, boundaryScale)},
     {73, "Boundary Damping", "Boundary", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, boundaryDamping)},
     {74, "Boundary Restitution", "Boundary", PARAM_FLOAT, 0.0f, 1.0f, 0.05f, (uint16_t)offsetof(SimConfig, boundaryRestitution)},
@@ -138,6 +218,11 @@ static const ParamDef kParamRegistry[] = {
     {92, "Collision Repulsion", "Collision", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, collisionRepulsion)},
     {93, "Particle Restitution", "Collision", PARAM_FLOAT, 0.0f, 1.0f, 0.05f, (uint16_t)offsetof(SimConfig, particleRestitution)},
     {94, "Collision Damping", "Collision", PARAM_FLOAT, 0.8f, 1.0f, 0.001f, (uint16_t)offsetof(SimConfig, collisionDamping)},
+    {95, "Collision Skin", "Collision", PARAM_FLOAT, 0.0f, 2.0f, 0.05f, (uint16_t)offsetof(SimConfig, collisionSkin)},
+    {96, "Collision Iterations", "Collision", PARAM_UINT8, 1.0f, 8.0f, 1.0f, (uint16_t)offsetof(SimConfig, collisionIterations)},
+    {97, "Collision Tolerance", "Collision", PARAM_FLOAT, 0.0f, 0.2f, 0.005f, (uint16_t)offsetof(SimConfig, collisionTolerance)},
+    {98, "Collision Threads", "Collision", PARAM_UINT8, 1.0f, (float)SIM_MAX_POOL_WORKERS, 1.0f, (uint16_t)offsetof(SimConfig, collisionThreads)},
+    {99, "Collision Grid Auto", "Collision", PARAM_BOOL, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, collisionGridAuto)},
 
     {100, "Turb Strength", "Turbulence", PARAM_FLOAT, 0.0f, 20.0f, 0.5f, (uint16_t)offsetof(SimConfig, turbStrength)},
     {101, "Turb Rotation", "Turbulence", PARAM_FLOAT, 0.0f, 6.2831853f, 0.01f, (uint16_t)offsetof(SimConfig, turbRotation)},
@@ -148,7 +233,7 @@ static const ParamDef kParamRegistry[] = {
     {106, "Turb Affect Scale", "Turbulence", PARAM_BOOL, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, turbAffectScale)},
     {107, "Turb Min Scale", "Turbulence", PARAM_FLOAT, 0.005f, 0.015f, 0.001f, (uint16_t)offsetof(SimConfig, turbMinScale)},
     {108, "Turb Max Scale", "Turbulence", PARAM_FLOAT, 0.015f, 0.03f, 0.001f, (uint16_t)offsetof(SimConfig, turbMaxScale)},
-    {109, "Turb Pattern Style", "Turbulence", PARAM_UINT8, 0.0f, 14.0f, 1.0f, (uint16_t)offsetof(SimConfig, turbPatternStyle)},
+    {109, "Turb Pattern Style", "Turbulence", PARAM_UINT8, 0.0f, 15.0f, 1.0f, (uint16_t)offsetof(SimConfig, turbPatternStyle)},
     {110, "Turb Decay Rate", "Turbulence", PARAM_FLOAT, 0.9f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, turbDecayRate)},
     {111, "Turb Direction Bias X", "Turbulence", PARAM_FLOAT, -1.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, turbDirectionBiasX)},
     {112, "Turb Direction Bias Y", "Turbulence", PARAM_FLOAT, -1.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, turbDirectionBiasY)},
@@ -168,7 +253,7 @@ static const ParamDef kParamRegistry[] = {
     {130, "IMU Sensitivity", "IMU", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, imuSensitivity)},
     {131, "IMU Smoothing", "IMU", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, imuSmoothing)},
     {132, "IMU Enabled", "IMU", PARAM_BOOL, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, imuEnabled)},
-    {140, "Grid Mode", "Rendering", PARAM_UINT8, 0.0f, 8.0f, 1.0f, (uint16_t)offsetof(SimConfig, gridMode)},
+    {140, "Grid Mode", "Rendering", PARAM_UINT8, 0.0f, 9.0f, 1.0f, (uint16_t)offsetof(SimConfig, gridMode)},
     {141, "Max Density", "Rendering", PARAM_FLOAT, 0.1f, 8.0f, 0.01f, (uint16_t)offsetof(SimConfig, maxDensity)},
     {142, "Smooth In", "Rendering", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, smoothRateIn)},
     {143, "Smooth Out", "Rendering", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, smoothRateOut)},
@@ -188,6 +273,32 @@ static const ParamDef kParamRegistry[] = {
     {157, "Turb Phase", "Turbulence", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, turbPhase)},
     {158, "Turb Phase Speed", "Turbulence", PARAM_FLOAT, -1.0f, 1.0f, 0.1f, (uint16_t)offsetof(SimConfig, turbPhaseSpeed)},
     {159, "Turb Blur Amount", "Turbulence", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, turbBlurAmount)},
+    {162, "Turb Field Rate", "Turbulence", PARAM_FLOAT, 1.0f, 60.0f, 1.0f, (uint16_t)offsetof(SimConfig, turbFieldRate)},
+    {163, "Turb Field Persistence", "Turbulence", PARAM_FLOAT, 0.0f, 0.99f, 0.01f, (uint16_t)offsetof(SimConfig, turbFieldPersistence)},
+
+    {190, "Organic Behavior", "Organic", PARAM_UINT8, 0.0f, 3.0f, 1.0f, (uint16_t)offsetof(SimConfig, organicBehavior)},
+    {191, "Organic Radius", "Organic", PARAM_FLOAT, 0.02f, 0.4f, 0.005f, (uint16_t)offsetof(SimConfig, organicRadius)},
+    {192, "Swarm Cohesion", "Organic", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, swarmCohesion)},
+    {193, "Swarm Alignment", "Organic", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, swarmAlignment)},
+    {194, "Swarm Separation", "Organic", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, swarmSeparation)},
+    {195, "Swarm Max Speed", "Organic", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, swarmMaxSpeed)},
+    {196, "Swarm Neighbors", "Organic", PARAM_UINT8, 1.0f, 24.0f, 1.0f, (uint16_t)offsetof(SimConfig, swarmNeighbors)},
+    {200, "Chain Link Distance", "Organic", PARAM_FLOAT, 0.0f, 0.2f, 0.001f, (uint16_t)offsetof(SimConfig, chainLinkDistance)},
+    {201, "Chain Link Strength", "Organic", PARAM_FLOAT, 0.0f, 10.0f, 0.1f, (uint16_t)offsetof(SimConfig, chainLinkStrength)},
+    {202, "Chain Alignment", "Organic", PARAM_FLOAT, 0.0f, 10.0f, 0.1f, (uint16_t)offsetof(SimConfig, chainAlignment)},
+    {203, "Chain Branches", "Organic", PARAM_UINT8, 1.0f, 4.0f, 1.0f, (uint16_t)offsetof(SimConfig, chainBranches)},
+    {205, "Automata Repulsion", "Organic", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, automataRepulsion)},
+    {206, "Automata Attraction", "Organic", PARAM_FLOAT, 0.0f, 2.0f, 0.01f, (uint16_t)offsetof(SimConfig, automataAttraction)},
+    {207, "Automata Threshold", "Organic", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, automataThreshold)},
+
+    {210, "Voronoi Strength", "Voronoi", PARAM_FLOAT, 0.0f, 10.0f, 0.1f, (uint16_t)offsetof(SimConfig, voronoiStrength)},
+    {211, "Voronoi Edge Width", "Voronoi", PARAM_FLOAT, 0.01f, 3.0f, 0.01f, (uint16_t)offsetof(SimConfig, voronoiEdgeWidth)},
+    {212, "Voronoi Attraction", "Voronoi", PARAM_FLOAT, 0.0f, 8.0f, 0.1f, (uint16_t)offsetof(SimConfig, voronoiAttraction)},
+    {213, "Voronoi Cell Count", "Voronoi", PARAM_UINT8, 2.0f, 64.0f, 1.0f, (uint16_t)offsetof(SimConfig, voronoiCellCount)},
+    {214, "Voronoi Cell Speed", "Voronoi", PARAM_FLOAT, 0.0f, 4.0f, 0.01f, (uint16_t)offsetof(SimConfig, voronoiCellSpeed)},
+    {215, "Voronoi Decay Rate", "Voronoi", PARAM_FLOAT, 0.1f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, voronoiDecayRate)},
+    {216, "Voronoi Blend", "Voronoi", PARAM_FLOAT, 0.0f, 1.0f, 0.01f, (uint16_t)offsetof(SimConfig, voronoiBlend)},
+    {217, "Voronoi Pull Mode", "Voronoi", PARAM_BOOL, 0.0f, 1.0f, 1.0f, (uint16_t)offsetof(SimConfig, voronoiPullMode)},
 };
 
 static constexpr size_t kParamRegistryCount = sizeof(kParamRegistry) / sizeof(kParamRegistry[0]);
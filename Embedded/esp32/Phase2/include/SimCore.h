@@ -3,38 +3,118 @@
 
 #include "Boundary.h"
 #include "Collision.h"
+#include "FluidFLIP.h"
+#include "NeighborGrid.h"
+#include "ParticleArena.h"
+#include "ParticleKernels.h"
+#include "ParticleView.h"
 #include "SimConfig.h"
 #include "Turbulence.h"
+#include "Voronoi.h"
+
+// Hard ceiling for SimConfig::particleCapacity (collision cells store int16 indices).
+static constexpr uint16_t MAX_PARTICLE_CAPACITY = 8192;
+// Internal DRAM reserved for the hottest particle columns and, if they fit, the neighbor
+// grid and collision index arrays; the rest goes to PSRAM.
+static constexpr size_t SIM_HOT_ARENA_BYTES = 32 * 1024;
+// Live particle-count changes spawn into the emptiest cell of a SPAWN_GRID^2 histogram.
+static constexpr uint8_t SPAWN_GRID = 32;
+static constexpr uint8_t SPAWN_CANDIDATES = 6;
 
 class SimCore
 {
 public:
   explicit SimCore(SimConfig *cfg);
   void init();
+  // Dispatches to stepFused() or stepStaged() per SimConfig::fusedStep.
   void step(float dt, float timeSec);
+  void stepStaged(float dt, float timeSec);
+  void stepFused(float dt, float timeSec);
+
+  // Stages of stepStaged(), in call order. Public so the host benchmark can time them individually.
+  void syncCount();
+  void applyGravity(float dt);
+  void applyTurbulence(float dt, float timeSec);
+  // Voronoi edge field; a no-op while voronoiStrength is 0.
+  void applyVoronoi(float dt);
+  // PIC/FLIP pass; a no-op while picFlipRatio is 0.
+  void applyFluid(float dt);
+  void resolveCollisions();
+  void integrate(float dt);
+
+  // Swap-remove: the last particle moves into index. O(1), no respawn.
+  void removeParticle(uint16_t index);
 
   void addForceAtPoint(float x, float y, float radius, float strength, bool repulse);
   void setGravity(float gx, float gy);
 
+  // Largest particle speed, used by SubstepScheduler to pick the substep count.
+  float getMaxSpeed() const;
+  // Smallest radius a particle can have right now (CFL limit for the substeps).
+  float getMinRadius() const;
+  // Per-particle radius / mass columns are live while turbAffectScale is on; otherwise
+  // every particle has particleRadius and unit mass and getRadius() returns nullptr.
+  bool hasParticleSizes() const { return sizesActive_; }
   uint16_t getCount() const { return count_; }
+  uint16_t getCapacity() const { return capacity_; }
+  ArenaBudget getMemoryBudget() const { return arena_.getBudget(); }
+  CollisionStats consumeCollisionStats() { return collision_.consumeStats(); }
+  FluidStats consumeFluidStats() { return fluid_.consumeStats(); }
+  VoronoiStats consumeVoronoiStats() { return voronoi_.consumeStats(); }
+  const Voronoi &getVoronoi() const { return voronoi_; }
+  // The shared neighbor grid over the current positions, binned on first use since they last
+  // moved: one build serves collision, the organic behaviors after the frame and GridModes.
+  const NeighborGrid &getNeighbors();
   const float *getX() const { return x_; }
   const float *getY() const { return y_; }
   const float *getVx() const { return vx_; }
   const float *getVy() const { return vy_; }
+  const float *getRadius() const { return sizesActive_ ? radius_ : nullptr; }
+  const float *getMass() const { return sizesActive_ ? mass_ : nullptr; }
+  // Carries the neighbor grid while it still matches the positions, and the state channel.
+  ParticleView getView() const
+  {
+    return ParticleView(x_, y_, vx_, vy_, count_, getRadius(), neighbors_.matches(x_, y_, count_) ? &neighbors_ : nullptr,
+                        states_);
+  }
+  // Packed per-particle states (ParticleView.h) owned by OrganicBehavior, passed on to views and
+  // snapshots for GridModes; nullptr when no behavior publishes any. Removal moves them with
+  // the particles, like the size columns.
+  void setParticleStates(uint32_t *states) { states_ = states; }
   float *mutableVx() { return vx_; }
   float *mutableVy() { return vy_; }
 
 private:
+  bool allocateStorage();
+  IntegrateParams getIntegrateParams(float dt) const;
+  void spawnParticles(uint16_t target);
+  void retireParticles(uint16_t target);
+  uint16_t spawnCell(float x, float y) const;
+  void resetSizes(uint16_t begin, uint16_t end);
+  // Radius from the turbulence size field, mass proportional to area (1 at particleRadius).
+  void updateSizes(const TurbulenceFrame &turb, uint16_t begin, uint16_t end);
+
   SimConfig *config_;
   Boundary boundary_;
   Collision collision_;
+  NeighborGrid neighbors_;
   Turbulence turbulence_;
+  Voronoi voronoi_;
+  FluidFLIP fluid_;
 
-  float x_[MAX_PARTICLES];
-  float y_[MAX_PARTICLES];
-  float vx_[MAX_PARTICLES];
-  float vy_[MAX_PARTICLES];
+  ParticleArena arena_;
+  // Columns are padded to SIMD_WIDTH floats; lanes past count_ hold stale but finite data.
+  float *x_ = nullptr;
+  float *y_ = nullptr;
+  float *vx_ = nullptr;
+  float *vy_ = nullptr;
+  float *radius_ = nullptr;
+  float *mass_ = nullptr;
+  bool sizesActive_ = false;
+  uint32_t *states_ = nullptr;
   uint16_t count_ = 0;
+  uint16_t capacity_ = 0;
+  bool storageFailed_ = false;
 };
 
 #endif
@@ -0,0 +1,56 @@
+#ifndef PHASE2_SIM_TASK_H
+#define PHASE2_SIM_TASK_H
+
+#include <atomic>
+
+#include "SimCore.h"
+#include "SnapshotBuffer.h"
+#include "SubstepScheduler.h"
+
+#if SIM_NATIVE
+#include <thread>
+#endif
+
+// Runs the fixed-rate simulation loop on its own core (FreeRTOS task on device,
+// std::thread on host) and publishes every frame into a SnapshotBuffer.
+// The scheduler decides how many frames are due; stepFn does one frame of work
+// (inputs, SubstepScheduler::runFrame, advanced blocks) at the given sim time.
+typedef void (*SimStepFn)(float nowSec);
+
+class SimTask
+{
+public:
+  bool start(SimCore *sim, SnapshotBuffer *snapshot, SubstepScheduler *scheduler, SimStepFn stepFn, uint8_t core);
+  void stop();
+  bool isRunning() const { return running_.load(std::memory_order_relaxed); }
+
+  // Re-runs SimCore::init() on the sim task before its next step.
+  void requestRestart() { restartRequested_.store(true, std::memory_order_relaxed); }
+
+  // Scheduler counters since the previous call (for the FPS log). Safe from any core.
+  SchedulerStats consumeStats();
+
+private:
+  static void taskEntry(void *arg);
+  void run();
+
+  SimCore *sim_ = nullptr;
+  SnapshotBuffer *snapshot_ = nullptr;
+  SubstepScheduler *scheduler_ = nullptr;
+  SimStepFn stepFn_ = nullptr;
+  uint32_t frame_ = 0;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> stopRequested_{false};
+  std::atomic<bool> restartRequested_{false};
+  std::atomic<uint32_t> frames_{0};
+  std::atomic<uint32_t> substeps_{0};
+  std::atomic<uint32_t> droppedUs_{0};
+  std::atomic<uint8_t> lastSubsteps_{1};
+#if SIM_NATIVE
+  std::thread thread_;
+#else
+  TaskHandle_t handle_ = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,217 @@
+#ifndef PHASE2_SIMD_F4_H
+#define PHASE2_SIMD_F4_H
+
+#include <math.h>
+#include <stdint.h>
+
+// 4-wide float vector used by the particle kernels.
+// Backends: SSE2 and NEON on host, unrolled scalar everywhere else. The ESP32-S3 PIE
+// unit only has integer lanes, so on device the scalar backend lets GCC keep four
+// independent FPU chains in flight. SIMD_FORCE_SCALAR=1 selects it on host too.
+// Loads and stores require 16-byte alignment; particle columns are padded to SIMD_WIDTH.
+// loadu / storeu take any float pointer. I4 holds four uint32 lanes for integer hashing
+// (Noise.cpp); muli is a 32-bit wrapping multiply.
+
+#if !SIMD_FORCE_SCALAR && defined(__SSE2__)
+#define SIMD_BACKEND_SSE 1
+#include <emmintrin.h>
+#elif !SIMD_FORCE_SCALAR && defined(__ARM_NEON) && defined(__aarch64__)
+#define SIMD_BACKEND_NEON 1
+#include <arm_neon.h>
+#else
+#define SIMD_BACKEND_SCALAR 1
+#endif
+
+static constexpr uint8_t SIMD_WIDTH = 4;
+
+namespace Simd
+{
+#if SIMD_BACKEND_SSE
+
+struct F4
+{
+  __m128 v;
+};
+struct M4
+{
+  __m128 v;
+};
+
+inline F4 load(const float *p) { return {_mm_load_ps(p)}; }
+inline void store(float *p, F4 a) { _mm_store_ps(p, a.v); }
+inline F4 set1(float s) { return {_mm_set1_ps(s)}; }
+inline F4 add(F4 a, F4 b) { return {_mm_add_ps(a.v, b.v)}; }
+inline F4 sub(F4 a, F4 b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline F4 mul(F4 a, F4 b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline F4 div(F4 a, F4 b) { return {_mm_div_ps(a.v, b.v)}; }
+inline F4 min(F4 a, F4 b) { return {_mm_min_ps(a.v, b.v)}; }
+inline F4 max(F4 a, F4 b) { return {_mm_max_ps(a.v, b.v)}; }
+inline F4 sqrt(F4 a) { return {_mm_sqrt_ps(a.v)}; }
+inline M4 gt(F4 a, F4 b) { return {_mm_cmpgt_ps(a.v, b.v)}; }
+inline M4 lt(F4 a, F4 b) { return {_mm_cmplt_ps(a.v, b.v)}; }
+inline M4 orMask(M4 a, M4 b) { return {_mm_or_ps(a.v, b.v)}; }
+inline M4 andMask(M4 a, M4 b) { return {_mm_and_ps(a.v, b.v)}; }
+inline bool any(M4 m) { return _mm_movemask_ps(m.v) != 0; }
+inline F4 select(M4 m, F4 a, F4 b) { return {_mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v))}; }
+inline F4 loadu(const float *p) { return {_mm_loadu_ps(p)}; }
+inline void storeu(float *p, F4 a) { _mm_storeu_ps(p, a.v); }
+
+struct I4
+{
+  __m128i v;
+};
+
+inline I4 set1i(uint32_t s) { return {_mm_set1_epi32((int32_t)s)}; }
+inline I4 addi(I4 a, I4 b) { return {_mm_add_epi32(a.v, b.v)}; }
+inline I4 xori(I4 a, I4 b) { return {_mm_xor_si128(a.v, b.v)}; }
+// SSE2 has no 32-bit mullo: multiply even and odd lanes as 64-bit and keep the low halves.
+inline I4 muli(I4 a, I4 b)
+{
+  const __m128i even = _mm_mul_epu32(a.v, b.v);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a.v, 4), _mm_srli_si128(b.v, 4));
+  return {_mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                             _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)))};
+}
+template <int N>
+inline I4 shri(I4 a) { return {_mm_srli_epi32(a.v, N)}; }
+// Lanes where any of bits is set in a.
+inline M4 testBits(I4 a, uint32_t bits)
+{
+  const __m128i b = _mm_set1_epi32((int32_t)bits);
+  return {_mm_castsi128_ps(_mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(a.v, b), _mm_setzero_si128()),
+                                         _mm_set1_epi32(-1)))};
+}
+// Truncates toward zero, as a (int32_t) cast.
+inline I4 toInt(F4 a) { return {_mm_cvttps_epi32(a.v)}; }
+inline F4 toFloat(I4 a) { return {_mm_cvtepi32_ps(a.v)}; }
+
+#elif SIMD_BACKEND_NEON
+
+struct F4
+{
+  float32x4_t v;
+};
+struct M4
+{
+  uint32x4_t v;
+};
+
+inline F4 load(const float *p) { return {vld1q_f32(p)}; }
+inline void store(float *p, F4 a) { vst1q_f32(p, a.v); }
+inline F4 set1(float s) { return {vdupq_n_f32(s)}; }
+inline F4 add(F4 a, F4 b) { return {vaddq_f32(a.v, b.v)}; }
+inline F4 sub(F4 a, F4 b) { return {vsubq_f32(a.v, b.v)}; }
+inline F4 mul(F4 a, F4 b) { return {vmulq_f32(a.v, b.v)}; }
+inline F4 div(F4 a, F4 b) { return {vdivq_f32(a.v, b.v)}; }
+inline F4 min(F4 a, F4 b) { return {vminq_f32(a.v, b.v)}; }
+inline F4 max(F4 a, F4 b) { return {vmaxq_f32(a.v, b.v)}; }
+inline F4 sqrt(F4 a) { return {vsqrtq_f32(a.v)}; }
+inline M4 gt(F4 a, F4 b) { return {vcgtq_f32(a.v, b.v)}; }
+inline M4 lt(F4 a, F4 b) { return {vcltq_f32(a.v, b.v)}; }
+inline M4 orMask(M4 a, M4 b) { return {vorrq_u32(a.v, b.v)}; }
+inline M4 andMask(M4 a, M4 b) { return {vandq_u32(a.v, b.v)}; }
+inline bool any(M4 m) { return vmaxvq_u32(m.v) != 0; }
+inline F4 select(M4 m, F4 a, F4 b) { return {vbslq_f32(m.v, a.v, b.v)}; }
+inline F4 loadu(const float *p) { return {vld1q_f32(p)}; }
+inline void storeu(float *p, F4 a) { vst1q_f32(p, a.v); }
+
+struct I4
+{
+  uint32x4_t v;
+};
+
+inline I4 set1i(uint32_t s) { return {vdupq_n_u32(s)}; }
+inline I4 addi(I4 a, I4 b) { return {vaddq_u32(a.v, b.v)}; }
+inline I4 xori(I4 a, I4 b) { return {veorq_u32(a.v, b.v)}; }
+inline I4 muli(I4 a, I4 b) { return {vmulq_u32(a.v, b.v)}; }
+template <int N>
+inline I4 shri(I4 a) { return {vshrq_n_u32(a.v, N)}; }
+inline M4 testBits(I4 a, uint32_t bits) { return {vtstq_u32(a.v, vdupq_n_u32(bits))}; }
+inline I4 toInt(F4 a) { return {vreinterpretq_u32_s32(vcvtq_s32_f32(a.v))}; }
+inline F4 toFloat(I4 a) { return {vcvtq_f32_s32(vreinterpretq_s32_u32(a.v))}; }
+
+#else
+
+struct F4
+{
+  float v[4];
+};
+struct M4
+{
+  bool v[4];
+};
+
+#define SIMD_LANES(expr)   \
+  F4 r;                    \
+  for (uint8_t i = 0; i < 4; ++i) \
+  {                        \
+    r.v[i] = (expr);       \
+  }                        \
+  return r
+
+inline F4 load(const float *p) { SIMD_LANES(p[i]); }
+inline void store(float *p, F4 a)
+{
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    p[i] = a.v[i];
+  }
+}
+inline F4 set1(float s) { SIMD_LANES(s); }
+inline F4 add(F4 a, F4 b) { SIMD_LANES(a.v[i] + b.v[i]); }
+inline F4 sub(F4 a, F4 b) { SIMD_LANES(a.v[i] - b.v[i]); }
+inline F4 mul(F4 a, F4 b) { SIMD_LANES(a.v[i] * b.v[i]); }
+inline F4 div(F4 a, F4 b) { SIMD_LANES(a.v[i] / b.v[i]); }
+inline F4 min(F4 a, F4 b) { SIMD_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]); }
+inline F4 max(F4 a, F4 b) { SIMD_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]); }
+inline F4 sqrt(F4 a) { SIMD_LANES(sqrtf(a.v[i])); }
+inline F4 select(M4 m, F4 a, F4 b) { SIMD_LANES(m.v[i] ? a.v[i] : b.v[i]); }
+inline F4 loadu(const float *p) { SIMD_LANES(p[i]); }
+#undef SIMD_LANES
+
+inline void storeu(float *p, F4 a) { store(p, a); }
+
+struct I4
+{
+  uint32_t v[4];
+};
+
+#define SIMD_LANES_I(expr) \
+  I4 r;                    \
+  for (uint8_t i = 0; i < 4; ++i) \
+  {                        \
+    r.v[i] = (expr);       \
+  }                        \
+  return r
+
+inline I4 set1i(uint32_t s) { SIMD_LANES_I(s); }
+inline I4 addi(I4 a, I4 b) { SIMD_LANES_I(a.v[i] + b.v[i]); }
+inline I4 xori(I4 a, I4 b) { SIMD_LANES_I(a.v[i] ^ b.v[i]); }
+inline I4 muli(I4 a, I4 b) { SIMD_LANES_I(a.v[i] * b.v[i]); }
+template <int N>
+inline I4 shri(I4 a) { SIMD_LANES_I(a.v[i] >> N); }
+inline I4 toInt(F4 a) { SIMD_LANES_I((uint32_t)(int32_t)a.v[i]); }
+#undef SIMD_LANES_I
+
+inline F4 toFloat(I4 a) { return {{(float)(int32_t)a.v[0], (float)(int32_t)a.v[1], (float)(int32_t)a.v[2], (float)(int32_t)a.v[3]}}; }
+inline M4 testBits(I4 a, uint32_t bits)
+{
+  return {{(a.v[0] & bits) != 0, (a.v[1] & bits) != 0, (a.v[2] & bits) != 0, (a.v[3] & bits) != 0}};
+}
+
+inline M4 gt(F4 a, F4 b) { return {{a.v[0] > b.v[0], a.v[1] > b.v[1], a.v[2] > b.v[2], a.v[3] > b.v[3]}}; }
+inline M4 lt(F4 a, F4 b) { return {{a.v[0] < b.v[0], a.v[1] < b.v[1], a.v[2] < b.v[2], a.v[3] < b.v[3]}}; }
+inline M4 orMask(M4 a, M4 b) { return {{a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3]}}; }
+inline M4 andMask(M4 a, M4 b) { return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}}; }
+inline bool any(M4 m) { return m.v[0] || m.v[1] || m.v[2] || m.v[3]; }
+
+#endif
+
+// Number of lanes to process so that `count` particles are covered by whole vectors.
+inline uint16_t paddedCount(uint16_t count)
+{
+  return (uint16_t)((count + (SIMD_WIDTH - 1)) & ~(SIMD_WIDTH - 1));
+}
+}
+
+#endif
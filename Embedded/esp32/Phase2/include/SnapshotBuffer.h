@@ -0,0 +1,52 @@
+#ifndef PHASE2_SNAPSHOT_BUFFER_H
+#define PHASE2_SNAPSHOT_BUFFER_H
+
+#include <atomic>
+
+#include "ParticleArena.h"
+#include "ParticleView.h"
+
+// Lock-free hand-off of particle state from the sim task to the render side.
+// Double buffering with a spare slot: the writer always fills a slot the reader
+// is not holding, so neither side ever waits (single producer, single consumer).
+class SnapshotBuffer
+{
+public:
+  bool begin(uint16_t capacity);
+  bool isReady() const { return arena_.isReady(); }
+
+  // Producer side: copy src into the back slot and make it the newest snapshot.
+  void publish(const ParticleView &src, uint32_t frame);
+
+  // Consumer side: switch to the newest snapshot if one was published since the
+  // last call. The returned view stays valid until the next acquire().
+  ParticleView acquire();
+  uint32_t getFrame() const { return slots_[front_].frame; }
+
+private:
+  static constexpr uint8_t kSlotCount = 3;
+  static constexpr uint8_t kFreshBit = 0x80;
+
+  struct Slot
+  {
+    float *x;
+    float *y;
+    float *vx;
+    float *vy;
+    float *radius;
+    uint32_t *states;
+    bool sized;
+    bool stated;
+    uint16_t count;
+    uint32_t frame;
+  };
+
+  ParticleArena arena_;
+  Slot slots_[kSlotCount] = {};
+  uint16_t capacity_ = 0;
+  uint8_t back_ = 0;
+  uint8_t front_ = 1;
+  std::atomic<uint8_t> ready_{2};
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PHASE2_SUBSTEP_SCHEDULER_H
+#define PHASE2_SUBSTEP_SCHEDULER_H
+
+#include "SimConfig.h"
+
+class SimCore;
+
+// Frame-time and substep bookkeeping for the fixed-rate sim loop.
+// Wall time is converted to whole frames of SimConfig::timeStep; each frame is split
+// into substeps so no particle moves more than substepCfl * its smallest radius per
+// substep. Sim time only advances per frame, so results depend on the number of
+// frames run, never on how wall time arrived. Time that cannot be caught up is
+// counted as dropped instead of vanishing.
+struct SchedulerStats
+{
+  uint32_t frames;
+  uint32_t substeps;
+  float droppedMs;
+  uint8_t lastSubsteps;
+};
+
+class SubstepScheduler
+{
+public:
+  SubstepScheduler(SimConfig *cfg, float frameHz) : config_(cfg), frameMs_(1000.0f / frameHz) {}
+
+  // Adds elapsed wall time and returns how many frames to run now (at most maxFramesPerCall).
+  uint8_t advance(float elapsedMs, uint8_t maxFramesPerCall);
+
+  // Runs one frame on sim as CFL-bounded substeps, then advances sim time.
+  void runFrame(SimCore &sim);
+  uint8_t planSubsteps(float maxSpeed, float minRadius) const;
+
+  float getSimTimeSec() const { return simTimeSec_; }
+  float getFrameMs() const { return frameMs_; }
+  // Returns counters accumulated since the previous call and resets them.
+  SchedulerStats consumeStats();
+
+private:
+  SimConfig *config_;
+  float frameMs_;
+  float accumMs_ = 0.0f;
+  float simTimeSec_ = 0.0f;
+  SchedulerStats stats_ = {0, 0, 0.0f, 1};
+};
+
+#endif
@@ -2,16 +2,44 @@
 #define PHASE2_TURBULENCE_H
 
 #include "SimConfig.h"
+#include "TurbulenceField.h"
+
+// Per-step constants hoisted out of the particle loop.
+struct TurbulenceFrame
+{
+  bool active;
+  // Velocity kick per unit of field force (turbStrength * dt).
+  float gain;
+  // turbDecayRate per timeStep, raised to dt / timeStep.
+  float decay;
+  // turbDirectionBias push, only with turbAffectPosition.
+  float biasX;
+  float biasY;
+  // turbScaleField: velocity *= 1 + (value - 0.5) * scaleGain.
+  bool scaleField;
+  float scaleGain;
+  // turbAffectScale: radius = minScale + field * scaleRange.
+  float minScale;
+  float scaleRange;
+};
 
 class Turbulence
 {
 public:
-  explicit Turbulence(SimConfig *cfg) : config_(cfg) {}
+  explicit Turbulence(SimConfig *cfg) : config_(cfg), field_(cfg) {}
+  void reset() { field_.reset(); }
   void apply(float *x, float *y, float *vx, float *vy, uint16_t count, float dt, float tNow);
 
+  // Also rebakes the field when it is due (see TurbulenceField::refresh()).
+  TurbulenceFrame beginFrame(float dt, float tNow);
+  void accumulate(const TurbulenceFrame &frame, float x, float y, float &vx, float &vy) const;
+  // Particle radius from the field value at (x, y), in [turbMinScale, turbMaxScale].
+  float particleRadius(const TurbulenceFrame &frame, float x, float y) const;
+  const TurbulenceField &getField() const { return field_; }
+
 private:
-  float noise2d(float x, float y) const;
   SimConfig *config_;
+  TurbulenceField field_;
 };
 
 #endif
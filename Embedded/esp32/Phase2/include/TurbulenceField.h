@@ -0,0 +1,151 @@
+#ifndef PHASE2_TURBULENCE_FIELD_H
+#define PHASE2_TURBULENCE_FIELD_H
+
+#include "SimConfig.h"
+
+// Nodes per side of the baked field; node (i, j) sits at (i, j) / (TURB_FIELD_SIZE - 1).
+static constexpr uint8_t TURB_FIELD_SIZE = 32;
+// classicdrop keeps max(3, 3 * turbPatternFrequency) drops.
+static constexpr uint8_t TURB_MAX_DROPS = 30;
+
+// turbPatternStyle values, in the order of the JS patternOffsets table.
+enum TurbPattern : uint8_t
+{
+  TURB_CHECKERBOARD = 0,
+  TURB_WAVES = 1,
+  TURB_SPIRAL = 2,
+  TURB_GRID = 3,
+  TURB_CIRCLES = 4,
+  TURB_DIAMONDS = 5,
+  TURB_RIPPLES = 6,
+  TURB_DOTS = 7,
+  TURB_VORONOI = 8,
+  TURB_CELLS = 9,
+  TURB_FRACTAL = 10,
+  TURB_VORTEX = 11,
+  TURB_BUBBLES = 12,
+  TURB_WATER = 13,
+  TURB_CLASSIC_DROP = 14,
+  // Two octaves of Noise::simplex3, animated along z; C++ only.
+  TURB_NOISE = 15
+};
+
+static constexpr uint8_t TURB_PATTERN_COUNT = 16;
+
+// One node: force direction (the strongest node of a bake has length 1) and the
+// pattern value after contrast and blur, in [0, 1].
+struct TurbulenceCell
+{
+  float fx;
+  float fy;
+  float value;
+};
+
+// Pattern generator ported from Sim/src/simulation/forces/turbulenceField.js
+// (rotate -> scale -> domain warp -> symmetry -> offset, pattern, phase, contrast,
+// separation, blur), baked into a TURB_FIELD_SIZE^2 grid at turbFieldRate Hz.
+// Particles only pay for a bilinear fetch, whatever the pattern costs. Blur and
+// turbFieldPersistence run as fixed-point passes over the grid, O(cells) per bake.
+//
+// The force is the pattern's curl (swirl along the contour lines) unless
+// turbAffectPosition is on; then it is the gradient, signed by turbPullFactor like
+// the JS pull / push modes.
+class TurbulenceField
+{
+public:
+  explicit TurbulenceField(SimConfig *cfg) : config_(cfg) {}
+
+  // Drops the bake and the bias drift; the next refresh() bakes.
+  void reset();
+  // Bakes when 1 / turbFieldRate seconds have passed since the last bake. Returns true if it did.
+  bool refresh(float tNow);
+  void bake(float tNow);
+
+  inline TurbulenceCell sample(float x, float y) const
+  {
+    const float last = (float)(TURB_FIELD_SIZE - 1);
+    float gx = x * last;
+    float gy = y * last;
+    gx = gx < 0.0f ? 0.0f : (gx > last ? last : gx);
+    gy = gy < 0.0f ? 0.0f : (gy > last ? last : gy);
+    int ix = (int)gx;
+    int iy = (int)gy;
+    ix = ix > TURB_FIELD_SIZE - 2 ? TURB_FIELD_SIZE - 2 : ix;
+    iy = iy > TURB_FIELD_SIZE - 2 ? TURB_FIELD_SIZE - 2 : iy;
+    const float tx = gx - ix;
+    const float ty = gy - iy;
+    const TurbulenceCell *c = cells_ + iy * TURB_FIELD_SIZE + ix;
+    const TurbulenceCell &a = c[0];
+    const TurbulenceCell &b = c[1];
+    const TurbulenceCell &d = c[TURB_FIELD_SIZE];
+    const TurbulenceCell &e = c[TURB_FIELD_SIZE + 1];
+    TurbulenceCell s;
+    s.fx = lerp(lerp(a.fx, b.fx, tx), lerp(d.fx, e.fx, tx), ty);
+    s.fy = lerp(lerp(a.fy, b.fy, tx), lerp(d.fy, e.fy, tx), ty);
+    s.value = lerp(lerp(a.value, b.value, tx), lerp(d.value, e.value, tx), ty);
+    return s;
+  }
+
+  // Unblurred value at (x, y) for the last bake; host-check reference for sample().
+  float evaluate(float x, float y) const;
+
+private:
+  // Per-bake constants of the coordinate pipeline.
+  struct Frame
+  {
+    uint8_t style;
+    float cosR;
+    float sinR;
+    float scale;
+    float warp;
+    float warpPhase;
+    float symmetry;
+    float offsetX;
+    float offsetY;
+    float freq;
+    // JS `time * speed`, the animation clock of ripples and water.
+    float motion;
+    float phaseTime;
+    float phaseOffset;
+    float pull;
+    float contrast;
+    float separation;
+  };
+
+  struct Drop
+  {
+    float x;
+    float y;
+    float radius;
+    float invWidthSq;
+    float intensity;
+  };
+
+  static inline float lerp(float a, float b, float t) { return a + (b - a) * t; }
+  void beginFrame(float tNow);
+  // Pipeline up to the pattern, then phase + contrast on the raw pattern value.
+  void transform(float x, float y, float &px, float &py) const;
+  float finish(float n) const;
+  float pattern(float x, float y) const;
+  // TURB_NOISE for a row of TURB_FIELD_SIZE transformed points through the batch noise call.
+  void noiseRow(const float *px, const float *py, float *out) const;
+  void blurValues(uint8_t radius);
+  void persistValues(int32_t keep);
+  void bakeForces();
+
+  SimConfig *config_;
+  Frame frame_;
+  Drop drops_[TURB_MAX_DROPS];
+  uint8_t dropCount_ = 0;
+  TurbulenceCell cells_[TURB_FIELD_SIZE * TURB_FIELD_SIZE];
+  // Value channel in fixed point: this bake before blending, and the field after the last bake.
+  uint16_t fixed_[TURB_FIELD_SIZE * TURB_FIELD_SIZE];
+  uint16_t history_[TURB_FIELD_SIZE * TURB_FIELD_SIZE];
+  bool baked_ = false;
+  float bakedAt_ = 0.0f;
+  // Pattern drift from turbDirectionBias, integrated between bakes.
+  float biasOffsetX_ = 0.0f;
+  float biasOffsetY_ = 0.0f;
+};
+
+#endif
@@ -1,16 +1,116 @@
 #ifndef PHASE2_VORONOI_H
 #define PHASE2_VORONOI_H
 
+#include "Boundary.h"
 #include "SimConfig.h"
 
+// Cells per side of the nearest-seed grid over [0,1]^2; cell (i, j) is centered on
+// ((i + 0.5), (j + 0.5)) / VORONOI_GRID.
+static constexpr uint8_t VORONOI_GRID = 16;
+static constexpr uint16_t VORONOI_CELLS = (uint16_t)VORONOI_GRID * VORONOI_GRID;
+// Seed ids are uint8 with VORONOI_NO_SEED marking an empty slot.
+static constexpr uint8_t VORONOI_MAX_SEEDS = 64;
+static constexpr uint8_t VORONOI_NO_SEED = 0xFF;
+
+// Per-step constants hoisted out of the particle loop.
+struct VoronoiFrame
+{
+  bool active;
+  // Force per unit of edge factor (voronoiStrength * voronoiAttraction * dt).
+  float gain;
+  // Velocity kept per step away from / on an edge: 1 - voronoiBlend * (1 - decay).
+  float keep;
+  float edgeKeep;
+  float invEdgeWidth;
+  // +1 pulls particles onto the edges (voronoiPullMode), -1 pushes them into the cells.
+  float sign;
+  // Speed floor of the on-edge limit, 0.1 * voronoiStrength as in the JS.
+  float edgeSpeed;
+};
+
+// Counters since the last consumeStats().
+struct VoronoiStats
+{
+  uint32_t rebuilds;
+  uint32_t passes;
+};
+
+// Edge field ported from Sim/src/simulation/forces/voronoiField.js. The JS looks for the two
+// nearest seeds of every particle by looping over all of them; here a jump flood rebuilds a
+// VORONOI_GRID^2 map of the nearest seed per cell and the neighbor whose bisector with it is
+// closest, and a particle reads its cell's pair and measures its exact distance to that
+// bisector. The flood is O(cells * log2(VORONOI_GRID)) whatever voronoiCellCount is, and only
+// runs once some seed has drifted half a cell since the last one; a particle costs one lookup
+// and two seed reads.
+//
+// Seeds drift at up to voronoiCellSpeed, re-roll their velocity with the JS's 1% chance per
+// timeStep and bounce off the boundary. Near an edge particles lose speed (voronoiDecayRate,
+// mixed in by voronoiBlend) and are pushed away from it, or onto it with voronoiPullMode;
+// particles already on an edge get a small push along it and a speed limit instead, which
+// draws the filaments.
 class Voronoi
 {
 public:
   explicit Voronoi(SimConfig *cfg) : config_(cfg) {}
-  void step(float dt);
+
+  // Drops the seeds; the next beginFrame() scatters new ones and rebuilds.
+  void reset();
+  // Moves the seeds by dt and rebuilds the grid when it is due.
+  VoronoiFrame beginFrame(const Boundary &boundary, float dt);
+  void accumulate(const VoronoiFrame &frame, float x, float y, float &vx, float &vy) const;
+  void apply(const Boundary &boundary, const float *x, const float *y, float *vx, float *vy, uint16_t count, float dt);
+  void rebuild();
+  VoronoiStats consumeStats();
+
+  // Distance from (x, y) to the bisector of the seed pair stored for its cell, and the unit
+  // direction toward that bisector. Returns false while there are fewer than two seeds.
+  bool edgeDistance(float x, float y, float &dist, float &dirX, float &dirY) const;
+  // Exact nearest seed / Voronoi edge distance by looping over every seed; host-check reference.
+  uint8_t nearestSeed(float x, float y) const;
+  float edgeDistanceExact(float x, float y) const;
+  uint8_t getSeedCount() const { return seedCount_; }
+  uint8_t getCellSeed(uint8_t i, uint8_t j) const { return nearest_[j * VORONOI_GRID + i]; }
 
 private:
+  struct Seed
+  {
+    float x;
+    float y;
+    float vx;
+    float vy;
+    // Position at the last rebuild.
+    float builtX;
+    float builtY;
+  };
+
+  static inline uint16_t cellOf(float x, float y)
+  {
+    int i = (int)(x * VORONOI_GRID);
+    int j = (int)(y * VORONOI_GRID);
+    i = i < 0 ? 0 : (i >= VORONOI_GRID ? VORONOI_GRID - 1 : i);
+    j = j < 0 ? 0 : (j >= VORONOI_GRID ? VORONOI_GRID - 1 : j);
+    return (uint16_t)(j * VORONOI_GRID + i);
+  }
+  void scatterSeeds(const Boundary &boundary);
+  void moveSeeds(const Boundary &boundary, float dt);
+  void randomVelocity(Seed &s) const;
+  // Offers seed id to cell c's pair; returns the seed that no longer fits, if any.
+  uint8_t stamp(uint8_t id, uint16_t c);
+  // One jump-flood pass at stride `step` from (fromNear, fromSecond) into (toNear, toSecond).
+  void floodPass(uint8_t step, const uint8_t *fromNear, const uint8_t *fromSecond, uint8_t *toNear, uint8_t *toSecond) const;
+
   SimConfig *config_;
+  Seed seeds_[VORONOI_MAX_SEEDS];
+  uint8_t seedCount_ = 0;
+  uint8_t seedShape_ = 0xFF;
+  float seedScale_ = 0.0f;
+  bool dirty_ = true;
+  // Nearest seed and edge partner per cell, plus the ping-pong pair the flood writes into.
+  uint8_t nearest_[VORONOI_CELLS];
+  uint8_t second_[VORONOI_CELLS];
+  uint8_t floodNear_[VORONOI_CELLS];
+  uint8_t floodSecond_[VORONOI_CELLS];
+  VoronoiStats stats_ = {};
 };
 
 #endif
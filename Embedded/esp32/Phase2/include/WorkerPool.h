@@ -0,0 +1,75 @@
+#ifndef PHASE2_WORKER_POOL_H
+#define PHASE2_WORKER_POOL_H
+
+#include <atomic>
+#include <stdint.h>
+
+#include "SimConfig.h"
+
+#if SIM_NATIVE
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#else
+#include <Arduino.h>
+#endif
+
+// Workers per run(), caller included. On device the only helper sits on the other core.
+static constexpr uint8_t MAX_POOL_WORKERS = SIM_MAX_POOL_WORKERS;
+
+typedef void (*PoolJobFn)(void *ctx, uint8_t worker, uint8_t workers);
+
+// Fork-join helpers for the sim thread. run() hands the same job to `workers`
+// workers (the caller is worker 0) and returns once all of them finished; inside
+// a job, barrier() separates phases. Helpers start on first use (FreeRTOS task on
+// the core not running the caller, std::thread on host) and then sleep between runs.
+class WorkerPool
+{
+public:
+#if SIM_NATIVE
+  // Host threads are joined so static pools shut down cleanly at exit.
+  ~WorkerPool();
+#endif
+  uint8_t clampWorkers(uint8_t requested) const;
+  void run(PoolJobFn job, void *ctx, uint8_t workers);
+  void barrier();
+
+private:
+  struct Helper
+  {
+    WorkerPool *pool;
+    uint8_t index;
+#if SIM_NATIVE
+    std::thread thread;
+    uint32_t startGeneration;
+#else
+    TaskHandle_t handle;
+#endif
+  };
+
+  bool ensureHelpers(uint8_t count);
+  static void helperEntry(void *arg);
+  void helperLoop(uint8_t index);
+  void finishHelper();
+
+  Helper helpers_[MAX_POOL_WORKERS - 1];
+  uint8_t helperCount_ = 0;
+  PoolJobFn job_ = nullptr;
+  void *ctx_ = nullptr;
+  uint8_t workers_ = 1;
+  // Workers in the current run, for barrier(); workers_ is the copy helpers snapshot.
+  uint8_t active_ = 1;
+  std::atomic<uint8_t> pending_{0};
+  std::atomic<uint8_t> barrierCount_{0};
+  std::atomic<uint32_t> barrierPhase_{0};
+#if SIM_NATIVE
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  uint32_t generation_ = 0;
+  bool stopping_ = false;
+#else
+  TaskHandle_t caller_ = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef PHASE2_NATIVE_ARDUINO_H
+#define PHASE2_NATIVE_ARDUINO_H
+
+// Host stand-in for <Arduino.h> used by env:native_bench.
+// Only the surface touched by the simulation modules is provided.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+
+long random(long maxVal);
+long random(long minVal, long maxVal);
+void randomSeed(uint32_t seed);
+
+template <typename T, typename L, typename H>
+inline T constrain(T v, L lo, H hi)
+{
+  return v < (T)lo ? (T)lo : (v > (T)hi ? (T)hi : v);
+}
+
+class HostSerial
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+  void print(const char *s);
+  void println(const char *s);
+};
+
+extern HostSerial Serial;
+
+#endif
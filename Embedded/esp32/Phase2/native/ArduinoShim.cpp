@@ -0,0 +1,80 @@
+#include <Arduino.h>
+
+#include <stdarg.h>
+
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+static const std::chrono::steady_clock::time_point kStart = std::chrono::steady_clock::now();
+
+// xorshift32 so host runs are reproducible for a given seed.
+static uint32_t gRandState = 0x9E3779B9u;
+
+uint32_t millis()
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - kStart).count();
+}
+
+uint32_t micros()
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - kStart).count();
+}
+
+void delay(uint32_t ms)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static uint32_t nextRand()
+{
+  uint32_t s = gRandState;
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  gRandState = s;
+  return s;
+}
+
+long random(long maxVal)
+{
+  if (maxVal <= 0)
+  {
+    return 0;
+  }
+  return (long)(nextRand() % (uint32_t)maxVal);
+}
+
+long random(long minVal, long maxVal)
+{
+  if (minVal >= maxVal)
+  {
+    return minVal;
+  }
+  return minVal + random(maxVal - minVal);
+}
+
+void randomSeed(uint32_t seed)
+{
+  gRandState = seed == 0 ? 0x9E3779B9u : seed;
+}
+
+int HostSerial::printf(const char *fmt, ...)
+{
+  va_list args;
+  va_start(args, fmt);
+  const int n = vprintf(fmt, args);
+  va_end(args);
+  return n;
+}
+
+void HostSerial::print(const char *s)
+{
+  fputs(s, stdout);
+}
+
+void HostSerial::println(const char *s)
+{
+  puts(s);
+}
@@ -0,0 +1,488 @@
+// Host benchmark for the Phase2 simulation core (env:native_bench).
+// Runs fixed scenarios and reports ns/step per SimCore stage, ns/frame for the adaptive
+// substep scheduler, per grid mode and per collision worker count.
+//
+// Usage: program [steps]   (default 2000 measured steps per scenario)
+//        program check     (host correctness checks, non-zero exit on failure)
+
+#include <Arduino.h>
+
+#include "HostChecks.h"
+
+#include "GridGeometry.h"
+#include "GridModes.h"
+#include "Noise.h"
+#include "OrganicBehavior.h"
+#include "SimConfig.h"
+#include "SimCore.h"
+#include "SubstepScheduler.h"
+#include "TurbulenceField.h"
+#include "Voronoi.h"
+#include "WorkerPool.h"
+
+#include <chrono>
+
+struct BenchScenario
+{
+  const char *name;
+  uint16_t particleCount;
+  uint8_t boundaryShape;
+  float particleRadius;
+  float gravityY;
+  float turbStrength;
+  bool collisionEnabled;
+  bool affectScale;
+  float boundaryRepulsion;
+  float picFlipRatio;
+  uint16_t gridFrames;
+};
+
+static const BenchScenario kScenarios[] = {
+    {"calm-50-circle", 50, 0, 0.03f, 0.0f, 0.0f, true, false, 0.0f, 0.0f, 100},
+    {"gravity-200-circle", 200, 0, 0.02f, 1.0f, 0.0f, true, false, 0.0f, 0.0f, 100},
+    {"turb-200-rect", 200, 1, 0.02f, 0.0f, 5.0f, true, false, 0.0f, 0.0f, 100},
+    {"pile-300-circle", 300, 0, 0.015f, 2.0f, 2.0f, true, false, 0.0f, 0.0f, 100},
+    {"nocoll-300-rect", 300, 1, 0.015f, 0.5f, 5.0f, false, false, 0.0f, 0.0f, 100},
+    {"sized-300-circle", 300, 0, 0.015f, 1.0f, 2.0f, true, true, 0.0f, 0.0f, 100},
+    {"soft-300-circle", 300, 0, 0.015f, 1.0f, 2.0f, false, false, 0.3f, 0.0f, 100},
+    {"nocoll-300-dome", 300, 3, 0.015f, 0.5f, 5.0f, false, false, 0.0f, 0.0f, 100},
+    {"flip-300-circle", 300, 0, 0.015f, 1.0f, 2.0f, false, false, 0.0f, 0.5f, 100},
+    {"crowd-2000-circle", 2000, 0, 0.006f, 1.0f, 2.0f, true, false, 0.0f, 0.0f, 2},
+};
+
+static const uint8_t kGridModes[] = {1, 2, 3, 4, 5, 7, 8};
+
+static constexpr uint16_t kWarmupSteps = 240;
+
+static inline uint64_t nowNs()
+{
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void applyScenario(SimConfig &cfg, const BenchScenario &sc)
+{
+  cfg = SimConfig();
+  cfg.particleCount = sc.particleCount;
+  cfg.boundaryShape = sc.boundaryShape;
+  cfg.particleRadius = sc.particleRadius;
+  cfg.gravityY = sc.gravityY;
+  cfg.turbStrength = sc.turbStrength;
+  cfg.collisionEnabled = sc.collisionEnabled;
+  cfg.turbAffectScale = sc.affectScale;
+  cfg.boundaryRepulsion = sc.boundaryRepulsion;
+  cfg.picFlipRatio = sc.picFlipRatio;
+}
+
+static void runScenario(const BenchScenario &sc, uint32_t steps)
+{
+  static SimConfig cfg;
+  applyScenario(cfg, sc);
+  static SimCore sim(&cfg);
+  randomSeed(1234);
+  sim.init();
+
+  const float dt = cfg.timeStep;
+  float t = 0.0f;
+  for (uint16_t i = 0; i < kWarmupSteps; ++i)
+  {
+    sim.step(dt, t);
+    t += dt;
+  }
+
+  uint64_t gravityNs = 0;
+  uint64_t turbNs = 0;
+  uint64_t fluidNs = 0;
+  uint64_t collisionNs = 0;
+  uint64_t integrateNs = 0;
+  for (uint32_t i = 0; i < steps; ++i)
+  {
+    sim.syncCount();
+    uint64_t t0 = nowNs();
+    sim.applyGravity(dt);
+    uint64_t t1 = nowNs();
+    sim.applyTurbulence(dt, t);
+    uint64_t t2 = nowNs();
+    sim.applyFluid(dt);
+    uint64_t t3 = nowNs();
+    sim.resolveCollisions();
+    uint64_t t4 = nowNs();
+    sim.integrate(dt);
+    uint64_t t5 = nowNs();
+    gravityNs += t1 - t0;
+    turbNs += t2 - t1;
+    fluidNs += t3 - t2;
+    collisionNs += t4 - t3;
+    integrateNs += t5 - t4;
+    t += dt;
+  }
+
+  const uint64_t stagedStart = nowNs();
+  for (uint32_t i = 0; i < steps; ++i)
+  {
+    sim.stepStaged(dt, t);
+    t += dt;
+  }
+  const uint64_t stagedNs = nowNs() - stagedStart;
+
+  const uint64_t fusedStart = nowNs();
+  for (uint32_t i = 0; i < steps; ++i)
+  {
+    sim.stepFused(dt, t);
+    t += dt;
+  }
+  const uint64_t fusedNs = nowNs() - fusedStart;
+
+  SubstepScheduler scheduler(&cfg, 60.0f);
+  (void)sim.consumeCollisionStats();
+  (void)sim.consumeFluidStats();
+  const uint64_t frameStart = nowNs();
+  for (uint32_t i = 0; i < steps; ++i)
+  {
+    scheduler.runFrame(sim);
+  }
+  const uint64_t frameNs = nowNs() - frameStart;
+  const SchedulerStats sched = scheduler.consumeStats();
+  const CollisionStats coll = sim.consumeCollisionStats();
+  const FluidStats fluid = sim.consumeFluidStats();
+
+  Serial.printf("%-20s n=%3u | gravity %7.0f | turb %7.0f | fluid %7.0f | collision %8.0f | integrate %7.0f | staged %8.0f | fused %8.0f ns/step\n",
+                sc.name, (unsigned)sim.getCount(),
+                (double)gravityNs / steps, (double)turbNs / steps, (double)fluidNs / steps,
+                (double)collisionNs / steps, (double)integrateNs / steps,
+                (double)stagedNs / steps, (double)fusedNs / steps);
+  Serial.printf("%-20s adaptive frame %8.0f ns | substeps %.2f avg | collision grid %u rebuild %.0f%% pairs %lu contacts %lu passes %.2f\n", "",
+                (double)frameNs / steps, (double)sched.substeps / sched.frames, (unsigned)coll.gridSize,
+                coll.steps ? 100.0 * coll.rebuilds / coll.steps : 0.0,
+                (unsigned long)(coll.steps ? coll.pairsTested / coll.steps : 0),
+                (unsigned long)(coll.steps ? coll.contacts / coll.steps : 0),
+                coll.steps ? (double)coll.passes / coll.steps : 0.0);
+  if (fluid.steps > 0)
+  {
+    Serial.printf("%-20s fluid cells %.0f | sweeps %.1f | divergence rms %.4f -> %.5f\n", "", (double)fluid.fluidCells / fluid.steps,
+                  (double)fluid.sweeps / fluid.steps, (double)fluid.divergenceIn / fluid.steps, (double)fluid.divergenceOut / fluid.steps);
+  }
+
+  static GridGeometry geom(&cfg);
+  static GridModes modes(&cfg);
+  static uint8_t cellValues[MAX_GRID_CELLS];
+  modes.begin(sim.getCapacity());
+  geom.rebuild();
+  Serial.printf("%-20s cells=%u |", "", (unsigned)geom.getCellCount());
+  for (uint8_t m = 0; m < sizeof(kGridModes); ++m)
+  {
+    cfg.gridMode = kGridModes[m];
+    const uint64_t g0 = nowNs();
+    for (uint16_t f = 0; f < sc.gridFrames; ++f)
+    {
+      modes.compute(sim.getView(), geom, cellValues, MAX_GRID_CELLS);
+    }
+    const uint64_t g1 = nowNs();
+    Serial.printf(" m%u %.1fus", (unsigned)kGridModes[m], (double)(g1 - g0) / sc.gridFrames / 1000.0);
+  }
+  Serial.printf(" per frame\n");
+}
+
+// Collision solve time per worker count on the dense scenarios (results are identical).
+static void runCollisionThreads(const BenchScenario &sc, uint32_t steps)
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  double ns[MAX_POOL_WORKERS + 1] = {};
+  for (uint8_t threads = 1; threads <= MAX_POOL_WORKERS; threads *= 2)
+  {
+    applyScenario(cfg, sc);
+    cfg.collisionThreads = threads;
+    randomSeed(1234);
+    sim.init();
+    float t = 0.0f;
+    uint64_t collisionNs = 0;
+    for (uint32_t i = 0; i < kWarmupSteps + steps; ++i)
+    {
+      sim.applyGravity(cfg.timeStep);
+      sim.applyTurbulence(cfg.timeStep, t);
+      const uint64_t t0 = nowNs();
+      sim.resolveCollisions();
+      if (i >= kWarmupSteps)
+      {
+        collisionNs += nowNs() - t0;
+      }
+      sim.integrate(cfg.timeStep);
+      t += cfg.timeStep;
+    }
+    ns[threads] = (double)collisionNs / steps;
+  }
+  Serial.printf("%-20s collision", sc.name);
+  for (uint8_t threads = 1; threads <= MAX_POOL_WORKERS; threads *= 2)
+  {
+    Serial.printf(" | %u thread(s) %8.0f", (unsigned)threads, ns[threads]);
+  }
+  Serial.printf(" ns/step\n");
+}
+
+// The per-particle hash Turbulence used before the baked field, kept as the noise baseline.
+static float legacySinHash(float x, float y)
+{
+  const float h = sinf(x * 12.9898f + y * 78.233f) * 43758.5453f;
+  return (h - floorf(h)) * 2.0f - 1.0f;
+}
+
+// ns per point: legacy sin hash vs simplex3, one call per point and batched per row.
+static void runNoise()
+{
+  static float xs[1024];
+  static float ys[1024];
+  static float out[1024];
+  for (uint16_t i = 0; i < 1024; ++i)
+  {
+    xs[i] = (i % 32) * 0.37f;
+    ys[i] = (i / 32) * 0.37f;
+  }
+  const uint16_t rounds = 200;
+  float sink = 0.0f;
+  const uint64_t t0 = nowNs();
+  for (uint16_t r = 0; r < rounds; ++r)
+  {
+    for (uint16_t i = 0; i < 1024; ++i)
+    {
+      out[i] = legacySinHash(xs[i] + r, ys[i]);
+    }
+    sink += out[r];
+  }
+  const uint64_t t1 = nowNs();
+  for (uint16_t r = 0; r < rounds; ++r)
+  {
+    for (uint16_t i = 0; i < 1024; ++i)
+    {
+      out[i] = Noise::simplex3(xs[i], ys[i], r * 0.01f, 1);
+    }
+    sink += out[r];
+  }
+  const uint64_t t2 = nowNs();
+  for (uint16_t r = 0; r < rounds; ++r)
+  {
+    Noise::simplex3(xs, ys, r * 0.01f, out, 1024, 1);
+    sink += out[r];
+  }
+  const uint64_t t3 = nowNs();
+  const double n = 1024.0 * rounds;
+  Serial.printf("%-20s sin hash %.1f | simplex3 %.1f | simplex3 batch %.1f ns/point (%g)\n", "noise",
+                (double)(t1 - t0) / n, (double)(t2 - t1) / n, (double)(t3 - t2) / n, (double)sink * 0.0);
+}
+
+// Turbulence field bake per pattern style; particles only pay the bilinear fetch on top.
+static void runTurbulenceBake()
+{
+  static SimConfig cfg;
+  cfg = SimConfig();
+  static TurbulenceField field(&cfg);
+  const uint16_t bakes = 200;
+  Serial.printf("%-20s bake us |", "turb-field");
+  for (uint8_t style = 0; style < TURB_PATTERN_COUNT; ++style)
+  {
+    cfg.turbPatternStyle = style;
+    const uint64_t t0 = nowNs();
+    for (uint16_t i = 0; i < bakes; ++i)
+    {
+      field.bake(i * cfg.timeStep);
+    }
+    Serial.printf(" s%u %.0f", (unsigned)style, (double)(nowNs() - t0) / bakes / 1000.0);
+  }
+  Serial.printf(" (%ux%u nodes, %.0f Hz)\n", (unsigned)TURB_FIELD_SIZE, (unsigned)TURB_FIELD_SIZE, (double)cfg.turbFieldRate);
+
+  // Fixed-point passes alone: style 0 bare, then with the widest blur and persistence on.
+  Serial.printf("%-20s bake us |", "turb-field-passes");
+  const float blurs[] = {0.0f, 2.0f, 2.0f};
+  const float persist[] = {0.0f, 0.0f, 0.9f};
+  for (uint8_t v = 0; v < 3; ++v)
+  {
+    cfg = SimConfig();
+    cfg.turbBlurAmount = blurs[v];
+    cfg.turbFieldPersistence = persist[v];
+    field.reset();
+    const uint64_t t0 = nowNs();
+    for (uint16_t i = 0; i < bakes; ++i)
+    {
+      field.bake(i * cfg.timeStep);
+    }
+    Serial.printf(" blur %.0f persist %.1f: %.1f", (double)blurs[v], (double)persist[v], (double)(nowNs() - t0) / bakes / 1000.0);
+  }
+  Serial.printf("\n");
+}
+
+// Voronoi flood and per-particle sample per seed count, against the JS-style loop over all
+// seeds; the flood should stay flat as seeds grow.
+static void runVoronoi()
+{
+  static SimConfig cfg;
+  cfg = SimConfig();
+  cfg.voronoiStrength = 1.0f;
+  static Boundary boundary(&cfg);
+  static Voronoi voronoi(&cfg);
+  static float xs[1024];
+  static float ys[1024];
+  for (uint16_t i = 0; i < 1024; ++i)
+  {
+    xs[i] = ((i * 37) % 1024) / 1024.0f;
+    ys[i] = ((i * 101) % 1024) / 1024.0f;
+  }
+  const uint8_t seedCounts[] = {4, 16, 64};
+  const uint16_t rounds = 100;
+  Serial.printf("%-20s", "voronoi");
+  for (uint8_t s = 0; s < sizeof(seedCounts); ++s)
+  {
+    cfg.voronoiCellCount = seedCounts[s];
+    randomSeed(1234);
+    voronoi.reset();
+    const VoronoiFrame frame = voronoi.beginFrame(boundary, cfg.timeStep);
+    const uint64_t t0 = nowNs();
+    for (uint16_t r = 0; r < rounds; ++r)
+    {
+      voronoi.rebuild();
+    }
+    const uint64_t t1 = nowNs();
+    volatile float sink = 0.0f;
+    for (uint16_t r = 0; r < rounds; ++r)
+    {
+      for (uint16_t i = 0; i < 1024; ++i)
+      {
+        float vx = 0.1f;
+        float vy = 0.0f;
+        voronoi.accumulate(frame, xs[i], ys[i], vx, vy);
+        sink += vx;
+      }
+    }
+    const uint64_t t2 = nowNs();
+    for (uint16_t r = 0; r < rounds; ++r)
+    {
+      for (uint16_t i = 0; i < 1024; ++i)
+      {
+        sink += voronoi.edgeDistanceExact(xs[i], ys[i]);
+      }
+    }
+    const uint64_t t3 = nowNs();
+    const double n = 1024.0 * rounds;
+    Serial.printf(" | seeds %u: flood %.1f us, sample %.1f ns, all-seed loop %.1f ns", (unsigned)seedCounts[s],
+                  (double)(t1 - t0) / rounds / 1000.0, (double)(t2 - t1) / n, (double)(t3 - t2) / n);
+  }
+  const VoronoiStats stats = voronoi.consumeStats();
+  Serial.printf(" (%ux%u cells, %.0f passes)\n", (unsigned)VORONOI_GRID, (unsigned)VORONOI_GRID,
+                stats.rebuilds ? (double)stats.passes / stats.rebuilds : 0.0);
+}
+
+// One organic behavior per frame, grid bin included, for growing counts at the default radius.
+// Swarm caps its neighbours and chain only visits its links, so the cost per particle should
+// stay flat as the count grows.
+static void runOrganic(const char *name, uint8_t mode, uint32_t steps)
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static OrganicBehavior organic(&cfg);
+  const uint16_t counts[] = {300, 1000, 2000};
+  const uint8_t runs = sizeof(counts) / sizeof(counts[0]);
+  const uint32_t rounds = steps < 200 ? steps : 200;
+  // init() logs its arena, so the line is printed once every count has run.
+  double us[runs];
+  double neighbors[runs];
+  for (uint8_t c = 0; c < runs; ++c)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = counts[c];
+    cfg.particleRadius = 0.008f;
+    cfg.gravityY = 0.5f;
+    cfg.organicBehavior = mode;
+    randomSeed(1234);
+    sim.init();
+    organic.begin(sim.getCapacity());
+    float t = 0.0f;
+    for (uint16_t s = 0; s < kWarmupSteps; ++s)
+    {
+      sim.step(cfg.timeStep, t);
+      organic.apply(sim, cfg.timeStep);
+      t += cfg.timeStep;
+    }
+    (void)organic.consumeStats();
+    uint64_t ns = 0;
+    for (uint32_t s = 0; s < rounds; ++s)
+    {
+      sim.step(cfg.timeStep, t);
+      t += cfg.timeStep;
+      const uint64_t t0 = nowNs();
+      organic.apply(sim, cfg.timeStep);
+      ns += nowNs() - t0;
+    }
+    const OrganicStats stats = organic.consumeStats();
+    us[c] = (double)ns / rounds / 1000.0;
+    neighbors[c] = stats.particles ? (double)stats.neighbors / stats.particles : 0.0;
+  }
+  Serial.printf("%-20s", name);
+  for (uint8_t c = 0; c < runs; ++c)
+  {
+    Serial.printf(" | %u: %.1f us (%.0f ns/particle, %.1f neighbors)", (unsigned)counts[c], us[c],
+                  us[c] * 1000.0 / counts[c], neighbors[c]);
+  }
+  Serial.printf("\n");
+}
+
+// Live particle-count changes: incremental syncCount() versus a full init() respawn.
+static void runCountSweep()
+{
+  static SimConfig cfg;
+  cfg = SimConfig();
+  cfg.particleCount = 200;
+  static SimCore sim(&cfg);
+  randomSeed(1234);
+  sim.init();
+
+  const uint16_t counts[] = {250, 150, 400, 300, 1000, 200};
+  uint64_t syncNs = 0;
+  uint64_t initNs = 0;
+  for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+  {
+    cfg.particleCount = counts[i];
+    const uint64_t t0 = nowNs();
+    sim.syncCount();
+    const uint64_t t1 = nowNs();
+    sim.init();
+    const uint64_t t2 = nowNs();
+    syncNs += t1 - t0;
+    initNs += t2 - t1;
+  }
+  const double n = (double)(sizeof(counts) / sizeof(counts[0]));
+  Serial.printf("%-20s incremental %.0f ns | full init %.0f ns per count change\n", "count-sweep", syncNs / n, initNs / n);
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1 && strcmp(argv[1], "check") == 0)
+  {
+    return runHostChecks() == 0 ? 0 : 1;
+  }
+
+  uint32_t steps = 2000;
+  if (argc > 1)
+  {
+    const long v = strtol(argv[1], nullptr, 10);
+    if (v > 0)
+    {
+      steps = (uint32_t)v;
+    }
+  }
+
+  Serial.printf("[Phase2 Bench] %u measured steps per scenario, %u warmup\n", (unsigned)steps, (unsigned)kWarmupSteps);
+  for (size_t i = 0; i < sizeof(kScenarios) / sizeof(kScenarios[0]); ++i)
+  {
+    runScenario(kScenarios[i], steps);
+  }
+  runCollisionThreads(kScenarios[3], steps);
+  runCollisionThreads(kScenarios[9], steps);
+  runNoise();
+  runTurbulenceBake();
+  runVoronoi();
+  runOrganic("swarm", ORGANIC_SWARM, steps);
+  runOrganic("chain", ORGANIC_CHAIN, steps);
+  runOrganic("automata", ORGANIC_AUTOMATA, steps);
+  runCountSweep();
+  return 0;
+}
@@ -0,0 +1,1747 @@
+#include "HostChecks.h"
+
+#include <Arduino.h>
+
+#include "Collision.h"
+#include "GravityForces.h"
+#include "GridModes.h"
+#include "InputMailbox.h"
+#include "NeighborGrid.h"
+#include "Noise.h"
+#include "OrganicBehavior.h"
+#include "ParticleKernels.h"
+#include "SimTask.h"
+#include "SnapshotBuffer.h"
+#include "SubstepScheduler.h"
+#include "TurbulenceField.h"
+#include "Voronoi.h"
+
+#include <atomic>
+#include <thread>
+
+static constexpr uint16_t kCheckCount = 1003;
+static constexpr uint16_t kCheckPadded = 1004;
+
+static int gFailures = 0;
+
+static void report(const char *name, bool ok, float detail)
+{
+  Serial.printf("[check] %-32s %s (%g)\n", name, ok ? "ok  " : "FAIL", (double)detail);
+  if (!ok)
+  {
+    ++gFailures;
+  }
+}
+
+static float randRange(float lo, float hi)
+{
+  return lo + (hi - lo) * ((float)random(0, 100000) / 100000.0f);
+}
+
+struct Columns
+{
+  alignas(16) float x[kCheckPadded];
+  alignas(16) float y[kCheckPadded];
+  alignas(16) float vx[kCheckPadded];
+  alignas(16) float vy[kCheckPadded];
+};
+
+static void fillColumns(Columns &c, float posLo, float posHi, float vel)
+{
+  for (uint16_t i = 0; i < kCheckPadded; ++i)
+  {
+    c.x[i] = randRange(posLo, posHi);
+    c.y[i] = randRange(posLo, posHi);
+    c.vx[i] = randRange(-vel, vel);
+    c.vy[i] = randRange(-vel, vel);
+  }
+}
+
+static float maxDiff(const Columns &a, const Columns &b)
+{
+  float worst = 0.0f;
+  for (uint16_t i = 0; i < kCheckCount; ++i)
+  {
+    const float d[4] = {fabsf(a.x[i] - b.x[i]), fabsf(a.y[i] - b.y[i]), fabsf(a.vx[i] - b.vx[i]), fabsf(a.vy[i] - b.vy[i])};
+    for (uint8_t k = 0; k < 4; ++k)
+    {
+      worst = d[k] > worst ? d[k] : worst;
+    }
+  }
+  return worst;
+}
+
+static void checkVectorKernels()
+{
+  static Columns ref;
+  static Columns vec;
+
+  const IntegrateParams integ = {0.995f, 2.0f, 4.0f, 1.0f / 60.0f};
+  fillColumns(ref, 0.0f, 1.0f, 3.0f);
+  vec = ref;
+  ParticleKernels::integrateScalar(integ, ref.x, ref.y, ref.vx, ref.vy, kCheckCount);
+  ParticleKernels::integrate(integ, vec.x, vec.y, vec.vx, vec.vy, kCheckCount);
+  float d = maxDiff(ref, vec);
+  report("simd integrate == scalar", d <= 1e-6f, d);
+
+  fillColumns(ref, 0.0f, 1.0f, 1.0f);
+  vec = ref;
+  for (uint16_t i = 0; i < kCheckCount; ++i)
+  {
+    ref.vx[i] += 0.3f * 0.016f;
+    ref.vy[i] += -1.1f * 0.016f;
+  }
+  GravityForces::apply(0.3f, -1.1f, 0.016f, vec.vx, vec.vy, kCheckCount);
+  d = maxDiff(ref, vec);
+  report("simd gravity == scalar", d <= 1e-6f, d);
+
+  const char *shapes[BOUNDARY_SHAPE_COUNT] = {"circle", "rect", "rounded rect", "half circle"};
+  static SimConfig cfg;
+  static Boundary boundary(&cfg);
+  for (uint8_t shape = 0; shape < BOUNDARY_SHAPE_COUNT; ++shape)
+  {
+    for (uint8_t mode = 0; mode < 2; ++mode)
+    {
+      cfg = SimConfig();
+      cfg.boundaryShape = shape;
+      cfg.boundaryMode = mode;
+      cfg.boundaryDamping = 0.8f;
+      cfg.boundaryRestitution = 0.6f;
+      cfg.boundaryFriction = 0.7f;
+      cfg.boundaryRepulsion = 0.5f;
+      const BoundaryParams bp = boundary.getParams(cfg.timeStep);
+      fillColumns(ref, -0.2f, 1.2f, 1.0f);
+      vec = ref;
+      ParticleKernels::enforceBoundaryScalar(bp, ref.x, ref.y, ref.vx, ref.vy, kCheckCount);
+      ParticleKernels::enforceBoundary(bp, vec.x, vec.y, vec.vx, vec.vy, kCheckCount);
+      d = maxDiff(ref, vec);
+      char name[48];
+      snprintf(name, sizeof(name), "simd boundary %s %s", shapes[shape], mode == 0 ? "bounce" : "warp");
+      report(name, d <= 1e-6f, d);
+    }
+  }
+}
+
+// Table-driven shapes: particles well inside are never touched, and escaped ones end up inside
+// (within a third of the default radius at the half circle's sharp corners).
+static void checkBoundaryField()
+{
+  static SimConfig cfg;
+  static Boundary boundary(&cfg);
+  static Columns cols;
+  const char *names[2][2] = {{"boundary table interior (rounded rect)", "boundary table containment (rounded rect)"},
+                             {"boundary table interior (half circle)", "boundary table containment (half circle)"}};
+  for (uint8_t shape = BOUNDARY_ROUNDED_RECT; shape <= BOUNDARY_HALF_CIRCLE; ++shape)
+  {
+    cfg = SimConfig();
+    cfg.boundaryShape = shape;
+    const BoundaryParams bp = boundary.getParams(cfg.timeStep);
+    fillColumns(cols, -0.1f, 1.1f, 1.0f);
+    static float inside[kCheckPadded];
+    for (uint16_t i = 0; i < kCheckCount; ++i)
+    {
+      inside[i] = boundary.signedDistance(cols.x[i], cols.y[i]) < -0.01f ? 1.0f : 0.0f;
+    }
+    static Columns before;
+    before = cols;
+    ParticleKernels::enforceBoundary(bp, cols.x, cols.y, cols.vx, cols.vy, kCheckCount);
+    uint16_t moved = 0;
+    float worstOutside = 0.0f;
+    for (uint16_t i = 0; i < kCheckCount; ++i)
+    {
+      if (inside[i] > 0.0f && (cols.x[i] != before.x[i] || cols.y[i] != before.y[i]))
+      {
+        ++moved;
+      }
+      worstOutside = fmaxf(worstOutside, boundary.signedDistance(cols.x[i], cols.y[i]));
+    }
+    const uint8_t k = (uint8_t)(shape - BOUNDARY_ROUNDED_RECT);
+    report(names[k][0], moved == 0, (float)moved);
+    report(names[k][1], worstOutside < 0.01f, worstOutside);
+  }
+}
+
+// Soft boundary: a settled gravity pile sits off the wall once the repulsion zone is on, and
+// restitution 0 leaves no outward velocity at contact.
+static void checkBoundaryRepulsion()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  float gap[2] = {};
+  for (uint8_t run = 0; run < 2; ++run)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 200;
+    cfg.collisionEnabled = false;
+    cfg.gravityY = 1.0f;
+    cfg.boundaryRepulsion = run == 0 ? 0.0f : 0.5f;
+    randomSeed(5);
+    sim.init();
+    for (uint16_t i = 0; i < 400; ++i)
+    {
+      sim.step(cfg.timeStep, i * cfg.timeStep);
+    }
+    const float radius = 0.5f * cfg.boundaryScale;
+    for (uint16_t i = 0; i < sim.getCount(); ++i)
+    {
+      const float dx = sim.getX()[i] - 0.5f;
+      const float dy = sim.getY()[i] - 0.5f;
+      gap[run] += (radius - sqrtf(dx * dx + dy * dy)) / sim.getCount();
+    }
+  }
+  Serial.printf("[check] boundary repulsion: mean wall gap %.4f (off) vs %.4f (on)\n", gap[0], gap[1]);
+  report("boundary repulsion lifts pile off wall", gap[1] > 2.0f * gap[0], gap[1] - gap[0]);
+
+  static Boundary boundary(&cfg);
+  static Columns cols;
+  cfg = SimConfig();
+  cfg.boundaryRestitution = 0.0f;
+  const BoundaryParams bp = boundary.getParams(cfg.timeStep);
+  fillColumns(cols, -0.2f, 1.2f, 1.0f);
+  ParticleKernels::enforceBoundary(bp, cols.x, cols.y, cols.vx, cols.vy, kCheckCount);
+  float worst = 0.0f;
+  for (uint16_t i = 0; i < kCheckCount; ++i)
+  {
+    const float dx = cols.x[i] - 0.5f;
+    const float dy = cols.y[i] - 0.5f;
+    const float d = sqrtf(dx * dx + dy * dy);
+    if (d >= bp.radius - 1e-5f)
+    {
+      worst = fmaxf(worst, (cols.vx[i] * dx + cols.vy[i] * dy) / d);
+    }
+  }
+  report("boundary restitution 0 stops outflow", worst <= 1e-5f, worst);
+}
+
+// Simplex noise: batch matches scalar bit for bit, stays in [-1, 1], and is continuous in space
+// and time (bounded slope over small steps, where the old sin hash jumped by up to 2).
+static void checkNoise()
+{
+  static Columns cols;
+  static float batch[kCheckPadded];
+  fillColumns(cols, -20.0f, 20.0f, 1.0f);
+  const float z = 3.7f;
+  Noise::simplex3(cols.x, cols.y, z, batch, kCheckCount, 7);
+  uint16_t mismatched = 0;
+  float lo = 1.0f;
+  float hi = -1.0f;
+  float slope = 0.0f;
+  const float step = 1e-3f;
+  for (uint16_t i = 0; i < kCheckCount; ++i)
+  {
+    const float n = Noise::simplex3(cols.x[i], cols.y[i], z, 7);
+    if (memcmp(&n, &batch[i], sizeof(float)) != 0)
+    {
+      ++mismatched;
+    }
+    lo = fminf(lo, n);
+    hi = fmaxf(hi, n);
+    // vx / vy give a random step direction in x, y and time.
+    const float dz = 0.5f;
+    const float len = sqrtf(cols.vx[i] * cols.vx[i] + cols.vy[i] * cols.vy[i] + dz * dz);
+    const float k = step / len;
+    const float moved = Noise::simplex3(cols.x[i] + cols.vx[i] * k, cols.y[i] + cols.vy[i] * k, z + dz * k, 7);
+    slope = fmaxf(slope, fabsf(moved - n) / step);
+  }
+  report("noise batch == scalar", mismatched == 0, (float)mismatched);
+  report("noise spans [-1, 1]", lo >= -1.0f && hi <= 1.0f && lo < -0.5f && hi > 0.5f, hi - lo);
+  report("noise continuous (max slope)", slope < 8.0f, slope);
+}
+
+// Every pattern style bakes to a finite, non-flat field in range; bilinear fetches track the
+// unbaked pattern; the field rebakes at turbFieldRate on a 60 Hz step clock.
+static void checkTurbulenceField()
+{
+  static SimConfig cfg;
+  static TurbulenceField field(&cfg);
+  uint8_t badStyles = 0;
+  for (uint8_t style = 0; style < TURB_PATTERN_COUNT; ++style)
+  {
+    cfg = SimConfig();
+    cfg.turbPatternStyle = style;
+    cfg.turbDomainWarp = 0.3f;
+    cfg.turbSymmetryAmount = 0.2f;
+    cfg.turbSeparation = 0.3f;
+    field.bake(2.7f);
+    float lo = 1.0f;
+    float hi = 0.0f;
+    float longest = 0.0f;
+    bool finite = true;
+    for (uint8_t gy = 0; gy < TURB_FIELD_SIZE; ++gy)
+    {
+      for (uint8_t gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+      {
+        const TurbulenceCell c = field.sample(gx / (TURB_FIELD_SIZE - 1.0f), gy / (TURB_FIELD_SIZE - 1.0f));
+        finite = finite && isfinite(c.value) && isfinite(c.fx) && isfinite(c.fy);
+        lo = fminf(lo, c.value);
+        hi = fmaxf(hi, c.value);
+        longest = fmaxf(longest, sqrtf(c.fx * c.fx + c.fy * c.fy));
+      }
+    }
+    if (!finite || lo < 0.0f || hi > 1.0f || hi - lo < 0.05f || longest > 1.0f + 1e-5f)
+    {
+      Serial.printf("[check] turbulence style %u: range %.3f..%.3f force %.3f\n", (unsigned)style, lo, hi, longest);
+      ++badStyles;
+    }
+  }
+  report("turbulence styles bake in range", badStyles == 0, (float)badStyles);
+
+  // Coarse, unclamped pattern; finer detail (or the kinks of the pull-factor curve) falls between
+  // nodes, as it does under the default blur.
+  cfg = SimConfig();
+  cfg.turbScale = 1.5f;
+  cfg.turbPullFactor = 0.0f;
+  cfg.turbBlurAmount = 0.0f;
+  field.bake(1.0f);
+  float mean = 0.0f;
+  for (uint16_t i = 0; i < 2000; ++i)
+  {
+    const float x = randRange(0.0f, 1.0f);
+    const float y = randRange(0.0f, 1.0f);
+    mean += fabsf(field.sample(x, y).value - field.evaluate(x, y)) / 2000.0f;
+  }
+  report("turbulence bilinear tracks pattern", mean < 0.02f, mean);
+
+  cfg = SimConfig();
+  field.reset();
+  uint16_t bakes = 0;
+  for (uint16_t i = 0; i < 60; ++i)
+  {
+    bakes += field.refresh(i / 60.0f) ? 1 : 0;
+  }
+  report("turbulence bakes at field rate", bakes == 20, (float)bakes);
+
+  // Blur smooths (less total variation between nodes) without shifting the field's mean much.
+  float average[2] = {0.0f, 0.0f};
+  float variation[2] = {0.0f, 0.0f};
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    cfg = SimConfig();
+    cfg.turbPatternStyle = TURB_CIRCLES;
+    cfg.turbBlurAmount = pass == 0 ? 0.0f : 2.0f;
+    field.reset();
+    field.bake(1.0f);
+    for (uint8_t gy = 0; gy < TURB_FIELD_SIZE; ++gy)
+    {
+      float prev = 0.0f;
+      for (uint8_t gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+      {
+        const float v = field.sample(gx / (TURB_FIELD_SIZE - 1.0f), gy / (TURB_FIELD_SIZE - 1.0f)).value;
+        average[pass] += v / (TURB_FIELD_SIZE * TURB_FIELD_SIZE);
+        variation[pass] += gx > 0 ? fabsf(v - prev) : 0.0f;
+        prev = v;
+      }
+    }
+  }
+  report("turbulence blur smooths the field", variation[1] < variation[0] * 0.7f && fabsf(average[1] - average[0]) < 0.02f,
+         variation[1] / variation[0]);
+
+  // Persistence: after a style switch the bake keeps persistence^(elapsed / timeStep) of the old field.
+  static float oldField[TURB_FIELD_SIZE * TURB_FIELD_SIZE];
+  static float newField[TURB_FIELD_SIZE * TURB_FIELD_SIZE];
+  const float t0 = 1.0f;
+  const float t1 = 1.05f;
+  for (uint8_t pass = 0; pass < 3; ++pass)
+  {
+    cfg = SimConfig();
+    cfg.turbPatternStyle = pass == 1 ? TURB_WAVES : TURB_CIRCLES;
+    field.reset();
+    field.bake(pass == 1 ? t1 : t0);
+    if (pass == 2)
+    {
+      cfg.turbPatternStyle = TURB_WAVES;
+      cfg.turbFieldPersistence = 0.9f;
+      field.bake(t1);
+    }
+    for (uint16_t i = 0; i < TURB_FIELD_SIZE * TURB_FIELD_SIZE; ++i)
+    {
+      const float v = field.sample((i % TURB_FIELD_SIZE) / (TURB_FIELD_SIZE - 1.0f), (i / TURB_FIELD_SIZE) / (TURB_FIELD_SIZE - 1.0f)).value;
+      if (pass == 0)
+      {
+        oldField[i] = v;
+      }
+      else if (pass == 1)
+      {
+        newField[i] = v;
+      }
+      else
+      {
+        oldField[i] = fabsf(v - (newField[i] + (oldField[i] - newField[i]) * powf(0.9f, (t1 - t0) / cfg.timeStep)));
+      }
+    }
+  }
+  float worst = 0.0f;
+  for (uint16_t i = 0; i < TURB_FIELD_SIZE * TURB_FIELD_SIZE; ++i)
+  {
+    worst = fmaxf(worst, oldField[i]);
+  }
+  report("turbulence persistence blends bakes", worst < 1e-3f, worst);
+}
+
+// PIC/FLIP: the warm-started solve stops once the residual is within fluidTolerance (and runs
+// every sweep at tolerance 0), still fluid stays still, and a pile without particle collisions
+// keeps its volume instead of collapsing to the floor.
+static void checkFluid()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  float meanY[2] = {0.0f, 0.0f};
+  FluidStats stats = {};
+  bool finite = true;
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 300;
+    cfg.particleRadius = 0.015f;
+    cfg.gravityY = 1.0f;
+    cfg.collisionEnabled = false;
+    cfg.picFlipRatio = pass == 0 ? 0.0f : 0.5f;
+    randomSeed(1234);
+    sim.init();
+    float t = 0.0f;
+    for (uint16_t s = 0; s < 300; ++s)
+    {
+      sim.step(cfg.timeStep, t);
+      t += cfg.timeStep;
+    }
+    for (uint16_t i = 0; i < sim.getCount(); ++i)
+    {
+      meanY[pass] += sim.getY()[i] / sim.getCount();
+      finite = finite && isfinite(sim.getX()[i]) && isfinite(sim.getVx()[i]);
+    }
+    stats = sim.consumeFluidStats();
+    if (pass == 0)
+    {
+      finite = finite && stats.steps == 0;
+    }
+  }
+  // The residual is summed during each sweep, one sweep behind, so allow twice the tolerance.
+  report("fluid solve meets tolerance",
+         stats.steps == 300 && stats.divergenceOut < stats.divergenceIn * cfg.fluidTolerance * 2.0f &&
+             stats.sweeps < (uint32_t)cfg.fluidIterations * stats.steps,
+         stats.steps ? (float)stats.sweeps / stats.steps : 0.0f);
+
+  cfg.fluidTolerance = 0.0f;
+  cfg.fluidIterations = 10;
+  for (uint16_t s = 0; s < 20; ++s)
+  {
+    sim.step(cfg.timeStep, 0.0f);
+  }
+  stats = sim.consumeFluidStats();
+  report("fluid tolerance 0 runs every sweep", stats.sweeps == 200, (float)stats.sweeps);
+  report("fluid pile keeps volume", finite && meanY[1] < meanY[0] - 0.1f, meanY[0] - meanY[1]);
+
+  // One particle per cell (below restDensity), at rest and without gravity, must stay at rest.
+  static FluidFLIP fluid(&cfg);
+  static Boundary boundary(&cfg);
+  static Columns cols;
+  cfg = SimConfig();
+  cfg.picFlipRatio = 0.5f;
+  fluid.clear();
+  for (uint16_t i = 0; i < 100; ++i)
+  {
+    cols.x[i] = (3.5f + i % 10) / FLIP_GRID;
+    cols.y[i] = (3.5f + i / 10) / FLIP_GRID;
+    cols.vx[i] = 0.0f;
+    cols.vy[i] = 0.0f;
+  }
+  fluid.step(boundary, cols.x, cols.y, cols.vx, cols.vy, 100, cfg.timeStep);
+  float moving = 0.0f;
+  for (uint16_t i = 0; i < 100; ++i)
+  {
+    moving = fmaxf(moving, fabsf(cols.vx[i]) + fabsf(cols.vy[i]));
+  }
+  report("fluid at rest stays at rest", moving == 0.0f, moving);
+}
+
+static void checkVoronoi()
+{
+  static SimConfig cfg;
+  static Boundary boundary(&cfg);
+  static Voronoi voronoi(&cfg);
+  cfg = SimConfig();
+  cfg.voronoiStrength = 1.0f;
+  const float cellSize = 1.0f / VORONOI_GRID;
+
+  // Flooded nearest seed against the loop over every seed, at each cell center; ties count as hits.
+  const uint8_t seedCounts[] = {4, 16, 64};
+  float worstMiss = 0.0f;
+  float worstEdge = 0.0f;
+  for (uint8_t n = 0; n < sizeof(seedCounts); ++n)
+  {
+    cfg.voronoiCellCount = seedCounts[n];
+    voronoi.reset();
+    (void)voronoi.beginFrame(boundary, cfg.timeStep);
+    uint16_t misses = 0;
+    for (uint8_t j = 0; j < VORONOI_GRID; ++j)
+    {
+      for (uint8_t i = 0; i < VORONOI_GRID; ++i)
+      {
+        const float cx = (i + 0.5f) * cellSize;
+        const float cy = (j + 0.5f) * cellSize;
+        const uint8_t got = voronoi.getCellSeed(i, j);
+        const uint8_t want = voronoi.nearestSeed(cx, cy);
+        if (got != want)
+        {
+          ++misses;
+        }
+      }
+    }
+    worstMiss = fmaxf(worstMiss, (float)misses / VORONOI_CELLS);
+
+    // Sampled edge distance against the exact one; only the seed pair comes from the grid.
+    float err = 0.0f;
+    for (uint16_t k = 0; k < 2000; ++k)
+    {
+      const float x = randRange(0.0f, 1.0f);
+      const float y = randRange(0.0f, 1.0f);
+      float dist;
+      float dx;
+      float dy;
+      if (voronoi.edgeDistance(x, y, dist, dx, dy))
+      {
+        err += fabsf(dist - voronoi.edgeDistanceExact(x, y)) / 2000.0f;
+      }
+    }
+    worstEdge = fmaxf(worstEdge, err);
+  }
+  report("voronoi flood finds nearest seed", worstMiss < 0.02f, worstMiss);
+  report("voronoi edge distance", worstEdge < 0.25f * cellSize, worstEdge / cellSize);
+
+  // Pull mode gathers particles on the edges, push mode clears them off.
+  static SimCore sim(&cfg);
+  float edge[3] = {0.0f, 0.0f, 0.0f};
+  for (uint8_t mode = 0; mode < 2; ++mode)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 300;
+    cfg.collisionEnabled = false;
+    cfg.voronoiStrength = 5.0f;
+    cfg.voronoiCellSpeed = 0.0f;
+    cfg.voronoiPullMode = mode == 0;
+    randomSeed(1234);
+    sim.init();
+    float t = 0.0f;
+    for (uint16_t s = 0; s < 240; ++s)
+    {
+      sim.step(cfg.timeStep, t);
+      t += cfg.timeStep;
+      if (mode == 0 && s == 0)
+      {
+        for (uint16_t i = 0; i < sim.getCount(); ++i)
+        {
+          edge[2] += sim.getVoronoi().edgeDistanceExact(sim.getX()[i], sim.getY()[i]) / sim.getCount();
+        }
+      }
+    }
+    for (uint16_t i = 0; i < sim.getCount(); ++i)
+    {
+      edge[mode] += sim.getVoronoi().edgeDistanceExact(sim.getX()[i], sim.getY()[i]) / sim.getCount();
+    }
+  }
+  report("voronoi pull gathers on edges", edge[0] < edge[2] * 0.7f, edge[0] / edge[2]);
+  report("voronoi push clears edges", edge[1] > edge[2], edge[1] / edge[2]);
+}
+
+struct PairCounter
+{
+  uint32_t pairs;
+  uint32_t unordered;
+
+  void operator()(uint16_t i, uint16_t j, float, float, float)
+  {
+    ++pairs;
+    unordered += i >= j ? 1 : 0;
+  }
+};
+
+// Radius queries and pair iteration against loops over every particle, for radii below and
+// well above the cell size, and clustered points that pile into a few cells.
+static void checkNeighborGrid()
+{
+  static ParticleArena arena;
+  static NeighborGrid grid;
+  static float x[kCheckCount];
+  static float y[kCheckCount];
+  static uint16_t found[kCheckCount];
+  static float foundD2[kCheckCount];
+  static float wantD2[kCheckCount];
+  if (!arena.isReady())
+  {
+    arena.begin(0, NeighborGrid::storageBytes(kCheckCount));
+    grid.begin(arena, ARENA_BULK, kCheckCount);
+  }
+  uint32_t queryMisses = 0;
+  uint32_t pairMisses = 0;
+  uint32_t nearestMisses = 0;
+  for (uint8_t layout = 0; layout < 2; ++layout)
+  {
+    for (uint16_t i = 0; i < kCheckCount; ++i)
+    {
+      // Layout 1 keeps everything in one corner, partly outside [0,1]^2 (clamped to edge cells).
+      x[i] = layout == 0 ? randRange(0.0f, 1.0f) : randRange(-0.05f, 0.2f);
+      y[i] = layout == 0 ? randRange(0.0f, 1.0f) : randRange(-0.05f, 0.2f);
+    }
+    const float radii[] = {0.005f, 0.03f, 0.2f};
+    for (uint8_t k = 0; k < sizeof(radii) / sizeof(radii[0]); ++k)
+    {
+      const float radius = radii[k];
+      grid.build(x, y, kCheckCount, NeighborGrid::fitGridSize(0.02f, kCheckCount));
+      for (uint16_t q = 0; q < 50; ++q)
+      {
+        const float px = randRange(-0.1f, 1.1f);
+        const float py = randRange(-0.1f, 1.1f);
+        const uint16_t n = grid.queryRadius(px, py, radius, found, kCheckCount);
+        uint16_t want = 0;
+        for (uint16_t i = 0; i < kCheckCount; ++i)
+        {
+          const float dx = x[i] - px;
+          const float dy = y[i] - py;
+          want += dx * dx + dy * dy < radius * radius ? 1 : 0;
+        }
+        queryMisses += n > want ? n - want : want - n;
+
+        // k nearest around particle `self`: the first k of the sorted brute-force distances.
+        const uint16_t self = (uint16_t)(q * 20);
+        const uint8_t kNear = (uint8_t)(1 + q % 16);
+        const uint8_t got = grid.queryNearest(x[self], y[self], radius, self, kNear, found, foundD2);
+        uint16_t inside = 0;
+        for (uint16_t i = 0; i < kCheckCount; ++i)
+        {
+          const float dx = x[i] - x[self];
+          const float dy = y[i] - y[self];
+          const float d2 = dx * dx + dy * dy;
+          if (i != self && d2 < radius * radius)
+          {
+            uint16_t slot = inside++;
+            while (slot > 0 && wantD2[slot - 1] > d2)
+            {
+              wantD2[slot] = wantD2[slot - 1];
+              --slot;
+            }
+            wantD2[slot] = d2;
+          }
+        }
+        const uint16_t wantNear = inside < kNear ? inside : kNear;
+        nearestMisses += got > wantNear ? got - wantNear : wantNear - got;
+        for (uint8_t a = 0; a < got && a < wantNear; ++a)
+        {
+          nearestMisses += foundD2[a] != wantD2[a] || found[a] == self ? 1 : 0;
+        }
+      }
+      PairCounter counter = {0, 0};
+      grid.forEachPair(radius, counter);
+      uint32_t want = 0;
+      for (uint16_t i = 0; i < kCheckCount; ++i)
+      {
+        for (uint16_t j = i + 1; j < kCheckCount; ++j)
+        {
+          const float dx = x[j] - x[i];
+          const float dy = y[j] - y[i];
+          want += dx * dx + dy * dy < radius * radius ? 1 : 0;
+        }
+      }
+      pairMisses += (counter.pairs > want ? counter.pairs - want : want - counter.pairs) + counter.unordered;
+    }
+  }
+  report("neighbor grid radius queries", queryMisses == 0, (float)queryMisses);
+  report("neighbor grid pairs", pairMisses == 0, (float)pairMisses);
+  report("neighbor grid k nearest", nearestMisses == 0, (float)nearestMisses);
+}
+
+// calculateSwarmForces from organicForces.js in its 240 px space, over the k nearest
+// neighbours found by brute force; returns how many particles lie within radius.
+static uint16_t referenceSwarmForce(const SimConfig &cfg, const float *x, const float *y, const float *vx,
+                                    const float *vy, uint16_t n, uint16_t i, uint8_t k, float &fx, float &fy)
+{
+  static uint16_t order[SIM_PARTICLE_CAPACITY];
+  static float orderD2[SIM_PARTICLE_CAPACITY];
+  const float px = 240.0f;
+  const float radius = cfg.organicRadius * px;
+  uint16_t inside = 0;
+  for (uint16_t j = 0; j < n; ++j)
+  {
+    const float dx = (x[j] - x[i]) * px;
+    const float dy = (y[j] - y[i]) * px;
+    const float d2 = dx * dx + dy * dy;
+    if (j == i || d2 <= 0.0f || d2 >= radius * radius)
+    {
+      continue;
+    }
+    uint16_t slot = inside++;
+    while (slot > 0 && orderD2[slot - 1] > d2)
+    {
+      order[slot] = order[slot - 1];
+      orderD2[slot] = orderD2[slot - 1];
+      --slot;
+    }
+    order[slot] = j;
+    orderD2[slot] = d2;
+  }
+  double centerX = 0.0, centerY = 0.0, velX = 0.0, velY = 0.0, sepX = 0.0, sepY = 0.0;
+  const uint16_t count = inside < k ? inside : k;
+  for (uint16_t a = 0; a < count; ++a)
+  {
+    const uint16_t j = order[a];
+    const double dx = (x[j] - x[i]) * px;
+    const double dy = (y[j] - y[i]) * px;
+    const double dist = sqrt(dx * dx + dy * dy);
+    const double repulsion = 1.0 / (dist + 1.0);
+    sepX -= dx / dist * repulsion;
+    sepY -= dy / dist * repulsion;
+    centerX += x[j] * px;
+    centerY += y[j] * px;
+    velX += vx[j] * px;
+    velY += vy[j] * px;
+  }
+  fx = 0.0f;
+  fy = 0.0f;
+  if (count == 0)
+  {
+    return inside;
+  }
+  centerX = centerX / count - x[i] * px;
+  centerY = centerY / count - y[i] * px;
+  const double centerDist = sqrt(centerX * centerX + centerY * centerY);
+  const double velDist = sqrt(velX * velX + velY * velY);
+  const double sepDist = sqrt(sepX * sepX + sepY * sepY);
+  double forceX = (centerDist > 0.0 ? centerX / centerDist : 0.0) * cfg.swarmCohesion * 0.05 +
+                  (velDist > 0.0 ? velX / velDist : 0.0) * cfg.swarmAlignment * 0.05 +
+                  (sepDist > 0.0 ? sepX / sepDist : 0.0) * cfg.swarmSeparation * 0.05;
+  double forceY = (centerDist > 0.0 ? centerY / centerDist : 0.0) * cfg.swarmCohesion * 0.05 +
+                  (velDist > 0.0 ? velY / velDist : 0.0) * cfg.swarmAlignment * 0.05 +
+                  (sepDist > 0.0 ? sepY / sepDist : 0.0) * cfg.swarmSeparation * 0.05;
+  const double magnitude = sqrt(forceX * forceX + forceY * forceY);
+  if (magnitude > cfg.swarmMaxSpeed)
+  {
+    forceX *= cfg.swarmMaxSpeed / magnitude;
+    forceY *= cfg.swarmMaxSpeed / magnitude;
+  }
+  fx = (float)(forceX * 0.85);
+  fy = (float)(forceY * 0.85);
+  return inside;
+}
+
+// Swarm velocity changes against the JS formula: with swarmNeighbors above every particle's
+// neighbour count it is the JS exactly, with a small cap the k nearest of the brute-force list.
+static void checkSwarm()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static OrganicBehavior organic(&cfg);
+  static float vx0[SIM_PARTICLE_CAPACITY];
+  static float vy0[SIM_PARTICLE_CAPACITY];
+  cfg = SimConfig();
+  cfg.particleCount = 300;
+  cfg.gravityY = 1.0f;
+  cfg.turbStrength = 2.0f;
+  cfg.organicBehavior = ORGANIC_SWARM;
+  cfg.organicRadius = 0.09f;
+  cfg.swarmMaxSpeed = 0.1f;
+  randomSeed(4321);
+  sim.init();
+  organic.begin(sim.getCapacity());
+  float t = 0.0f;
+  for (uint16_t s = 0; s < 30; ++s)
+  {
+    sim.step(cfg.timeStep, t);
+    t += cfg.timeStep;
+  }
+  const uint16_t n = sim.getCount();
+  const uint8_t caps[] = {SWARM_MAX_NEIGHBORS, 4};
+  for (uint8_t c = 0; c < sizeof(caps); ++c)
+  {
+    cfg.swarmNeighbors = caps[c];
+    memcpy(vx0, sim.getVx(), n * sizeof(float));
+    memcpy(vy0, sim.getVy(), n * sizeof(float));
+    organic.apply(sim, cfg.timeStep);
+    float worst = 0.0f;
+    uint16_t crowded = 0;
+    for (uint16_t i = 0; i < n; ++i)
+    {
+      float fx = 0.0f;
+      float fy = 0.0f;
+      const uint16_t inside = referenceSwarmForce(cfg, sim.getX(), sim.getY(), vx0, vy0, n, i, caps[c], fx, fy);
+      crowded = inside > crowded ? inside : crowded;
+      worst = fmaxf(worst, fabsf(sim.getVx()[i] - vx0[i] - fx * cfg.timeStep));
+      worst = fmaxf(worst, fabsf(sim.getVy()[i] - vy0[i] - fy * cfg.timeStep));
+    }
+    const OrganicStats stats = organic.consumeStats();
+    Serial.printf("[check] swarm k=%u: up to %u in radius, %.1f used per particle\n", (unsigned)caps[c],
+                  (unsigned)crowded, stats.particles ? (float)stats.neighbors / stats.particles : 0.0f);
+    // The uncapped case only tests the JS formula if no particle had more neighbours than k.
+    const bool covered = c > 0 || crowded <= caps[c];
+    report(c == 0 ? "swarm matches the JS forces" : "swarm keeps the k nearest", covered && worst < 1e-6f, worst);
+  }
+}
+
+// Link table consistency: both ends hold each link, no self or repeated partners, at most
+// `branches` per particle, every partner in range and shorter than the radius. Returns the
+// number of violations and the total number of links.
+static uint32_t chainLinkErrors(const OrganicBehavior &organic, const SimCore &sim, float radius, uint8_t branches,
+                                uint32_t &links)
+{
+  uint32_t errors = 0;
+  links = 0;
+  const uint16_t n = sim.getCount();
+  for (uint16_t i = 0; i < n; ++i)
+  {
+    const uint8_t count = organic.getLinkCount(i);
+    const uint16_t *partners = organic.getLinks(i);
+    errors += count > branches ? 1 : 0;
+    links += count;
+    for (uint8_t a = 0; a < count; ++a)
+    {
+      const uint16_t j = partners[a];
+      if (j >= n || j == i)
+      {
+        ++errors;
+        continue;
+      }
+      bool back = false;
+      for (uint8_t b = 0; b < organic.getLinkCount(j); ++b)
+      {
+        back = back || organic.getLinks(j)[b] == i;
+      }
+      for (uint8_t b = a + 1; b < count; ++b)
+      {
+        errors += partners[b] == j ? 1 : 0;
+      }
+      const float dx = sim.getX()[j] - sim.getX()[i];
+      const float dy = sim.getY()[j] - sim.getY()[i];
+      errors += !back || dx * dx + dy * dy >= radius * radius ? 1 : 0;
+    }
+  }
+  links /= 2;
+  return errors;
+}
+
+// Chain links stay consistent while particles move, a count change and a lowered branch limit,
+// persist between frames, and only linked particles feel a chain force.
+static void checkChain()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static OrganicBehavior organic(&cfg);
+  static float vx0[SIM_PARTICLE_CAPACITY];
+  static float vy0[SIM_PARTICLE_CAPACITY];
+  cfg = SimConfig();
+  cfg.particleCount = 400;
+  cfg.gravityY = 0.5f;
+  cfg.organicBehavior = ORGANIC_CHAIN;
+  cfg.organicRadius = 0.06f;
+  cfg.chainLinkDistance = 0.04f;
+  cfg.chainBranches = 3;
+  randomSeed(2468);
+  sim.init();
+  organic.begin(sim.getCapacity());
+  uint32_t errors = 0;
+  uint32_t links = 0;
+  float t = 0.0f;
+  for (uint16_t s = 0; s < 240; ++s)
+  {
+    if (s == 80)
+    {
+      cfg.particleCount = 300;
+    }
+    if (s == 160)
+    {
+      cfg.chainBranches = 2;
+    }
+    sim.step(cfg.timeStep, t);
+    t += cfg.timeStep;
+    organic.apply(sim, cfg.timeStep);
+    errors += chainLinkErrors(organic, sim, cfg.organicRadius, cfg.chainBranches, links);
+  }
+  report("chain links consistent", errors == 0 && links > 0, (float)errors);
+
+  // One more frame: only a few links change, and unlinked particles keep their velocity.
+  (void)organic.consumeStats();
+  sim.step(cfg.timeStep, t);
+  const uint16_t n = sim.getCount();
+  memcpy(vx0, sim.getVx(), n * sizeof(float));
+  memcpy(vy0, sim.getVy(), n * sizeof(float));
+  organic.apply(sim, cfg.timeStep);
+  const OrganicStats stats = organic.consumeStats();
+  uint16_t strayForces = 0;
+  for (uint16_t i = 0; i < n; ++i)
+  {
+    const bool moved = sim.getVx()[i] != vx0[i] || sim.getVy()[i] != vy0[i];
+    strayForces += organic.getLinkCount(i) == 0 && moved ? 1 : 0;
+  }
+  Serial.printf("[check] chain: %lu links, %lu made / %lu broken in the last frame\n", (unsigned long)links,
+                (unsigned long)stats.linksMade, (unsigned long)stats.linksBroken);
+  report("chain links persist between frames", stats.linksMade + stats.linksBroken < links / 4,
+         (float)(stats.linksMade + stats.linksBroken));
+  report("chain forces only over links", strayForces == 0, (float)strayForces);
+}
+
+// Brute-force cell value of ProximityB (mode 2) and Collision (mode 7), as GridModes computed
+// them before the neighbor grid: every particle against every cell, pairs against every particle.
+static float referenceContribution(float px, float py, float cx, float cy, float halfW, float halfH, float radius)
+{
+  const float dx = fmaxf(fabsf(px - cx) - halfW, 0.0f);
+  const float dy = fmaxf(fabsf(py - cy) - halfH, 0.0f);
+  const float d = sqrtf(dx * dx + dy * dy);
+  return d < radius ? 1.0f - d / radius : 0.0f;
+}
+
+static float referenceCellValue(const SimConfig &cfg, const ParticleView &view, uint8_t mode, float cx, float cy,
+                                float halfW, float halfH)
+{
+  const float *x = view.getX();
+  const float *y = view.getY();
+  const float *r = view.getRadius();
+  const uint16_t n = view.getCount();
+  float sum = 0.0f;
+  float weightSum = 0.0f;
+  for (uint16_t i = 0; i < n; ++i)
+  {
+    const float ri = r ? r[i] : cfg.particleRadius;
+    const float w = referenceContribution(x[i], y[i], cx, cy, halfW, halfH, ri * (mode == 2 ? 3.0f : 2.0f));
+    if (w <= 0.0f)
+    {
+      continue;
+    }
+    for (uint16_t j = i + 1; j < n; ++j)
+    {
+      const float rj = r ? r[j] : cfg.particleRadius;
+      const float reach = (ri + rj) * 2.0f;
+      const float dx = x[j] - x[i];
+      const float dy = y[j] - y[i];
+      const float d = sqrtf(dx * dx + dy * dy);
+      if (d >= reach)
+      {
+        continue;
+      }
+      if (mode == 2)
+      {
+        sum += (1.0f - d / reach) * w;
+        weightSum += w;
+        continue;
+      }
+      const float wj = referenceContribution(x[j], y[j], cx, cy, halfW, halfH, rj * 2.0f);
+      if (wj <= 0.0f)
+      {
+        continue;
+      }
+      const float dvx = view.getVx()[j] - view.getVx()[i];
+      const float dvy = view.getVy()[j] - view.getVy()[i];
+      sum += (1.0f - d / reach) * sqrtf(dvx * dvx + dvy * dvy) * (w + wj) * 0.5f;
+    }
+  }
+  if (mode == 2)
+  {
+    return weightSum > 1e-6f ? (sum / weightSum) * (2.0f / cfg.maxDensity) : 0.0f;
+  }
+  return sum / (cfg.maxVelocity * cfg.maxDensity);
+}
+
+// The grid-backed pair modes against the brute-force reference (1/255 of rounding allowed),
+// on a grid GridModes bins itself and on the sim's shared one, with uniform and mixed sizes.
+// Also checks that collision takes the grid the frame's consumers binned instead of its own.
+static void checkGridModes()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static GridGeometry geom(&cfg);
+  static GridModes modes(&cfg);
+  static uint8_t values[MAX_GRID_CELLS];
+  cfg = SimConfig();
+  cfg.particleCount = 400;
+  cfg.particleRadius = 0.015f;
+  cfg.gravityY = 1.0f;
+  cfg.turbStrength = 2.0f;
+  cfg.smoothRateIn = 1.0f;
+  cfg.smoothRateOut = 1.0f;
+  randomSeed(1234);
+  sim.init();
+  modes.begin(sim.getCapacity());
+  geom.rebuild();
+  const float halfW = 0.5f / geom.getCols();
+  const float halfH = 0.5f / geom.getRows();
+  uint16_t worst = 0;
+  uint32_t lit = 0;
+  float t = 0.0f;
+  for (uint8_t run = 0; run < 4; ++run)
+  {
+    cfg.turbAffectScale = run >= 2;
+    for (uint16_t s = 0; s < 60; ++s)
+    {
+      sim.step(cfg.timeStep, t);
+      t += cfg.timeStep;
+    }
+    if (run % 2 == 1)
+    {
+      (void)sim.getNeighbors();
+    }
+    const ParticleView view = sim.getView();
+    const uint8_t pairModes[] = {2, 7};
+    for (uint8_t m = 0; m < sizeof(pairModes); ++m)
+    {
+      cfg.gridMode = pairModes[m];
+      modes.compute(view, geom, values, MAX_GRID_CELLS);
+      for (uint16_t c = 0; c < geom.getCellCount(); ++c)
+      {
+        const float v = referenceCellValue(cfg, view, pairModes[m], geom.getCells()[c].x, geom.getCells()[c].y, halfW, halfH);
+        const int want = (int)(fminf(fmaxf(v, 0.0f), 1.0f) * 255.0f);
+        const int diff = values[c] > want ? values[c] - want : want - values[c];
+        worst = diff > worst ? diff : worst;
+        lit += want > 0 ? 1 : 0;
+      }
+    }
+  }
+  Serial.printf("[check] grid modes: %lu lit cells over 8 frames\n", (unsigned long)lit);
+  report("grid modes match brute force", worst <= 1 && lit > 0, (float)worst);
+
+  // With the list off collision needs the grid every step. The first step takes the one
+  // getNeighbors() binned for the organic behaviors, the second bins its own, and the final
+  // getNeighbors() bins the new positions: 2 builds, 3 if the first step had built too.
+  cfg.collisionSkin = 0.0f;
+  cfg.turbAffectScale = false;
+  sim.step(cfg.timeStep, t);
+  const uint32_t before = sim.getNeighbors().getBuilds();
+  sim.stepStaged(cfg.timeStep, t);
+  sim.stepStaged(cfg.timeStep, t);
+  const uint32_t builds = sim.getNeighbors().getBuilds() - before;
+  report("collision reuses the shared grid", builds == 2, (float)builds);
+}
+
+// Automata force and next state of particle i from every other particle, as the JS loops do it
+// (per particle, no pair symmetry) but on the quantized states.
+static uint8_t referenceAutomata(const SimConfig &cfg, const float *x, const float *y, const uint32_t *states,
+                                 uint16_t n, uint16_t i, float &fx, float &fy)
+{
+  const uint8_t si = readParticleState(states, i);
+  const float threshold = cfg.automataThreshold * PARTICLE_STATE_MAX;
+  double forceX = 0.0;
+  double forceY = 0.0;
+  uint32_t neighbors = 0;
+  uint32_t sum = 0;
+  for (uint16_t j = 0; j < n; ++j)
+  {
+    const float dx = x[j] - x[i];
+    const float dy = y[j] - y[i];
+    const float d2 = dx * dx + dy * dy;
+    if (j == i || d2 <= 0.0f || d2 >= cfg.organicRadius * cfg.organicRadius)
+    {
+      continue;
+    }
+    const uint8_t sj = readParticleState(states, j);
+    const double dist = sqrt((double)d2);
+    const double mag = (abs(sj - si) < threshold ? cfg.automataAttraction : -cfg.automataRepulsion) *
+                       (1.0 - dist / cfg.organicRadius);
+    forceX += dx / dist * mag;
+    forceY += dy / dist * mag;
+    ++neighbors;
+    sum += sj;
+  }
+  fx = (float)(fmax(-0.5, fmin(0.5, forceX)) * 0.1 * 0.85);
+  fy = (float)(fmax(-0.5, fmin(0.5, forceY)) * 0.1 * 0.85);
+  int state = si;
+  const float gap = neighbors ? (float)sum / neighbors - si : 0.0f;
+  if (neighbors && fabsf(gap) > threshold)
+  {
+    const int step = (int)lroundf(gap * 0.1f);
+    state += step != 0 ? step : (gap > 0.0f ? 1 : -1);
+  }
+  return (uint8_t)(state < 0 ? 0 : (state > PARTICLE_STATE_MAX ? PARTICLE_STATE_MAX : state));
+}
+
+// Automata forces and state updates against the per-particle reference across frames and a
+// count change, states kept through particle removal; the states reach views and snapshots, and GridModes' Automata channel (mode 9)
+// matches a brute-force coverage-weighted mean on both.
+static void checkAutomata()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static OrganicBehavior organic(&cfg);
+  static GridGeometry geom(&cfg);
+  static GridModes modes(&cfg);
+  static SnapshotBuffer buffer;
+  static uint32_t before[(SIM_PARTICLE_CAPACITY + PARTICLE_STATES_PER_WORD - 1) / PARTICLE_STATES_PER_WORD];
+  static float vx0[SIM_PARTICLE_CAPACITY];
+  static float vy0[SIM_PARTICLE_CAPACITY];
+  static float x0[SIM_PARTICLE_CAPACITY];
+  static float y0[SIM_PARTICLE_CAPACITY];
+  static uint8_t live[MAX_GRID_CELLS];
+  static uint8_t snap[MAX_GRID_CELLS];
+  cfg = SimConfig();
+  cfg.particleCount = 400;
+  cfg.gravityY = 0.5f;
+  cfg.organicBehavior = ORGANIC_AUTOMATA;
+  cfg.organicRadius = 0.09f;
+  cfg.gridMode = 9;
+  cfg.smoothRateIn = 1.0f;
+  cfg.smoothRateOut = 1.0f;
+  randomSeed(1357);
+  sim.init();
+  organic.begin(sim.getCapacity());
+  modes.begin(sim.getCapacity());
+  buffer.begin(sim.getCapacity());
+  geom.rebuild();
+
+  float worstForce = 0.0f;
+  uint32_t stateErrors = 0;
+  uint32_t changed = 0;
+  float t = 0.0f;
+  for (uint16_t s = 0; s < 120; ++s)
+  {
+    if (s == 60)
+    {
+      cfg.particleCount = 450;
+    }
+    sim.step(cfg.timeStep, t);
+    t += cfg.timeStep;
+    const uint16_t n = sim.getCount();
+    // Not on the frame the count changes, whose new particles are seeded inside apply().
+    const bool verify = s % 20 == 10;
+    if (verify)
+    {
+      memcpy(before, organic.getStates(), particleStateWords(n) * sizeof(uint32_t));
+      memcpy(vx0, sim.getVx(), n * sizeof(float));
+      memcpy(vy0, sim.getVy(), n * sizeof(float));
+    }
+    organic.apply(sim, cfg.timeStep);
+    if (!verify)
+    {
+      continue;
+    }
+    for (uint16_t i = 0; i < n; ++i)
+    {
+      float fx = 0.0f;
+      float fy = 0.0f;
+      const uint8_t next = referenceAutomata(cfg, sim.getX(), sim.getY(), before, n, i, fx, fy);
+      worstForce = fmaxf(worstForce, fabsf(sim.getVx()[i] - vx0[i] - fx * cfg.timeStep));
+      worstForce = fmaxf(worstForce, fabsf(sim.getVy()[i] - vy0[i] - fy * cfg.timeStep));
+      stateErrors += organic.getState(i) != next ? 1 : 0;
+      changed += organic.getState(i) != readParticleState(before, i) ? 1 : 0;
+    }
+  }
+  Serial.printf("[check] automata: %lu state changes over 6 checked frames\n", (unsigned long)changed);
+  report("automata forces match the reference", worstForce < 1e-6f, worstForce);
+  report("automata states match the reference", stateErrors == 0 && changed > 0, (float)stateErrors);
+
+  // Lowering the count swap-removes random particles; every survivor keeps its own state. A
+  // zero-length step without collision leaves every survivor where it was (up to the boundary
+  // clamp's rounding), which tells which pre-step particle it is.
+  {
+    const uint16_t n = sim.getCount();
+    memcpy(before, organic.getStates(), particleStateWords(n) * sizeof(uint32_t));
+    memcpy(x0, sim.getX(), n * sizeof(float));
+    memcpy(y0, sim.getY(), n * sizeof(float));
+    cfg.collisionEnabled = false;
+    cfg.particleCount = 250;
+    sim.step(0.0f, t);
+    cfg.collisionEnabled = true;
+    uint16_t moved = 0;
+    uint16_t lost = 0;
+    for (uint16_t j = 0; j < sim.getCount(); ++j)
+    {
+      uint16_t match = 0;
+      float best = 1e9f;
+      for (uint16_t i = 0; i < n; ++i)
+      {
+        const float dx = sim.getX()[j] - x0[i];
+        const float dy = sim.getY()[j] - y0[i];
+        if (dx * dx + dy * dy < best)
+        {
+          best = dx * dx + dy * dy;
+          match = i;
+        }
+      }
+      lost += best > 1e-10f ? 1 : 0;
+      moved += match != j ? 1 : 0;
+      lost += organic.getState(j) != readParticleState(before, match) ? 1 : 0;
+    }
+    Serial.printf("[check] automata removal: %u of %u survivors moved to a new index\n", (unsigned)moved,
+                  (unsigned)sim.getCount());
+    report("automata states follow removal", lost == 0 && moved > 0, (float)lost);
+    organic.apply(sim, cfg.timeStep);
+  }
+
+  // Mode 9 on the live view and on a snapshot of it, against the brute-force cell mean.
+  const ParticleView view = sim.getView();
+  buffer.publish(view, 1);
+  const ParticleView copy = buffer.acquire();
+  report("automata states reach views", view.getStates() == organic.getStates() && copy.getStates() != nullptr,
+         0.0f);
+  modes.compute(view, geom, live, MAX_GRID_CELLS);
+  modes.compute(copy, geom, snap, MAX_GRID_CELLS);
+  const float halfW = 0.5f / geom.getCols();
+  const float halfH = 0.5f / geom.getRows();
+  int worst = 0;
+  uint32_t lit = 0;
+  for (uint16_t c = 0; c < geom.getCellCount(); ++c)
+  {
+    float coverage = 0.0f;
+    float accum = 0.0f;
+    for (uint16_t i = 0; i < view.getCount(); ++i)
+    {
+      const float w = referenceContribution(view.getX()[i], view.getY()[i], geom.getCells()[c].x, geom.getCells()[c].y,
+                                            halfW, halfH, cfg.particleRadius * 2.0f);
+      coverage += w;
+      accum += (readParticleState(view.getStates(), i) + 1) * w;
+    }
+    const float v = coverage > 0.0f ? accum / (coverage * 16.0f) * fminf(coverage, 1.0f) : 0.0f;
+    const int want = (int)(fminf(v, 1.0f) * 255.0f);
+    const int diff = abs(live[c] - want) > abs(snap[c] - want) ? abs(live[c] - want) : abs(snap[c] - want);
+    worst = diff > worst ? diff : worst;
+    lit += want > 0 ? 1 : 0;
+  }
+  Serial.printf("[check] automata grid: %lu lit cells\n", (unsigned long)lit);
+  report("automata grid mode matches brute force", worst <= 1 && lit > 0, (float)worst);
+
+  // Leaving the behavior takes the channel away again.
+  cfg.organicBehavior = ORGANIC_NONE;
+  organic.apply(sim, cfg.timeStep);
+  report("automata states cleared on exit", sim.getView().getStates() == nullptr, 0.0f);
+}
+
+// Producer thread publishes frames where every lane equals the frame number;
+// a torn read would show mixed values inside one snapshot.
+static void checkSnapshotBuffer()
+{
+  static SnapshotBuffer buffer;
+  static Columns src;
+  buffer.begin(kCheckCount);
+
+  std::atomic<bool> done{false};
+  std::thread producer([&]() {
+    for (uint32_t frame = 1; frame <= 20000; ++frame)
+    {
+      for (uint16_t i = 0; i < kCheckCount; ++i)
+      {
+        src.x[i] = src.y[i] = src.vx[i] = src.vy[i] = (float)frame;
+      }
+      buffer.publish(ParticleView(src.x, src.y, src.vx, src.vy, kCheckCount), frame);
+    }
+    done.store(true);
+  });
+
+  uint32_t torn = 0;
+  uint32_t regressions = 0;
+  uint32_t reads = 0;
+  uint32_t lastFrame = 0;
+  while (!done.load() || reads == 0)
+  {
+    const ParticleView v = buffer.acquire();
+    const uint32_t frame = buffer.getFrame();
+    if (v.getCount() == 0)
+    {
+      continue;
+    }
+    ++reads;
+    if (frame < lastFrame)
+    {
+      ++regressions;
+    }
+    lastFrame = frame;
+    const float expect = (float)frame;
+    for (uint16_t i = 0; i < v.getCount(); ++i)
+    {
+      if (v.getX()[i] != expect || v.getY()[i] != expect || v.getVx()[i] != expect || v.getVy()[i] != expect)
+      {
+        ++torn;
+        break;
+      }
+    }
+  }
+  producer.join();
+  const ParticleView last = buffer.acquire();
+  report("snapshot no torn reads", torn == 0, (float)torn);
+  report("snapshot frames monotonic", regressions == 0, (float)regressions);
+  report("snapshot ends on last frame", buffer.getFrame() == 20000 && last.getX()[0] == 20000.0f, (float)buffer.getFrame());
+}
+
+// Every field of a sample carries the same counter, so a reader mixing two samples shows up.
+static void checkInputMailbox()
+{
+  static InputMailbox mailbox;
+  std::atomic<bool> done{false};
+  std::thread producer([&]() {
+    for (uint16_t n = 1; n <= 20000; ++n)
+    {
+      const SimInputs in = {n, n, (n & 1) != 0, (float)n, (float)n, (float)n};
+      mailbox.publish(in);
+    }
+    done.store(true);
+  });
+
+  uint32_t torn = 0;
+  uint32_t regressions = 0;
+  uint16_t last = 0;
+  while (!done.load())
+  {
+    const SimInputs &in = mailbox.acquire();
+    if (in.touchY != in.touchX || in.touching != ((in.touchX & 1) != 0) || in.accelX != (float)in.touchX ||
+        in.accelY != (float)in.touchX || in.accelZ != (float)in.touchX)
+    {
+      ++torn;
+    }
+    if (in.touchX < last)
+    {
+      ++regressions;
+    }
+    last = in.touchX;
+  }
+  producer.join();
+  report("input mailbox no torn reads", torn == 0, (float)torn);
+  report("input mailbox samples monotonic", regressions == 0, (float)regressions);
+  report("input mailbox ends on last sample", mailbox.acquire().touchX == 20000, (float)mailbox.acquire().touchX);
+}
+
+// 64 overlapping particles in one collision cell: all must be resolved (the old
+// bucketed grid kept only the first 32 per cell).
+static void checkCollisionCellOverflow()
+{
+  static SimConfig cfg;
+  cfg = SimConfig();
+  cfg.collisionGridAuto = false;
+  cfg.collisionGridSize = 4;
+  static ParticleArena arena;
+  static NeighborGrid grid;
+  static Collision collision(&cfg);
+  static float x[64], y[64], vx[64], vy[64];
+  if (!arena.isReady())
+  {
+    arena.begin(NeighborGrid::storageBytes(64) + Collision::indexStorageBytes(64), Collision::listStorageBytes(64));
+    grid.begin(arena, ARENA_HOT, 64);
+    collision.begin(arena, ARENA_HOT, 64, grid);
+  }
+  const float radius = 0.01f;
+  const char *names[] = {"collision resolves full cell (grid)", "collision resolves full cell (verlet)"};
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    cfg.collisionSkin = pass == 0 ? 0.0f : 0.5f;
+    for (uint16_t i = 0; i < 64; ++i)
+    {
+      x[i] = 0.05f + (i % 8) * 1.6f * radius;
+      y[i] = 0.05f + (i / 8) * 1.6f * radius;
+      vx[i] = 0.0f;
+      vy[i] = 0.0f;
+    }
+    collision.invalidate();
+    collision.resolve(x, y, vx, vy, 64, radius);
+    uint16_t untouched = 0;
+    for (uint16_t i = 0; i < 64; ++i)
+    {
+      if (x[i] == 0.05f + (i % 8) * 1.6f * radius && y[i] == 0.05f + (i / 8) * 1.6f * radius)
+      {
+        ++untouched;
+      }
+    }
+    report(names[pass], untouched == 0, (float)untouched);
+  }
+}
+
+static float sumOverlapRatio(const SimCore &sim, float radius)
+{
+  float sum = 0.0f;
+  const float minDist = 2.0f * radius;
+  for (uint16_t i = 0; i < sim.getCount(); ++i)
+  {
+    for (uint16_t j = i + 1; j < sim.getCount(); ++j)
+    {
+      const float dx = sim.getX()[j] - sim.getX()[i];
+      const float dy = sim.getY()[j] - sim.getY()[i];
+      const float d = sqrtf(dx * dx + dy * dy);
+      if (d < minDist)
+      {
+        sum += (minDist - d) / minDist;
+      }
+    }
+  }
+  return sum;
+}
+
+static float maxOverlapRatio(const SimCore &sim, float radius)
+{
+  float worst = 0.0f;
+  const float minDist = 2.0f * radius;
+  for (uint16_t i = 0; i < sim.getCount(); ++i)
+  {
+    for (uint16_t j = i + 1; j < sim.getCount(); ++j)
+    {
+      const float dx = sim.getX()[j] - sim.getX()[i];
+      const float dy = sim.getY()[j] - sim.getY()[i];
+      const float d = sqrtf(dx * dx + dy * dy);
+      if (d < minDist)
+      {
+        worst = fmaxf(worst, (minDist - d) / minDist);
+      }
+    }
+  }
+  return worst;
+}
+
+// A calm scene with and without the Verlet list: same overlap quality, far fewer grid rebuilds.
+static void checkVerletList()
+{
+  static SimConfig gridCfg;
+  static SimConfig listCfg;
+  gridCfg = SimConfig();
+  gridCfg.particleCount = 300;
+  gridCfg.particleRadius = 0.015f;
+  gridCfg.collisionSkin = 0.0f;
+  listCfg = gridCfg;
+  listCfg.collisionSkin = 0.5f;
+  static SimCore gridSim(&gridCfg);
+  static SimCore listSim(&listCfg);
+  randomSeed(11);
+  gridSim.init();
+  randomSeed(11);
+  listSim.init();
+  for (uint16_t i = 0; i < 600; ++i)
+  {
+    gridSim.step(gridCfg.timeStep, i * gridCfg.timeStep);
+    listSim.step(listCfg.timeStep, i * listCfg.timeStep);
+  }
+  (void)gridSim.consumeCollisionStats();
+  (void)listSim.consumeCollisionStats();
+  for (uint16_t i = 600; i < 900; ++i)
+  {
+    gridSim.step(gridCfg.timeStep, i * gridCfg.timeStep);
+    listSim.step(listCfg.timeStep, i * listCfg.timeStep);
+  }
+  const CollisionStats g = gridSim.consumeCollisionStats();
+  const CollisionStats l = listSim.consumeCollisionStats();
+  const float gridOverlap = maxOverlapRatio(gridSim, gridCfg.particleRadius);
+  const float listOverlap = maxOverlapRatio(listSim, listCfg.particleRadius);
+  Serial.printf("[check] verlet calm: rebuild %.0f%% vs %.0f%% | pairs %lu vs %lu | overlap %.3f vs %.3f | overflow %lu\n",
+                100.0f * l.rebuilds / l.steps, 100.0f * g.rebuilds / g.steps,
+                (unsigned long)(l.pairsTested / l.steps), (unsigned long)(g.pairsTested / g.steps),
+                listOverlap, gridOverlap, (unsigned long)l.overflows);
+  report("verlet rebuilds less than every step", l.rebuilds * 2 < l.steps, (float)l.rebuilds / l.steps);
+  report("verlet overlap no worse than grid", listOverlap <= gridOverlap * 1.25f + 0.02f, listOverlap);
+  report("relaxation exits early when calm", l.passes < l.steps * 2, (float)l.passes / l.steps);
+}
+
+// Same frames through a steady and a jittery wall clock must give bit-identical particles.
+static void checkSubstepScheduler()
+{
+  static SimConfig cfg;
+  cfg = SimConfig();
+  cfg.particleCount = 150;
+  cfg.gravityY = 1.5f;
+  cfg.turbStrength = 3.0f;
+  static SimCore steady(&cfg);
+  static SimCore jittery(&cfg);
+  randomSeed(7);
+  steady.init();
+  randomSeed(7);
+  jittery.init();
+
+  SubstepScheduler steadyClock(&cfg, 60.0f);
+  SubstepScheduler jitterClock(&cfg, 60.0f);
+  uint32_t steadyFrames = 0;
+  while (steadyFrames < 180)
+  {
+    const uint8_t due = steadyClock.advance(steadyClock.getFrameMs(), 4);
+    for (uint8_t f = 0; f < due; ++f, ++steadyFrames)
+    {
+      steadyClock.runFrame(steady);
+    }
+  }
+  uint32_t jitterFrames = 0;
+  while (jitterFrames < steadyFrames)
+  {
+    const uint8_t due = jitterClock.advance(randRange(0.5f, 60.0f), 4);
+    for (uint8_t f = 0; f < due && jitterFrames < steadyFrames; ++f, ++jitterFrames)
+    {
+      jitterClock.runFrame(jittery);
+    }
+  }
+  float d = 0.0f;
+  for (uint16_t i = 0; i < steady.getCount(); ++i)
+  {
+    d = fmaxf(d, fabsf(steady.getX()[i] - jittery.getX()[i]));
+    d = fmaxf(d, fabsf(steady.getY()[i] - jittery.getY()[i]));
+  }
+  report("scheduler jitter-independent", d == 0.0f && steadyClock.getSimTimeSec() == jitterClock.getSimTimeSec(), d);
+
+  cfg.maxSubsteps = 6;
+  const float fast = 3.5f * cfg.substepCfl * cfg.particleRadius / (cfg.timeStep * cfg.timeScale);
+  report("scheduler calm frame is one substep", steadyClock.planSubsteps(0.0f, cfg.particleRadius) == 1, (float)steadyClock.planSubsteps(0.0f, cfg.particleRadius));
+  report("scheduler fast frame substeps", steadyClock.planSubsteps(fast, cfg.particleRadius) == 4, (float)steadyClock.planSubsteps(fast, cfg.particleRadius));
+  report("scheduler substeps capped", steadyClock.planSubsteps(fast * 10.0f, cfg.particleRadius) == 6, (float)steadyClock.planSubsteps(fast * 10.0f, cfg.particleRadius));
+
+  SubstepScheduler stall(&cfg, 60.0f);
+  const uint8_t due = stall.advance(250.0f, 4);
+  const float expected = 250.0f - 4.0f * stall.getFrameMs() - fmodf(100.0f, stall.getFrameMs());
+  const SchedulerStats stats = stall.consumeStats();
+  report("scheduler reports dropped time", due == 4 && fabsf(stats.droppedMs - expected) < 0.01f, stats.droppedMs);
+}
+
+static SimCore *gTaskSim = nullptr;
+static SimConfig gTaskConfig;
+static SubstepScheduler gTaskScheduler(&gTaskConfig, 240.0f);
+
+static void taskStep(float nowSec)
+{
+  (void)nowSec;
+  gTaskScheduler.runFrame(*gTaskSim);
+}
+
+// SimTask on a std::thread: physics advances while this thread only reads snapshots.
+static void checkSimTask()
+{
+  gTaskConfig = SimConfig();
+  gTaskConfig.particleCount = 200;
+  gTaskConfig.gravityY = 1.0f;
+  static SimCore sim(&gTaskConfig);
+  static SnapshotBuffer buffer;
+  static SimTask task;
+  gTaskSim = &sim;
+  sim.init();
+  buffer.begin(sim.getCapacity());
+
+  const bool started = task.start(&sim, &buffer, &gTaskScheduler, taskStep, 0);
+  const float radius = 0.5f * gTaskConfig.boundaryScale + 1e-4f;
+  uint32_t outOfBounds = 0;
+  const uint32_t startMs = millis();
+  while (millis() - startMs < 250)
+  {
+    const ParticleView v = buffer.acquire();
+    for (uint16_t i = 0; i < v.getCount(); ++i)
+    {
+      const float dx = v.getX()[i] - 0.5f;
+      const float dy = v.getY()[i] - 0.5f;
+      if (!(dx * dx + dy * dy <= radius * radius))
+      {
+        ++outOfBounds;
+      }
+    }
+    delay(2);
+  }
+  task.stop();
+  const uint32_t steps = task.consumeStats().frames;
+  report("sim task started and stopped", started && !task.isRunning(), (float)started);
+  report("sim task stepped", steps > 10, (float)steps);
+  report("sim task snapshots in bounds", outOfBounds == 0, (float)outOfBounds);
+}
+
+// A dense gravity pile: more relaxation passes must leave less total overlap after the same
+// steps. (The max is pinned by particles squeezed against the wall either way.)
+static void checkCollisionRelaxation()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  float overlap[2];
+  CollisionStats stats[2];
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 300;
+    cfg.particleRadius = 0.02f;
+    cfg.gravityY = 2.0f;
+    cfg.collisionIterations = pass == 0 ? 1 : 6;
+    randomSeed(5);
+    sim.init();
+    (void)sim.consumeCollisionStats();
+    for (uint16_t i = 0; i < 120; ++i)
+    {
+      sim.step(cfg.timeStep, i * cfg.timeStep);
+    }
+    overlap[pass] = sumOverlapRatio(sim, cfg.particleRadius);
+    stats[pass] = sim.consumeCollisionStats();
+  }
+  Serial.printf("[check] relaxation pile: total overlap %.1f (1 pass) vs %.1f (%.2f passes avg)\n",
+                overlap[0], overlap[1], (float)stats[1].passes / stats[1].steps);
+  report("relaxation reduces pile overlap", overlap[1] < overlap[0] * 0.5f, overlap[1]);
+}
+
+// Auto grid: small radii get cells finer than the old 16x16 cap and far fewer pair tests;
+// a manual grid too fine for large radii is coarsened so cells still span 2r.
+static void checkCollisionGridAuto()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  CollisionStats stats[2];
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 2000;
+    cfg.particleRadius = 0.006f;
+    cfg.collisionGridAuto = pass == 1;
+    randomSeed(3);
+    sim.init();
+    for (uint16_t i = 0; i < 20; ++i)
+    {
+      sim.step(cfg.timeStep, i * cfg.timeStep);
+    }
+    (void)sim.consumeCollisionStats();
+    sim.step(cfg.timeStep, 0.0f);
+    stats[pass] = sim.consumeCollisionStats();
+  }
+  Serial.printf("[check] auto grid crowd: grid %u vs %u | pairs %lu vs %lu\n", (unsigned)stats[0].gridSize,
+                (unsigned)stats[1].gridSize, (unsigned long)stats[0].pairsTested, (unsigned long)stats[1].pairsTested);
+  report("auto grid goes past 16 for small radii", stats[1].gridSize > 16, (float)stats[1].gridSize);
+  report("auto grid cuts pair tests", stats[1].pairsTested * 4 < stats[0].pairsTested, (float)stats[1].pairsTested);
+
+  cfg = SimConfig();
+  cfg.particleCount = 40;
+  cfg.particleRadius = 0.08f;
+  cfg.collisionGridAuto = false;
+  cfg.collisionGridSize = 16;
+  randomSeed(3);
+  sim.init();
+  sim.step(cfg.timeStep, 0.0f);
+  const CollisionStats big = sim.consumeCollisionStats();
+  report("grid cells span 2r for large radii", big.gridSize * 2.0f * cfg.particleRadius <= 1.0f, (float)big.gridSize);
+}
+
+// Colored passes must give bit-identical positions for any worker count, on both the
+// Verlet list path and the plain grid path (collisionSkin = 0).
+static void checkCollisionThreads()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static float refX[SIM_PARTICLE_CAPACITY];
+  static float refY[SIM_PARTICLE_CAPACITY];
+  const uint8_t threads[] = {1, 2, 4};
+  const char *names[] = {"collision threads match (verlet)", "collision threads match (grid)"};
+  for (uint8_t path = 0; path < 2; ++path)
+  {
+    uint16_t mismatched = 0;
+    for (uint8_t t = 0; t < sizeof(threads); ++t)
+    {
+      cfg = SimConfig();
+      cfg.particleCount = 600;
+      cfg.particleRadius = 0.012f;
+      cfg.gravityY = 2.0f;
+      cfg.turbStrength = 2.0f;
+      cfg.collisionSkin = path == 0 ? 0.5f : 0.0f;
+      cfg.collisionThreads = threads[t];
+      randomSeed(11);
+      sim.init();
+      for (uint16_t i = 0; i < 120; ++i)
+      {
+        sim.step(cfg.timeStep, i * cfg.timeStep);
+      }
+      for (uint16_t i = 0; i < sim.getCount(); ++i)
+      {
+        if (t == 0)
+        {
+          refX[i] = sim.getX()[i];
+          refY[i] = sim.getY()[i];
+        }
+        else if (memcmp(&refX[i], &sim.getX()[i], sizeof(float)) != 0 || memcmp(&refY[i], &sim.getY()[i], sizeof(float)) != 0)
+        {
+          ++mismatched;
+        }
+      }
+    }
+    report(names[path], mismatched == 0, (float)mismatched);
+  }
+}
+
+// Worst overlap against summed per-particle radii (the mixed-size contact distance).
+static float maxSizedOverlapRatio(const SimCore &sim)
+{
+  float worst = 0.0f;
+  const float *r = sim.getRadius();
+  for (uint16_t i = 0; i < sim.getCount(); ++i)
+  {
+    for (uint16_t j = i + 1; j < sim.getCount(); ++j)
+    {
+      const float dx = sim.getX()[j] - sim.getX()[i];
+      const float dy = sim.getY()[j] - sim.getY()[i];
+      const float d = sqrtf(dx * dx + dy * dy);
+      const float minDist = r[i] + r[j];
+      if (d < minDist)
+      {
+        worst = fmaxf(worst, (minDist - d) / minDist);
+      }
+    }
+  }
+  return worst;
+}
+
+// Turb Affect Scale on: radii stay in [min, max], contacts stay resolved against summed radii on
+// both the grid and the mixed Verlet list, and the result is still independent of the worker count.
+static void checkParticleSizes()
+{
+  static SimConfig cfg;
+  static SimCore sim(&cfg);
+  static float refX[SIM_PARTICLE_CAPACITY];
+  static float refY[SIM_PARTICLE_CAPACITY];
+  float overlap[2] = {};
+  uint16_t outOfRange = 0;
+  uint16_t mismatched = 0;
+  const float skins[] = {0.0f, 0.5f, 0.5f};
+  const uint8_t threads[] = {1, 1, 4};
+  for (uint8_t run = 0; run < sizeof(threads); ++run)
+  {
+    cfg = SimConfig();
+    cfg.particleCount = 250;
+    cfg.particleRadius = 0.012f;
+    cfg.turbStrength = 1.0f;
+    cfg.turbAffectScale = true;
+    cfg.collisionSkin = skins[run];
+    cfg.collisionThreads = threads[run];
+    randomSeed(11);
+    sim.init();
+    for (uint16_t i = 0; i < 400; ++i)
+    {
+      sim.step(cfg.timeStep, i * cfg.timeStep);
+      // Worst overlap averaged over eight snapshots; a single frame is too noisy.
+      if (run < 2 && i % 50 == 49)
+      {
+        overlap[run] += maxSizedOverlapRatio(sim) / 8.0f;
+      }
+    }
+    for (uint16_t i = 0; i < sim.getCount(); ++i)
+    {
+      const float r = sim.getRadius()[i];
+      if (r < cfg.turbMinScale - 1e-6f || r > cfg.turbMaxScale + 1e-6f)
+      {
+        ++outOfRange;
+      }
+      if (run == 1)
+      {
+        refX[i] = sim.getX()[i];
+        refY[i] = sim.getY()[i];
+      }
+      else if (run == 2 && (memcmp(&refX[i], &sim.getX()[i], sizeof(float)) != 0 || memcmp(&refY[i], &sim.getY()[i], sizeof(float)) != 0))
+      {
+        ++mismatched;
+      }
+    }
+  }
+  Serial.printf("[check] particle sizes: avg worst overlap %.3f (list) vs %.3f (grid)\n", overlap[1], overlap[0]);
+  report("particle radii within turb scale range", outOfRange == 0, (float)outOfRange);
+  report("mixed sizes resolved (grid)", overlap[0] < 0.2f, overlap[0]);
+  report("mixed sizes resolved (list)", overlap[1] < 0.2f, overlap[1]);
+  report("collision threads match (mixed sizes)", mismatched == 0, (float)mismatched);
+}
+
+int runHostChecks()
+{
+  gFailures = 0;
+  randomSeed(42);
+  checkVectorKernels();
+  checkBoundaryField();
+  checkBoundaryRepulsion();
+  checkNoise();
+  checkTurbulenceField();
+  checkFluid();
+  checkVoronoi();
+  checkNeighborGrid();
+  checkSwarm();
+  checkChain();
+  checkGridModes();
+  checkAutomata();
+  checkSnapshotBuffer();
+  checkInputMailbox();
+  checkCollisionCellOverflow();
+  checkVerletList();
+  checkCollisionRelaxation();
+  checkCollisionThreads();
+  checkCollisionGridAuto();
+  checkParticleSizes();
+  checkSubstepScheduler();
+  checkSimTask();
+  Serial.printf("[check] %d failure(s)\n", gFailures);
+  return gFailures;
+}
@@ -0,0 +1,8 @@
+#ifndef PHASE2_NATIVE_HOST_CHECKS_H
+#define PHASE2_NATIVE_HOST_CHECKS_H
+
+// Host-only correctness checks, run with: program check
+// Returns the number of failed checks.
+int runHostChecks();
+
+#endif
@@ -2,70 +2,325 @@
 
 #include <math.h>
 
-void Boundary::enforce(float &x, float &y, float &vx, float &vy) const
+// Rounded rectangle: the unit square with this corner radius.
+static constexpr float kCornerRadius = 0.15f;
+// The table spans [-kFieldMargin, 1 + kFieldMargin] so escaped particles still land on cells
+// outside the shape, whose normals extrapolate cleanly.
+static constexpr float kFieldMargin = 0.125f;
+static constexpr float kCellSize = (1.0f + 2.0f * kFieldMargin) / BOUNDARY_FIELD_SIZE;
+static constexpr float kNormalScale = 1.0f / 127.0f;
+static constexpr uint8_t kProjectFetches = 3;
+
+// Repulsion zone widths, as in the JS boundaries.
+static constexpr float kCircleZone = 0.15f;
+static constexpr float kEdgeZone = 0.1f;
+
+void Boundary::enforce(float &x, float &y, float &vx, float &vy)
+{
+  enforce(getParams(config_->timeStep), x, y, vx, vy);
+}
+
+BoundaryParams Boundary::getParams(float dt)
+{
+  BoundaryParams p;
+  p.shape = getBoundaryType();
+  p.mode = config_->boundaryMode;
+  p.radius = getRadius();
+  p.radiusSq = p.radius * p.radius;
+  p.damping = config_->boundaryDamping;
+  p.bounce = config_->boundaryRestitution * config_->boundaryDamping;
+  p.friction = config_->boundaryFriction;
+  // Per-timeStep kick, so a frame gets the same push however it is split into substeps.
+  p.repulsion = p.mode == 0 && config_->timeStep > 0.0f ? config_->boundaryRepulsion * dt / config_->timeStep : 0.0f;
+  p.zone = kEdgeZone;
+  p.invZone = 1.0f / kEdgeZone;
+  p.innerSq = p.radiusSq;
+  p.falloffScale = 0.0f;
+  p.falloff = falloff_;
+  p.field = nullptr;
+  if (p.shape == BOUNDARY_CIRCULAR && p.repulsion > 0.0f)
+  {
+    const float zone = kCircleZone * p.radius;
+    if (p.radius != falloffRadius_)
+    {
+      bakeFalloff(p.radius, zone);
+    }
+    const float inner = p.radius - zone;
+    p.innerSq = inner * inner;
+    p.falloffScale = BOUNDARY_FALLOFF_STEPS / (p.radiusSq - p.innerSq);
+  }
+  if (p.shape >= BOUNDARY_ROUNDED_RECT)
+  {
+    if (p.shape != fieldShape_ || config_->boundaryScale != fieldScale_)
+    {
+      bakeField((BoundaryType)p.shape);
+    }
+    p.field = field_;
+  }
+  return p;
+}
+
+void Boundary::bakeFalloff(float radius, float zone)
+{
+  const float inner = radius - zone;
+  const float innerSq = inner * inner;
+  const float step = (radius * radius - innerSq) / BOUNDARY_FALLOFF_STEPS;
+  for (uint8_t k = 0; k <= BOUNDARY_FALLOFF_STEPS; ++k)
+  {
+    const float d = sqrtf(innerSq + k * step);
+    const float u = (d - inner) / zone;
+    falloff_[k] = u * u / d;
+  }
+  falloffRadius_ = radius;
+}
+
+void Boundary::enforce(const BoundaryParams &p, float &x, float &y, float &vx, float &vy)
 {
-  const float damping = config_->boundaryDamping;
-  if (config_->boundaryShape == BOUNDARY_RECTANGULAR)
+  if (p.field)
+  {
+    enforceField(p, x, y, vx, vy);
+    return;
+  }
+  if (p.shape == BOUNDARY_RECTANGULAR)
   {
     const float minV = 0.0f;
     const float maxV = 1.0f;
-    if (x < minV || x > maxV)
+    const bool outX = x < minV || x > maxV;
+    const bool outY = y < minV || y > maxV;
+    if (outX)
     {
-      if (config_->boundaryMode == 0)
+      if (p.mode == 0)
       {
+        if (x < minV ? vx < 0.0f : vx > 0.0f)
+        {
+          vx = -vx * p.bounce;
+        }
+        vy *= p.friction;
         x = x < minV ? minV : maxV;
-        vx = -vx * damping;
       }
       else
       {
         x = x < minV ? maxV : minV;
       }
     }
-    if (y < minV || y > maxV)
+    if (outY)
     {
-      if (config_->boundaryMode == 0)
+      if (p.mode == 0)
       {
+        if (y < minV ? vy < 0.0f : vy > 0.0f)
+        {
+          vy = -vy * p.bounce;
+        }
+        vx *= p.friction;
         y = y < minV ? minV : maxV;
-        vy = -vy * damping;
       }
       else
       {
         y = y < minV ? maxV : minV;
       }
     }
+    if (!outX && !outY && p.repulsion > 0.0f)
+    {
+      repelRect(p, x, y, vx, vy);
+    }
     return;
   }
 
   const float cx = 0.5f;
   const float cy = 0.5f;
-  const float radius = getRadius();
   const float dx = x - cx;
   const float dy = y - cy;
-  const float dist = sqrtf(dx * dx + dy * dy);
-  if (dist <= radius || dist <= 0.0f)
+  const float distSq = dx * dx + dy * dy;
+  if (distSq <= p.radiusSq || distSq <= 0.0f)
   {
+    if (p.repulsion > 0.0f)
+    {
+      repelCircle(p, dx, dy, distSq, vx, vy);
+    }
     return;
   }
 
-  if (config_->boundaryMode == 1)
+  if (p.mode == 1)
   {
     x = cx - dx;
     y = cy - dy;
     return;
   }
 
+  const float dist = sqrtf(distSq);
   const float nx = dx / dist;
   const float ny = dy / dist;
-  x = cx + nx * radius;
-  y = cy + ny * radius;
+  x = cx + nx * p.radius;
+  y = cy + ny * p.radius;
   const float dot = vx * nx + vy * ny;
-  vx = (vx - 2.0f * dot * nx) * damping;
-  vy = (vy - 2.0f * dot * ny) * damping;
+  const float vn = dot > 0.0f ? -dot * p.bounce : dot;
+  vx = nx * vn + (vx - dot * nx) * p.friction;
+  vy = ny * vn + (vy - dot * ny) * p.friction;
+}
+
+static inline float cellCenter(int g)
+{
+  return (g + 0.5f) * kCellSize - kFieldMargin;
+}
+
+// One fetch: the cell-center sample plus the normal's projection of the offset to (x, y).
+static inline float fieldDistance(const BoundaryCell *field, float x, float y, float &nx, float &ny)
+{
+  int gx = (int)((x + kFieldMargin) * (1.0f / kCellSize));
+  int gy = (int)((y + kFieldMargin) * (1.0f / kCellSize));
+  gx = gx < 0 ? 0 : (gx >= BOUNDARY_FIELD_SIZE ? BOUNDARY_FIELD_SIZE - 1 : gx);
+  gy = gy < 0 ? 0 : (gy >= BOUNDARY_FIELD_SIZE ? BOUNDARY_FIELD_SIZE - 1 : gy);
+  const BoundaryCell &c = field[gy * BOUNDARY_FIELD_SIZE + gx];
+  nx = c.nx * kNormalScale;
+  ny = c.ny * kNormalScale;
+  return c.dist * (1.0f / BOUNDARY_DIST_SCALE) + nx * (x - cellCenter(gx)) + ny * (y - cellCenter(gy));
+}
+
+// Projects (x, y) inside along the table normal. One fetch when the particle sits near a straight
+// edge; curved edges and corners far outside take up to kProjectFetches.
+static inline void projectInside(const BoundaryCell *field, float d, float nx, float ny, float &x, float &y)
+{
+  for (uint8_t k = 1; k < kProjectFetches && d > 0.0f; ++k)
+  {
+    x -= nx * d;
+    y -= ny * d;
+    d = fieldDistance(field, x, y, nx, ny);
+  }
+  if (d > 0.0f)
+  {
+    x -= nx * d;
+    y -= ny * d;
+  }
+}
+
+void Boundary::enforceField(const BoundaryParams &p, float &x, float &y, float &vx, float &vy)
+{
+  float nx;
+  float ny;
+  float d = fieldDistance(p.field, x, y, nx, ny);
+  if (d <= 0.0f)
+  {
+    const float u = 1.0f + d * p.invZone;
+    if (p.repulsion > 0.0f && u > 0.0f)
+    {
+      vx -= nx * p.repulsion * u * u;
+      vy -= ny * p.repulsion * u * u;
+    }
+    return;
+  }
+
+  if (p.mode == 1)
+  {
+    // Mirror through the center like the circle; shapes that are not point-symmetric
+    // may land outside, which is then projected back onto the edge.
+    x = 1.0f - x;
+    y = 1.0f - y;
+    d = fieldDistance(p.field, x, y, nx, ny);
+    projectInside(p.field, d, nx, ny, x, y);
+    return;
+  }
+
+  // The first fetch's normal splits the velocity.
+  const float dot = vx * nx + vy * ny;
+  const float vn = dot > 0.0f ? -dot * p.bounce : dot;
+  vx = nx * vn + (vx - dot * nx) * p.friction;
+  vy = ny * vn + (vy - dot * ny) * p.friction;
+  projectInside(p.field, d, nx, ny, x, y);
+}
+
+float Boundary::shapeDistance(BoundaryType shape, float x, float y, float &nx, float &ny) const
+{
+  if (shape == BOUNDARY_ROUNDED_RECT)
+  {
+    const float px = x - 0.5f;
+    const float py = y - 0.5f;
+    const float sx = px < 0.0f ? -1.0f : 1.0f;
+    const float sy = py < 0.0f ? -1.0f : 1.0f;
+    const float qx = fabsf(px) - (0.5f - kCornerRadius);
+    const float qy = fabsf(py) - (0.5f - kCornerRadius);
+    if (qx > 0.0f && qy > 0.0f)
+    {
+      const float len = sqrtf(qx * qx + qy * qy);
+      nx = sx * qx / len;
+      ny = sy * qy / len;
+      return len - kCornerRadius;
+    }
+    nx = qx > qy ? sx : 0.0f;
+    ny = qx > qy ? 0.0f : sy;
+    return (qx > qy ? qx : qy) - kCornerRadius;
+  }
+
+  // Half circle: dome of the boundary radius, flat edge at the bottom, centered vertically.
+  const float r = getRadius();
+  const float dx = x - 0.5f;
+  const float dy = y - (0.5f + 0.5f * r);
+  if (dy > 0.0f)
+  {
+    if (fabsf(dx) <= r)
+    {
+      nx = 0.0f;
+      ny = 1.0f;
+      return dy;
+    }
+    const float ex = dx - (dx < 0.0f ? -r : r);
+    const float len = sqrtf(ex * ex + dy * dy);
+    nx = ex / len;
+    ny = dy / len;
+    return len;
+  }
+  const float len = sqrtf(dx * dx + dy * dy);
+  const float disc = len - r;
+  if (disc >= dy && len > 1e-6f)
+  {
+    nx = dx / len;
+    ny = dy / len;
+    return disc;
+  }
+  nx = 0.0f;
+  ny = 1.0f;
+  return dy;
+}
+
+void Boundary::bakeField(BoundaryType shape)
+{
+  for (uint8_t gy = 0; gy < BOUNDARY_FIELD_SIZE; ++gy)
+  {
+    for (uint8_t gx = 0; gx < BOUNDARY_FIELD_SIZE; ++gx)
+    {
+      float nx;
+      float ny;
+      const float d = shapeDistance(shape, cellCenter(gx), cellCenter(gy), nx, ny);
+      BoundaryCell &c = field_[gy * BOUNDARY_FIELD_SIZE + gx];
+      c.dist = (int16_t)fmaxf(-32767.0f, fminf(32767.0f, roundf(d * BOUNDARY_DIST_SCALE)));
+      c.nx = (int8_t)roundf(nx * 127.0f);
+      c.ny = (int8_t)roundf(ny * 127.0f);
+    }
+  }
+  fieldShape_ = shape;
+  fieldScale_ = config_->boundaryScale;
+}
+
+float Boundary::signedDistance(float x, float y) const
+{
+  const BoundaryType shape = getBoundaryType();
+  if (shape == BOUNDARY_CIRCULAR)
+  {
+    const float dx = x - 0.5f;
+    const float dy = y - 0.5f;
+    return sqrtf(dx * dx + dy * dy) - getRadius();
+  }
+  if (shape == BOUNDARY_RECTANGULAR)
+  {
+    return fmaxf(fabsf(x - 0.5f), fabsf(y - 0.5f)) - 0.5f;
+  }
+  float nx;
+  float ny;
+  return shapeDistance(shape, x, y, nx, ny);
 }
 
 BoundaryType Boundary::getBoundaryType() const
 {
-  return config_->boundaryShape == 0 ? BOUNDARY_CIRCULAR : BOUNDARY_RECTANGULAR;
+  return config_->boundaryShape < BOUNDARY_SHAPE_COUNT ? (BoundaryType)config_->boundaryShape : BOUNDARY_CIRCULAR;
 }
 
 float Boundary::getRadius() const
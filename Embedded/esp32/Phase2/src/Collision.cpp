@@ -1,96 +1,719 @@
 #include "Collision.h"
 
 #include <math.h>
+#include <string.h>
 
-void Collision::resolve(float *x, float *y, float *vx, float *vy, uint16_t count, float particleRadius) const
+// When every one of kBusyStreak consecutive steps needed a rebuild, the list is only overhead:
+// run the plain grid path for kBusyBackoff steps before trying again.
+static constexpr uint8_t kBusyStreak = 8;
+static constexpr uint8_t kBusyBackoff = 32;
+
+// Cells are processed color by color. A cell's half stencil writes into 3 columns and 2 rows,
+// so cells of one color (3 columns / 2 rows apart) never share a particle and can run on
+// different cores. Serial runs use the same color order, so results match for any worker count.
+static constexpr uint8_t kColorsX = 3;
+static constexpr uint8_t kColorsY = 2;
+static constexpr uint8_t kColorCount = kColorsX * kColorsY;
+static_assert(kColorCount == COLLISION_COLORS, "color layout");
+
+// Forward half of the 3x3 stencil; with pairs inside the cell itself this visits each pair once.
+static const int8_t kForwardCells[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+
+struct PairParams
 {
-  if (!config_->collisionEnabled || count < 2)
+  // Uniform radius only; mixed sizes use radius[i] + radius[j].
+  float minDist;
+  float minDistSq;
+  // (1 + restitution) times collisionDamping; each side takes its mass share.
+  float restitutionScale;
+  // collisionRepulsion * collisionDamping on the first pass, 0 on relaxation passes.
+  float biasScale;
+};
+
+// Projects an overlapping pair apart and applies the restitution impulse along the normal.
+// wi is i's share of the correction (mj / (mi + mj), 0.5 for equal masses).
+// Returns half the pair's positional correction, 0 when the pair did not overlap.
+static inline float resolvePair(const PairParams &p, float *x, float *y, float *vx, float *vy, uint16_t i, uint16_t j,
+                                float minDist, float wi)
+{
+  const float dx = x[j] - x[i];
+  const float dy = y[j] - y[i];
+  const float dsq = dx * dx + dy * dy;
+  if (dsq <= 1e-12f || dsq >= minDist * minDist)
   {
-    return;
+    return 0.0f;
   }
+  const float dist = sqrtf(dsq);
+  const float correction = minDist - dist;
+  const float wj = 1.0f - wi;
+  const float nxn = dx / dist;
+  const float nyn = dy / dist;
+  x[i] -= nxn * correction * wi;
+  y[i] -= nyn * correction * wi;
+  x[j] += nxn * correction * wj;
+  y[j] += nyn * correction * wj;
 
-  const uint8_t gridSize = config_->collisionGridSize > MAX_COLLISION_GRID ? MAX_COLLISION_GRID : config_->collisionGridSize;
-  const float cellSize = 1.0f / (float)gridSize;
-  static int16_t cells[MAX_COLLISION_GRID][MAX_COLLISION_GRID][MAX_CELL_PARTICLES];
-  static uint8_t cellCounts[MAX_COLLISION_GRID][MAX_COLLISION_GRID];
+  // Only approaching pairs get the restitution impulse; the bias keeps the old overlap push.
+  const float vn = (vx[j] - vx[i]) * nxn + (vy[j] - vy[i]) * nyn;
+  const float impulse = (vn < 0.0f ? -vn * p.restitutionScale : 0.0f) + correction * p.biasScale;
+  vx[i] -= nxn * impulse * wi;
+  vy[i] -= nyn * impulse * wi;
+  vx[j] += nxn * impulse * wj;
+  vy[j] += nyn * impulse * wj;
+  return correction * 0.5f;
+}
 
-  for (uint8_t gx = 0; gx < gridSize; ++gx)
+// Calls visit(i, j) for every pair owned by cell (cx, cy): pairs inside the cell and with the
+// four forward neighbours. Writes stay inside columns cx-1..cx+1 and rows cy..cy+1.
+template <typename Visitor>
+static void visitCell(const uint16_t *cellStart, const uint16_t *order, uint8_t gridSize, uint8_t cx, uint8_t cy, Visitor &visit)
+{
+  const uint16_t c = (uint16_t)(cy * gridSize + cx);
+  const uint16_t begin = cellStart[c];
+  const uint16_t end = cellStart[c + 1];
+  for (uint16_t a = begin; a < end; ++a)
   {
-    for (uint8_t gy = 0; gy < gridSize; ++gy)
+    const uint16_t i = order[a];
+    for (uint16_t b = a + 1; b < end; ++b)
+    {
+      visit(i, order[b]);
+    }
+    for (uint8_t n = 0; n < 4; ++n)
     {
-      cellCounts[gx][gy] = 0;
+      const int nx = cx + kForwardCells[n][0];
+      const int ny = cy + kForwardCells[n][1];
+      if (nx < 0 || nx >= gridSize || ny >= gridSize)
+      {
+        continue;
+      }
+      const uint16_t nc = (uint16_t)(ny * gridSize + nx);
+      const uint16_t nEnd = cellStart[nc + 1];
+      for (uint16_t b = cellStart[nc]; b < nEnd; ++b)
+      {
+        visit(i, order[b]);
+      }
     }
   }
+}
 
-  for (uint16_t i = 0; i < count; ++i)
+static inline uint8_t cellCoord(float v, uint8_t gridSize)
+{
+  const int c = (int)(v * gridSize);
+  return (uint8_t)(c < 0 ? 0 : (c >= gridSize ? gridSize - 1 : c));
+}
+
+// Cells of one color: every kColorsX-th column and kColorsY-th row from (ox, oy).
+static inline uint16_t colorColumns(uint8_t gridSize, uint8_t color)
+{
+  const uint8_t ox = color % kColorsX;
+  return ox < gridSize ? (uint16_t)((gridSize - ox + kColorsX - 1) / kColorsX) : 0;
+}
+
+static inline uint16_t colorCellCount(uint8_t gridSize, uint8_t color)
+{
+  const uint8_t oy = color / kColorsX;
+  const uint16_t rows = oy < gridSize ? (uint16_t)((gridSize - oy + kColorsY - 1) / kColorsY) : 0;
+  return colorColumns(gridSize, color) * rows;
+}
+
+// Visits cells k = worker, worker + workers, ... of one color, in slot order.
+template <typename Visitor>
+static void visitColor(const uint16_t *cellStart, const uint16_t *order, uint8_t gridSize, uint8_t color,
+                       uint8_t worker, uint8_t workers, Visitor &visit)
+{
+  const uint16_t cols = colorColumns(gridSize, color);
+  const uint16_t cells = colorCellCount(gridSize, color);
+  for (uint16_t k = worker; k < cells; k += workers)
+  {
+    const uint8_t cx = (uint8_t)(color % kColorsX + kColorsX * (k % cols));
+    const uint8_t cy = (uint8_t)(color / kColorsX + kColorsY * (k / cols));
+    visit.beginCell(k);
+    visitCell(cellStart, order, gridSize, cx, cy, visit);
+  }
+}
+
+struct ResolveVisitor
+{
+  PairParams p;
+  float *x;
+  float *y;
+  float *vx;
+  float *vy;
+  // Per-particle columns, nullptr for uniform particles.
+  const float *radius;
+  const float *mass;
+  uint32_t tested;
+  uint32_t contacts;
+  // Largest correction of the current pass, for the relaxation early exit.
+  float maxCorrection;
+
+  void beginCell(uint16_t) {}
+  void operator()(uint16_t i, uint16_t j)
   {
-    int cx = (int)(x[i] / cellSize);
-    int cy = (int)(y[i] / cellSize);
-    if (cx < 0)
-      cx = 0;
-    if (cy < 0)
-      cy = 0;
-    if (cx >= gridSize)
-      cx = gridSize - 1;
-    if (cy >= gridSize)
-      cy = gridSize - 1;
+    ++tested;
+    float minDist = p.minDist;
+    float wi = 0.5f;
+    if (radius)
+    {
+      minDist = radius[i] + radius[j];
+      if (mass)
+      {
+        wi = mass[j] / (mass[i] + mass[j]);
+      }
+    }
+    const float correction = resolvePair(p, x, y, vx, vy, i, j, minDist, wi);
+    if (correction > 0.0f)
+    {
+      ++contacts;
+      maxCorrection = correction > maxCorrection ? correction : maxCorrection;
+    }
+  }
+};
+
+// Rebuild pass: records every grid pair within the cutoff. slotStart gets each cell's first
+// pair so the list can be split by color and cell like the grid.
+struct ListVisitor
+{
+  const float *x;
+  const float *y;
+  float cutoffSq;
+  uint32_t *pairs;
+  uint32_t capacity;
+  uint32_t count;
+  uint32_t *slotStart;
+  uint16_t slotBase;
+  bool overflow;
+
+  void beginCell(uint16_t k) { slotStart[slotBase + k] = count; }
+  void operator()(uint16_t i, uint16_t j)
+  {
+    const float dx = x[j] - x[i];
+    const float dy = y[j] - y[i];
+    if (dx * dx + dy * dy >= cutoffSq)
+    {
+      return;
+    }
+    if (count < capacity)
+    {
+      pairs[count++] = ((uint32_t)i << 16) | j;
+    }
+    else
+    {
+      overflow = true;
+    }
+  }
+};
+
+// Slot (color order, see visitColor) of the cell owning pair (i, j): the one whose forward
+// stencil holds the other, i.e. the lower row, or the left one within a row.
+static inline uint16_t ownerSlot(uint8_t gridSize, const uint16_t *colorSlot, float xi, float yi, float xj, float yj)
+{
+  uint8_t cx = cellCoord(xi, gridSize);
+  uint8_t cy = cellCoord(yi, gridSize);
+  const uint8_t jx = cellCoord(xj, gridSize);
+  const uint8_t jy = cellCoord(yj, gridSize);
+  if (jy < cy || (jy == cy && jx < cx))
+  {
+    cx = jx;
+    cy = jy;
+  }
+  const uint8_t color = (uint8_t)((cy % kColorsY) * kColorsX + cx % kColorsX);
+  return (uint16_t)(colorSlot[color] + (cy / kColorsY) * colorColumns(gridSize, color) + cx / kColorsX);
+}
+
+// Mixed sizes: particles are binned on up to COLLISION_LEVELS grids, each twice as fine as
+// the last, on the finest level whose cells still span 2r + skin. Level l occupies cells
+// offset[l] .. offset[l] + size[l]^2 of one shared counting sort.
+struct LevelGrid
+{
+  uint8_t levels;
+  uint8_t size[COLLISION_LEVELS];
+  uint16_t offset[COLLISION_LEVELS];
+};
 
-    uint8_t &slotCount = cellCounts[cx][cy];
-    if (slotCount < MAX_CELL_PARTICLES)
+static LevelGrid makeLevels(float rMin, float rMax, float skin)
+{
+  LevelGrid g;
+  g.levels = 1;
+  g.size[0] = NeighborGrid::fitCutoff(2.0f * rMax + skin);
+  g.offset[0] = 0;
+  uint16_t cells = (uint16_t)g.size[0] * g.size[0];
+  while (g.levels < COLLISION_LEVELS)
+  {
+    const uint16_t finer = (uint16_t)g.size[g.levels - 1] * 2;
+    if (finer > MAX_COLLISION_GRID || cells + finer * finer > MAX_COLLISION_CELLS || finer * (2.0f * rMin + skin) > 1.0f)
     {
-      cells[cx][cy][slotCount++] = (int16_t)i;
+      break;
     }
+    g.size[g.levels] = (uint8_t)finer;
+    g.offset[g.levels] = cells;
+    cells = (uint16_t)(cells + finer * finer);
+    ++g.levels;
   }
+  return g;
+}
 
-  const float minDist = particleRadius * 2.0f;
-  const float minDistSq = minDist * minDist;
-  const float strength = config_->collisionRepulsion;
-  const float damping = config_->collisionDamping;
+static inline uint8_t levelOf(const LevelGrid &g, float radius, float skin)
+{
+  for (uint8_t l = g.levels; l-- > 1;)
+  {
+    if (g.size[l] * (2.0f * radius + skin) <= 1.0f)
+    {
+      return l;
+    }
+  }
+  return 0;
+}
 
+// Calls sink(i, j) once for every pair closer than r[i] + r[j] + skin. Each particle scans the
+// 3x3 cells around it on its own level (higher indices only) and on every coarser level, so a
+// pair is found from its smaller (or higher-index) particle and big particles never scan fine cells.
+template <typename Sink>
+static void forEachLevelPair(const LevelGrid &g, const uint16_t *cellStart, const uint16_t *order, const float *x,
+                             const float *y, const float *radius, uint16_t count, float skin, Sink &sink)
+{
   for (uint16_t i = 0; i < count; ++i)
   {
-    int cx = (int)(x[i] / cellSize);
-    int cy = (int)(y[i] / cellSize);
-    for (int ox = -1; ox <= 1; ++ox)
+    const uint8_t own = levelOf(g, radius[i], skin);
+    for (uint8_t l = 0; l <= own; ++l)
     {
-      for (int oy = -1; oy <= 1; ++oy)
+      const uint8_t size = g.size[l];
+      const int cx = cellCoord(x[i], size);
+      const int cy = cellCoord(y[i], size);
+      for (int ny = cy - 1; ny <= cy + 1; ++ny)
       {
-        int nx = cx + ox;
-        int ny = cy + oy;
-        if (nx < 0 || ny < 0 || nx >= gridSize || ny >= gridSize)
+        if (ny < 0 || ny >= size)
         {
           continue;
         }
-        const uint8_t nCount = cellCounts[nx][ny];
-        for (uint8_t k = 0; k < nCount; ++k)
+        for (int nx = cx - 1; nx <= cx + 1; ++nx)
         {
-          const int16_t j = cells[nx][ny][k];
-          if (j <= (int16_t)i)
+          if (nx < 0 || nx >= size)
           {
             continue;
           }
-          const float dx = x[j] - x[i];
-          const float dy = y[j] - y[i];
-          const float dsq = dx * dx + dy * dy;
-          if (dsq <= 1e-12f || dsq >= minDistSq)
+          const uint16_t c = (uint16_t)(g.offset[l] + ny * size + nx);
+          const uint16_t end = cellStart[c + 1];
+          for (uint16_t b = cellStart[c]; b < end; ++b)
           {
-            continue;
+            const uint16_t j = order[b];
+            if (l == own && j <= i)
+            {
+              continue;
+            }
+            const float dx = x[j] - x[i];
+            const float dy = y[j] - y[i];
+            const float reach = radius[i] + radius[j] + skin;
+            if (dx * dx + dy * dy < reach * reach)
+            {
+              sink(i, j);
+            }
           }
-          const float dist = sqrtf(dsq);
-          const float overlap = (minDist - dist) * 0.5f;
-          const float nxn = dx / dist;
-          const float nyn = dy / dist;
-          x[i] -= nxn * overlap;
-          y[i] -= nyn * overlap;
-          x[j] += nxn * overlap;
-          y[j] += nyn * overlap;
-          const float impulse = overlap * strength;
-          vx[i] -= nxn * impulse * damping;
-          vy[i] -= nyn * impulse * damping;
-          vx[j] += nxn * impulse * damping;
-          vy[j] += nyn * impulse * damping;
         }
       }
     }
   }
 }
+
+// Mixed-size list build, first pass: pairs per owner slot.
+struct SlotCountSink
+{
+  const float *x;
+  const float *y;
+  uint8_t gridSize;
+  const uint16_t *colorSlot;
+  uint32_t *slotEnd;
+  uint32_t total;
+
+  void operator()(uint16_t i, uint16_t j)
+  {
+    ++slotEnd[ownerSlot(gridSize, colorSlot, x[i], y[i], x[j], y[j])];
+    ++total;
+  }
+};
+
+// Second pass: slotEnd holds inclusive prefix sums and walks down to each slot's start.
+struct SlotScatterSink
+{
+  const float *x;
+  const float *y;
+  uint8_t gridSize;
+  const uint16_t *colorSlot;
+  uint32_t *slotEnd;
+  uint32_t *pairs;
+
+  void operator()(uint16_t i, uint16_t j)
+  {
+    pairs[--slotEnd[ownerSlot(gridSize, colorSlot, x[i], y[i], x[j], y[j])]] = ((uint32_t)i << 16) | j;
+  }
+};
+
+// One relaxation pass, run on every worker with its own visitor (counters stay per worker).
+struct PassJob
+{
+  Collision *collision;
+  ResolveVisitor *resolvers;
+};
+
+static inline size_t alignedBytes(size_t bytes)
+{
+  return (bytes + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+size_t Collision::indexStorageBytes(uint16_t capacity)
+{
+  return 2 * alignedBytes((size_t)capacity * sizeof(uint16_t)) +
+         alignedBytes((MAX_COLLISION_CELLS + 1) * sizeof(uint16_t));
+}
+
+size_t Collision::listStorageBytes(uint16_t capacity)
+{
+  return alignedBytes((size_t)capacity * COLLISION_PAIRS_PER_PARTICLE * sizeof(uint32_t)) +
+         3 * alignedBytes((size_t)capacity * sizeof(float)) +
+         alignedBytes((MAX_COLLISION_CELLS + 1) * sizeof(uint32_t));
+}
+
+bool Collision::begin(ParticleArena &arena, ArenaRegion indexRegion, uint16_t capacity, NeighborGrid &grid)
+{
+  grid_ = &grid;
+  cellOf_ = (uint16_t *)arena.alloc(indexRegion, alignedBytes((size_t)capacity * sizeof(uint16_t)));
+  order_ = (uint16_t *)arena.alloc(indexRegion, alignedBytes((size_t)capacity * sizeof(uint16_t)));
+  cellStart_ = (uint16_t *)arena.alloc(indexRegion, alignedBytes((MAX_COLLISION_CELLS + 1) * sizeof(uint16_t)));
+  if (!cellOf_ || !order_ || !cellStart_)
+  {
+    cellOf_ = nullptr;
+    order_ = nullptr;
+    cellStart_ = nullptr;
+    capacity_ = 0;
+    return false;
+  }
+  capacity_ = capacity;
+
+  const uint32_t pairCapacity = (uint32_t)capacity * COLLISION_PAIRS_PER_PARTICLE;
+  pairs_ = (uint32_t *)arena.alloc(ARENA_BULK, alignedBytes(pairCapacity * sizeof(uint32_t)));
+  refX_ = (float *)arena.alloc(ARENA_BULK, alignedBytes((size_t)capacity * sizeof(float)));
+  refY_ = (float *)arena.alloc(ARENA_BULK, alignedBytes((size_t)capacity * sizeof(float)));
+  refR_ = (float *)arena.alloc(ARENA_BULK, alignedBytes((size_t)capacity * sizeof(float)));
+  slotStart_ = (uint32_t *)arena.alloc(ARENA_BULK, alignedBytes((MAX_COLLISION_CELLS + 1) * sizeof(uint32_t)));
+  pairCapacity_ = (pairs_ && refX_ && refY_ && refR_ && slotStart_) ? pairCapacity : 0;
+  listValid_ = false;
+  return true;
+}
+
+uint8_t Collision::chooseGridSize(uint16_t count, float cutoff) const
+{
+  if (config_->collisionGridAuto)
+  {
+    return NeighborGrid::fitGridSize(cutoff, count);
+  }
+  const uint8_t fit = NeighborGrid::fitCutoff(cutoff);
+  const uint8_t target = config_->collisionGridSize < 1 ? 1 : config_->collisionGridSize;
+  return target < fit ? target : fit;
+}
+
+uint8_t Collision::preferredGridSize(uint16_t count, float particleRadius, const float *radius) const
+{
+  float rMax = particleRadius;
+  if (radius)
+  {
+    rMax = radius[0];
+    for (uint16_t i = 1; i < count; ++i)
+    {
+      rMax = radius[i] > rMax ? radius[i] : rMax;
+    }
+  }
+  // The list cutoff when the list is on, which also fits the plain path's 2r.
+  const float skin = pairCapacity_ > 0 ? config_->collisionSkin * particleRadius : 0.0f;
+  return chooseGridSize(count, 2.0f * rMax + skin);
+}
+
+uint8_t Collision::prepareGrid(const float *x, const float *y, uint16_t count, float cutoff)
+{
+  if (!grid_->matches(x, y, count) || grid_->getGridSize() > NeighborGrid::fitCutoff(cutoff))
+  {
+    grid_->build(x, y, count, chooseGridSize(count, cutoff));
+  }
+  const uint8_t gridSize = grid_->getGridSize();
+  reportedGrid_.store(gridSize, std::memory_order_relaxed);
+  return gridSize;
+}
+
+bool Collision::listNeedsRebuild(const float *x, const float *y, const float *radius, uint16_t count, float cutoff,
+                                 float skin) const
+{
+  if (!listValid_ || count != listCount_ || cutoff != listCutoff_ || (radius != nullptr) != listMixed_)
+  {
+    return true;
+  }
+  const float halfSkin = 0.5f * skin;
+  const float limitSq = halfSkin * halfSkin;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const float dx = x[i] - refX_[i];
+    const float dy = y[i] - refY_[i];
+    float limit = limitSq;
+    if (radius && radius[i] > refR_[i])
+    {
+      // A growing particle uses up its half skin like a moving one.
+      const float reach = halfSkin - (radius[i] - refR_[i]);
+      if (reach < 0.0f)
+      {
+        return true;
+      }
+      limit = reach * reach;
+    }
+    if (dx * dx + dy * dy > limit)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Collision::buildList(const float *x, const float *y, uint16_t count, float cutoff)
+{
+  const uint8_t gridSize = prepareGrid(x, y, count, cutoff);
+  memcpy(refX_, x, count * sizeof(float));
+  memcpy(refY_, y, count * sizeof(float));
+
+  ListVisitor list = {x, y, cutoff * cutoff, pairs_, pairCapacity_, 0, slotStart_, 0, false};
+  for (uint8_t color = 0; color < kColorCount; ++color)
+  {
+    colorSlot_[color] = list.slotBase;
+    visitColor(grid_->getCellStart(), grid_->getOrder(), gridSize, color, 0, 1, list);
+    list.slotBase = (uint16_t)(list.slotBase + colorCellCount(gridSize, color));
+  }
+  colorSlot_[kColorCount] = list.slotBase;
+  slotStart_[list.slotBase] = list.count;
+
+  pairCount_ = list.count;
+  listCount_ = count;
+  listCutoff_ = cutoff;
+  listMixed_ = false;
+  listValid_ = !list.overflow;
+  return listValid_;
+}
+
+bool Collision::buildMixedList(const float *x, const float *y, const float *radius, uint16_t count, float skin,
+                               float rMin, float rMax)
+{
+  // Colors and slots come from one base grid, exactly like the uniform list; the levels only
+  // speed up the search.
+  const uint8_t baseSize = chooseGridSize(count, 2.0f * rMax + skin);
+  uint16_t slots = 0;
+  for (uint8_t color = 0; color < kColorCount; ++color)
+  {
+    colorSlot_[color] = slots;
+    slots = (uint16_t)(slots + colorCellCount(baseSize, color));
+  }
+  colorSlot_[kColorCount] = slots;
+
+  const LevelGrid g = makeLevels(rMin, rMax, skin);
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const uint8_t l = levelOf(g, radius[i], skin);
+    cellOf_[i] = (uint16_t)(g.offset[l] + cellCoord(y[i], g.size[l]) * g.size[l] + cellCoord(x[i], g.size[l]));
+  }
+  const uint8_t last = (uint8_t)(g.levels - 1);
+  NeighborGrid::sortByCell(cellOf_, count, (uint16_t)(g.offset[last] + g.size[last] * g.size[last]), cellStart_, order_);
+
+  memset(slotStart_, 0, (slots + 1) * sizeof(uint32_t));
+  SlotCountSink counter = {x, y, baseSize, colorSlot_, slotStart_, 0};
+  forEachLevelPair(g, cellStart_, order_, x, y, radius, count, skin, counter);
+
+  memcpy(refX_, x, count * sizeof(float));
+  memcpy(refY_, y, count * sizeof(float));
+  memcpy(refR_, radius, count * sizeof(float));
+  listCount_ = count;
+  listCutoff_ = skin;
+  listMixed_ = true;
+  if (counter.total > pairCapacity_)
+  {
+    listValid_ = false;
+    return false;
+  }
+
+  for (uint16_t s = 1; s < slots; ++s)
+  {
+    slotStart_[s] += slotStart_[s - 1];
+  }
+  slotStart_[slots] = counter.total;
+  SlotScatterSink scatter = {x, y, baseSize, colorSlot_, slotStart_, pairs_};
+  forEachLevelPair(g, cellStart_, order_, x, y, radius, count, skin, scatter);
+
+  pairCount_ = counter.total;
+  reportedGrid_.store(baseSize, std::memory_order_relaxed);
+  listValid_ = true;
+  return true;
+}
+
+void Collision::passEntry(void *ctx, uint8_t worker, uint8_t workers)
+{
+  PassJob *job = static_cast<PassJob *>(ctx);
+  job->collision->runPass(job->resolvers[worker], worker, workers);
+}
+
+void Collision::runPass(ResolveVisitor &resolver, uint8_t worker, uint8_t workers)
+{
+  for (uint8_t color = 0; color < kColorCount; ++color)
+  {
+    if (listValid_)
+    {
+      const uint16_t base = colorSlot_[color];
+      const uint16_t cells = (uint16_t)(colorSlot_[color + 1] - base);
+      for (uint16_t k = worker; k < cells; k += workers)
+      {
+        const uint32_t end = slotStart_[base + k + 1];
+        for (uint32_t q = slotStart_[base + k]; q < end; ++q)
+        {
+          resolver((uint16_t)(pairs_[q] >> 16), (uint16_t)(pairs_[q] & 0xFFFF));
+        }
+      }
+    }
+    else
+    {
+      visitColor(grid_->getCellStart(), grid_->getOrder(), grid_->getGridSize(), color, worker, workers, resolver);
+    }
+    pool_.barrier();
+  }
+}
+
+void Collision::resolve(float *x, float *y, float *vx, float *vy, uint16_t count, float particleRadius,
+                        const float *radius, const float *mass)
+{
+  if (!config_->collisionEnabled || count < 2 || !order_ || !grid_->isReady())
+  {
+    return;
+  }
+  if (count > capacity_)
+  {
+    count = capacity_;
+  }
+
+  PairParams p;
+  p.minDist = particleRadius * 2.0f;
+  p.minDistSq = p.minDist * p.minDist;
+  p.restitutionScale = (1.0f + config_->particleRestitution) * config_->collisionDamping;
+  p.biasScale = config_->collisionRepulsion * config_->collisionDamping;
+
+  // Mixed sizes: the grid path sizes cells for the largest pair.
+  float rMin = particleRadius;
+  float rMax = particleRadius;
+  if (radius)
+  {
+    rMin = rMax = radius[0];
+    for (uint16_t i = 1; i < count; ++i)
+    {
+      rMin = radius[i] < rMin ? radius[i] : rMin;
+      rMax = radius[i] > rMax ? radius[i] : rMax;
+    }
+  }
+  const float maxPair = 2.0f * rMax;
+
+  // Reuse the Verlet list, rebuild it, or fall back to a fresh grid.
+  const float skin = config_->collisionSkin * particleRadius;
+  const bool listEnabled = skin > 0.0f && pairCapacity_ > 0;
+  bool gridBuilt = false;
+  bool rebuildCounted = false;
+  if (listEnabled && busyBackoff_ == 0)
+  {
+    if (listNeedsRebuild(x, y, radius, count, radius ? skin : p.minDist + skin, skin))
+    {
+      rebuilds_.fetch_add(1, std::memory_order_relaxed);
+      rebuildCounted = true;
+      const bool built = radius ? buildMixedList(x, y, radius, count, skin, rMin, rMax)
+                                : buildList(x, y, count, p.minDist + skin);
+      // The uniform build leaves a usable grid behind even when the list overflowed.
+      gridBuilt = radius == nullptr;
+      if (!built)
+      {
+        overflows_.fetch_add(1, std::memory_order_relaxed);
+      }
+      if (++rebuildStreak_ >= kBusyStreak)
+      {
+        rebuildStreak_ = 0;
+        busyBackoff_ = kBusyBackoff;
+      }
+    }
+    else
+    {
+      rebuildStreak_ = 0;
+    }
+  }
+  else
+  {
+    listValid_ = false;
+    if (busyBackoff_ > 0)
+    {
+      --busyBackoff_;
+    }
+  }
+  if (!listValid_ && !gridBuilt)
+  {
+    prepareGrid(x, y, count, maxPair);
+    // A mixed-list overflow falls back here; that step's rebuild is already counted.
+    if (!rebuildCounted)
+    {
+      rebuilds_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Relaxation: repeat over the same pairs (list, or this step's grid) until the largest
+  // correction drops below collisionTolerance of a diameter.
+  const uint8_t workers = pool_.clampWorkers(config_->collisionThreads);
+  ResolveVisitor resolvers[MAX_POOL_WORKERS];
+  for (uint8_t w = 0; w < workers; ++w)
+  {
+    resolvers[w] = {p, x, y, vx, vy, radius, mass, 0, 0, 0.0f};
+  }
+  PassJob job = {this, resolvers};
+  const uint8_t maxPasses = config_->collisionIterations < 1 ? 1 : config_->collisionIterations;
+  const float tolerance = config_->collisionTolerance * p.minDist;
+  uint8_t passes = 0;
+  float maxCorrection = 0.0f;
+  do
+  {
+    for (uint8_t w = 0; w < workers; ++w)
+    {
+      resolvers[w].maxCorrection = 0.0f;
+    }
+    pool_.run(passEntry, &job, workers);
+    ++passes;
+    maxCorrection = 0.0f;
+    for (uint8_t w = 0; w < workers; ++w)
+    {
+      maxCorrection = resolvers[w].maxCorrection > maxCorrection ? resolvers[w].maxCorrection : maxCorrection;
+      resolvers[w].p.biasScale = 0.0f;
+    }
+  } while (passes < maxPasses && maxCorrection > tolerance);
+
+  uint32_t tested = 0;
+  uint32_t contacts = 0;
+  for (uint8_t w = 0; w < workers; ++w)
+  {
+    tested += resolvers[w].tested;
+    contacts += resolvers[w].contacts;
+  }
+  if (contacts > 0)
+  {
+    // Positions moved; the grid no longer bins them exactly.
+    grid_->invalidate();
+  }
+  steps_.fetch_add(1, std::memory_order_relaxed);
+  pairsTested_.fetch_add(tested, std::memory_order_relaxed);
+  contacts_.fetch_add(contacts, std::memory_order_relaxed);
+  passes_.fetch_add(passes, std::memory_order_relaxed);
+}
+
+CollisionStats Collision::consumeStats()
+{
+  CollisionStats s;
+  s.steps = steps_.exchange(0, std::memory_order_relaxed);
+  s.rebuilds = rebuilds_.exchange(0, std::memory_order_relaxed);
+  s.pairsTested = pairsTested_.exchange(0, std::memory_order_relaxed);
+  s.contacts = contacts_.exchange(0, std::memory_order_relaxed);
+  s.overflows = overflows_.exchange(0, std::memory_order_relaxed);
+  s.passes = passes_.exchange(0, std::memory_order_relaxed);
+  s.gridSize = reportedGrid_.load(std::memory_order_relaxed);
+  return s;
+}
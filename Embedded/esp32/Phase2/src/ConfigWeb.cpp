@@ -10,6 +10,9 @@ static bool gRestartRequested = false;
 
 // Web-based debug system
 #define MAX_DEBUG_MESSAGES 40
+
+#define PHASE2_STRINGIFY_IMPL(x) #x
+#define PHASE2_STRINGIFY(x) PHASE2_STRINGIFY_IMPL(x)
 static bool gDebugEnabled = false;
 static char gDebugMessages[MAX_DEBUG_MESSAGES][128];
 static uint16_t gDebugHead = 0;
@@ -24,9 +27,15 @@ static String BuildConfigJson()
   s += "\"velocityDamping\":" + String(gConfig->velocityDamping, 4) + ",";
   s += "\"maxVelocity\":" + String(gConfig->maxVelocity, 3) + ",";
   s += "\"particleCount\":" + String(gConfig->particleCount) + ",";
+  s += "\"particleCapacity\":" + String(gConfig->particleCapacity) + ",";
   s += "\"particleRadius\":" + String(gConfig->particleRadius, 4) + ",";
   s += "\"restDensity\":" + String(gConfig->restDensity, 3) + ",";
   s += "\"picFlipRatio\":" + String(gConfig->picFlipRatio, 3) + ",";
+  s += "\"fluidIterations\":" + String(gConfig->fluidIterations) + ",";
+  s += "\"fluidTolerance\":" + String(gConfig->fluidTolerance, 3) + ",";
+  s += "\"fusedStep\":" + String(gConfig->fusedStep ? 1 : 0) + ",";
+  s += "\"substepCfl\":" + String(gConfig->substepCfl, 2) + ",";
+  s += "\"maxSubsteps\":" + String(gConfig->maxSubsteps) + ",";
   s += "\"gravityX\":" + String(gConfig->gravityX, 3) + ",";
   s += "\"gravityY\":" + String(gConfig->gravityY, 3) + ",";
   s += "\"touchStrength\":" + String(gConfig->touchStrength, 4) + ",";
@@ -37,9 +46,14 @@ static String BuildConfigJson()
   s += "\"smoothRateOut\":" + String(gConfig->smoothRateOut, 3) + ",";
   s += "\"collisionEnabled\":" + String(gConfig->collisionEnabled ? 1 : 0) + ",";
   s += "\"collisionGridSize\":" + String(gConfig->collisionGridSize) + ",";
+  s += "\"collisionGridAuto\":" + String(gConfig->collisionGridAuto ? 1 : 0) + ",";
   s += "\"collisionRepulsion\":" + String(gConfig->collisionRepulsion, 3) + ",";
   s += "\"particleRestitution\":" + String(gConfig->particleRestitution, 3) + ",";
   s += "\"collisionDamping\":" + String(gConfig->collisionDamping, 4) + ",";
+  s += "\"collisionSkin\":" + String(gConfig->collisionSkin, 2) + ",";
+  s += "\"collisionIterations\":" + String(gConfig->collisionIterations) + ",";
+  s += "\"collisionTolerance\":" + String(gConfig->collisionTolerance, 3) + ",";
+  s += "\"collisionThreads\":" + String(gConfig->collisionThreads) + ",";
   s += "\"boundaryMode\":" + String(gConfig->boundaryMode) + ",";
   s += "\"boundaryShape\":" + String(gConfig->boundaryShape) + ",";
   s += "\"boundaryScale\":" + String(gConfig->boundaryScale, 3) + ",";
@@ -72,6 +86,30 @@ static String BuildConfigJson()
   s += "\"turbPhase\":" + String(gConfig->turbPhase, 3) + ",";
   s += "\"turbPhaseSpeed\":" + String(gConfig->turbPhaseSpeed, 3) + ",";
   s += "\"turbBlurAmount\":" + String(gConfig->turbBlurAmount, 3) + ",";
+  s += "\"turbFieldRate\":" + String(gConfig->turbFieldRate, 1) + ",";
+  s += "\"turbFieldPersistence\":" + String(gConfig->turbFieldPersistence, 2) + ",";
+  s += "\"voronoiStrength\":" + String(gConfig->voronoiStrength, 2) + ",";
+  s += "\"voronoiEdgeWidth\":" + String(gConfig->voronoiEdgeWidth, 3) + ",";
+  s += "\"voronoiAttraction\":" + String(gConfig->voronoiAttraction, 2) + ",";
+  s += "\"voronoiCellCount\":" + String(gConfig->voronoiCellCount) + ",";
+  s += "\"voronoiCellSpeed\":" + String(gConfig->voronoiCellSpeed, 3) + ",";
+  s += "\"voronoiDecayRate\":" + String(gConfig->voronoiDecayRate, 3) + ",";
+  s += "\"voronoiBlend\":" + String(gConfig->voronoiBlend, 3) + ",";
+  s += "\"voronoiPullMode\":" + String(gConfig->voronoiPullMode ? 1 : 0) + ",";
+  s += "\"organicBehavior\":" + String(gConfig->organicBehavior) + ",";
+  s += "\"organicRadius\":" + String(gConfig->organicRadius, 3) + ",";
+  s += "\"swarmCohesion\":" + String(gConfig->swarmCohesion, 2) + ",";
+  s += "\"swarmAlignment\":" + String(gConfig->swarmAlignment, 2) + ",";
+  s += "\"swarmSeparation\":" + String(gConfig->swarmSeparation, 2) + ",";
+  s += "\"swarmMaxSpeed\":" + String(gConfig->swarmMaxSpeed, 2) + ",";
+  s += "\"swarmNeighbors\":" + String(gConfig->swarmNeighbors) + ",";
+  s += "\"chainLinkDistance\":" + String(gConfig->chainLinkDistance, 3) + ",";
+  s += "\"chainLinkStrength\":" + String(gConfig->chainLinkStrength, 2) + ",";
+  s += "\"chainAlignment\":" + String(gConfig->chainAlignment, 2) + ",";
+  s += "\"chainBranches\":" + String(gConfig->chainBranches) + ",";
+  s += "\"automataRepulsion\":" + String(gConfig->automataRepulsion, 2) + ",";
+  s += "\"automataAttraction\":" + String(gConfig->automataAttraction, 2) + ",";
+  s += "\"automataThreshold\":" + String(gConfig->automataThreshold, 2) + ",";
   s += "\"targetCellCount\":" + String(gConfig->targetCellCount) + ",";
   s += "\"gridGap\":" + String(gConfig->gridGap) + ",";
   s += "\"theme\":" + String(gConfig->theme) + ",";
@@ -113,7 +151,7 @@ static bool SetParam(const String &key, float value)
   }
   if (key == "particleCount")
   {
-    gConfig->particleCount = (uint16_t)constrain((int)value, 2, 200);
+    gConfig->particleCount = (uint16_t)constrain((int)value, 2, (int)gConfig->particleCapacity);
     return true;
   }
   if (key == "particleRadius")
@@ -131,6 +169,31 @@ static bool SetParam(const String &key, float value)
     gConfig->picFlipRatio = constrain(value, 0.0f, 1.0f);
     return true;
   }
+  if (key == "fluidIterations")
+  {
+    gConfig->fluidIterations = (uint8_t)constrain((int)value, 1, 100);
+    return true;
+  }
+  if (key == "fluidTolerance")
+  {
+    gConfig->fluidTolerance = constrain(value, 0.0f, 0.5f);
+    return true;
+  }
+  if (key == "fusedStep")
+  {
+    gConfig->fusedStep = value >= 0.5f;
+    return true;
+  }
+  if (key == "substepCfl")
+  {
+    gConfig->substepCfl = constrain(value, 0.1f, 2.0f);
+    return true;
+  }
+  if (key == "maxSubsteps")
+  {
+    gConfig->maxSubsteps = (uint8_t)constrain((int)value, 1, 16);
+    return true;
+  }
   if (key == "gravityX")
   {
     gConfig->gravityX = constrain(value, -2.0f, 2.0f);
@@ -153,7 +216,7 @@ static bool SetParam(const String &key, float value)
   }
   if (key == "gridMode")
   {
-    gConfig->gridMode = (uint8_t)constrain((int)value, 0, 8);
+    gConfig->gridMode = (uint8_t)constrain((int)value, 0, 9);
     return true;
   }
   if (key == "maxDensity")
@@ -186,6 +249,11 @@ static bool SetParam(const String &key, float value)
     gConfig->collisionGridSize = (uint8_t)constrain((int)value, 4, 16);
     return true;
   }
+  if (key == "collisionGridAuto")
+  {
+    gConfig->collisionGridAuto = value >= 0.5f;
+    return true;
+  }
   if (key == "particleRestitution")
   {
     gConfig->particleRestitution = constrain(value, 0.0f, 1.0f);
@@ -196,6 +264,26 @@ static bool SetParam(const String &key, float value)
     gConfig->collisionDamping = constrain(value, 0.8f, 1.0f);
     return true;
   }
+  if (key == "collisionSkin")
+  {
+    gConfig->collisionSkin = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "collisionIterations")
+  {
+    gConfig->collisionIterations = (uint8_t)constrain((int)value, 1, 8);
+    return true;
+  }
+  if (key == "collisionTolerance")
+  {
+    gConfig->collisionTolerance = constrain(value, 0.0f, 0.2f);
+    return true;
+  }
+  if (key == "collisionThreads")
+  {
+    gConfig->collisionThreads = (uint8_t)constrain((int)value, 1, SIM_MAX_POOL_WORKERS);
+    return true;
+  }
   if (key == "boundaryMode")
   {
     gConfig->boundaryMode = (uint8_t)constrain((int)value, 0, 1);
@@ -203,7 +291,7 @@ static bool SetParam(const String &key, float value)
   }
   if (key == "boundaryShape")
   {
-    gConfig->boundaryShape = (uint8_t)constrain((int)value, 0, 1);
+    gConfig->boundaryShape = (uint8_t)constrain((int)value, 0, 3);
     gGridDirty = true;
     return true;
   }
@@ -290,7 +378,7 @@ static bool SetParam(const String &key, float value)
   }
   if (key == "turbPatternStyle")
   {
-    gConfig->turbPatternStyle = (uint8_t)constrain((int)value, 0, 14);
+    gConfig->turbPatternStyle = (uint8_t)constrain((int)value, 0, 15);
     return true;
   }
   if (key == "turbDecayRate")
@@ -358,6 +446,126 @@ static bool SetParam(const String &key, float value)
     gConfig->turbBlurAmount = constrain(value, 0.0f, 2.0f);
     return true;
   }
+  if (key == "turbFieldRate")
+  {
+    gConfig->turbFieldRate = constrain(value, 1.0f, 60.0f);
+    return true;
+  }
+  if (key == "turbFieldPersistence")
+  {
+    gConfig->turbFieldPersistence = constrain(value, 0.0f, 0.99f);
+    return true;
+  }
+  if (key == "voronoiStrength")
+  {
+    gConfig->voronoiStrength = constrain(value, 0.0f, 10.0f);
+    return true;
+  }
+  if (key == "voronoiEdgeWidth")
+  {
+    gConfig->voronoiEdgeWidth = constrain(value, 0.01f, 3.0f);
+    return true;
+  }
+  if (key == "voronoiAttraction")
+  {
+    gConfig->voronoiAttraction = constrain(value, 0.0f, 8.0f);
+    return true;
+  }
+  if (key == "voronoiCellCount")
+  {
+    gConfig->voronoiCellCount = (uint8_t)constrain((int)value, 2, 64);
+    return true;
+  }
+  if (key == "voronoiCellSpeed")
+  {
+    gConfig->voronoiCellSpeed = constrain(value, 0.0f, 4.0f);
+    return true;
+  }
+  if (key == "voronoiDecayRate")
+  {
+    gConfig->voronoiDecayRate = constrain(value, 0.1f, 1.0f);
+    return true;
+  }
+  if (key == "voronoiBlend")
+  {
+    gConfig->voronoiBlend = constrain(value, 0.0f, 1.0f);
+    return true;
+  }
+  if (key == "voronoiPullMode")
+  {
+    gConfig->voronoiPullMode = value >= 0.5f;
+    return true;
+  }
+  if (key == "organicBehavior")
+  {
+    gConfig->organicBehavior = (uint8_t)constrain((int)value, 0, 3);
+    return true;
+  }
+  if (key == "organicRadius")
+  {
+    gConfig->organicRadius = constrain(value, 0.02f, 0.4f);
+    return true;
+  }
+  if (key == "swarmCohesion")
+  {
+    gConfig->swarmCohesion = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "swarmAlignment")
+  {
+    gConfig->swarmAlignment = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "swarmSeparation")
+  {
+    gConfig->swarmSeparation = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "swarmMaxSpeed")
+  {
+    gConfig->swarmMaxSpeed = constrain(value, 0.0f, 1.0f);
+    return true;
+  }
+  if (key == "swarmNeighbors")
+  {
+    gConfig->swarmNeighbors = (uint8_t)constrain((int)value, 1, 24);
+    return true;
+  }
+  if (key == "chainLinkDistance")
+  {
+    gConfig->chainLinkDistance = constrain(value, 0.0f, 0.2f);
+    return true;
+  }
+  if (key == "chainLinkStrength")
+  {
+    gConfig->chainLinkStrength = constrain(value, 0.0f, 10.0f);
+    return true;
+  }
+  if (key == "chainAlignment")
+  {
+    gConfig->chainAlignment = constrain(value, 0.0f, 10.0f);
+    return true;
+  }
+  if (key == "chainBranches")
+  {
+    gConfig->chainBranches = (uint8_t)constrain((int)value, 1, 4);
+    return true;
+  }
+  if (key == "automataRepulsion")
+  {
+    gConfig->automataRepulsion = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "automataAttraction")
+  {
+    gConfig->automataAttraction = constrain(value, 0.0f, 2.0f);
+    return true;
+  }
+  if (key == "automataThreshold")
+  {
+    gConfig->automataThreshold = constrain(value, 0.0f, 1.0f);
+    return true;
+  }
   if (key == "targetCellCount")
   {
     gConfig->targetCellCount = (uint16_t)constrain((int)value, 32, 512);
@@ -551,10 +759,15 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
         ["timeScale",0.1,8,0.01],
         ["velocityDamping",0.8,1.0,0.001],
         ["maxVelocity",0.1,8,0.1],
-        ["particleCount",50,500,1],
+        ["particleCount",2,)HTML" PHASE2_STRINGIFY(SIM_PARTICLE_CAPACITY) R"HTML(,1],
         ["particleRadius",0.002,0.05,0.001],
         ["restDensity",0,40,0.1],
-        ["picFlipRatio",0,1,0.01]
+        ["picFlipRatio",0,1,0.01],
+        ["fluidIterations",1,100,1],
+        ["fluidTolerance",0,0.5,0.01],
+        ["fusedStep",0,1,1],
+        ["substepCfl",0.1,2,0.05],
+        ["maxSubsteps",1,16,1]
       ]],
       ["Gravity & Touch", [
         ["gravityX",-2,2,0.01],
@@ -563,7 +776,7 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
         ["touchRadius",0.01,1.2,0.005]
       ]],
       ["Rendering & Grid", [
-        ["gridMode",0,8,1],
+        ["gridMode",0,9,1],
         ["maxDensity",0.1,8,0.01],
         ["smoothRateIn",0,1,0.01],
         ["smoothRateOut",0,1,0.01],
@@ -580,6 +793,7 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
       ]],
       ["Boundary", [
         ["boundaryMode",0,1,1],
+        ["boundaryShape",0,3,1],
         ["boundaryScale",0.6,1.2,0.01],
         ["boundaryDamping",0,1,0.01],
         ["boundaryRestitution",0,1,0.05],
@@ -588,10 +802,15 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
       ]],
       ["Collision", [
         ["collisionEnabled",0,1,1],
+        ["collisionGridAuto",0,1,1],
         ["collisionGridSize",4,16,1],
         ["collisionRepulsion",0,2,0.01],
         ["particleRestitution",0,1,0.05],
-        ["collisionDamping",0.8,1.0,0.001]
+        ["collisionDamping",0.8,1.0,0.001],
+        ["collisionSkin",0,2,0.05],
+        ["collisionIterations",1,8,1],
+        ["collisionTolerance",0,0.2,0.005],
+        ["collisionThreads",1,)HTML" PHASE2_STRINGIFY(SIM_MAX_POOL_WORKERS) R"HTML(,1]
       ]],
       ["Turbulence", [
         ["turbStrength",0,20,0.5],
@@ -605,7 +824,7 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
         ["turbAffectScale",0,1,1],
         ["turbMinScale",0.005,0.015,0.001],
         ["turbMaxScale",0.015,0.03,0.001],
-        ["turbPatternStyle",0,14,1],
+        ["turbPatternStyle",0,15,1],
         ["turbDecayRate",0.9,1.0,0.01],
         ["turbDirectionBiasX",-1,1,0.01],
         ["turbDirectionBiasY",-1,1,0.01],
@@ -618,7 +837,35 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
         ["turbSymmetryAmount",0,1,0.01],
         ["turbPhase",0,1,0.01],
         ["turbPhaseSpeed",-1,1,0.1],
-        ["turbBlurAmount",0,2,0.01]
+        ["turbBlurAmount",0,2,0.01],
+        ["turbFieldRate",1,60,1],
+        ["turbFieldPersistence",0,0.99,0.01]
+      ]],
+      ["Voronoi", [
+        ["voronoiStrength",0,10,0.1],
+        ["voronoiEdgeWidth",0.01,3,0.01],
+        ["voronoiAttraction",0,8,0.1],
+        ["voronoiCellCount",2,64,1],
+        ["voronoiCellSpeed",0,4,0.01],
+        ["voronoiDecayRate",0.1,1,0.01],
+        ["voronoiBlend",0,1,0.01],
+        ["voronoiPullMode",0,1,1]
+      ]],
+      ["Organic", [
+        ["organicBehavior",0,3,1],
+        ["organicRadius",0.02,0.4,0.005],
+        ["swarmCohesion",0,2,0.01],
+        ["swarmAlignment",0,2,0.01],
+        ["swarmSeparation",0,2,0.01],
+        ["swarmMaxSpeed",0,1,0.01],
+        ["swarmNeighbors",1,24,1],
+        ["chainLinkDistance",0,0.2,0.001],
+        ["chainLinkStrength",0,10,0.1],
+        ["chainAlignment",0,10,0.1],
+        ["chainBranches",1,4,1],
+        ["automataRepulsion",0,2,0.01],
+        ["automataAttraction",0,2,0.01],
+        ["automataThreshold",0,1,0.01]
       ]]
     ];
     const root = document.getElementById("controls");
@@ -639,7 +886,14 @@ static const char kIndexHtml[] PROGMEM = R"HTML(
         [5, "Pressure"],
         [6, "Vorticity"],
         [7, "Collision"],
-        [8, "Overlap"]
+        [8, "Overlap"],
+        [9, "Automata"]
+      ],
+      organicBehavior: [
+        [0, "None"],
+        [1, "Swarm"],
+        [2, "Chain"],
+        [3, "Automata"]
       ],
       theme: [
         [0, "C0"],
@@ -1,15 +1,355 @@
 #include "FluidFLIP.h"
 
+#include <math.h>
 #include <string.h>
 
+static constexpr float kCellSize = 1.0f / FLIP_GRID;
+// Red-black SOR factor, near 2 / (1 + sin(pi / FLIP_GRID)).
+static constexpr float kOverRelaxation = 1.7f;
+// Outflow demanded of a cell at twice restDensity, in cells per step.
+static constexpr float kDriftStiffness = 0.1f;
+
+// Bilinear footprint of a point on a lattice of cols x rows samples (grid units).
+struct Splat
+{
+  uint16_t index;
+  uint16_t stride;
+  float w00;
+  float w10;
+  float w01;
+  float w11;
+};
+
+static inline Splat splat(float gx, float gy, int cols, int rows)
+{
+  int i = (int)floorf(gx);
+  int j = (int)floorf(gy);
+  i = i < 0 ? 0 : (i > cols - 2 ? cols - 2 : i);
+  j = j < 0 ? 0 : (j > rows - 2 ? rows - 2 : j);
+  float tx = gx - i;
+  float ty = gy - j;
+  tx = tx < 0.0f ? 0.0f : (tx > 1.0f ? 1.0f : tx);
+  ty = ty < 0.0f ? 0.0f : (ty > 1.0f ? 1.0f : ty);
+  Splat s;
+  s.index = (uint16_t)(j * cols + i);
+  s.stride = (uint16_t)cols;
+  s.w00 = (1.0f - tx) * (1.0f - ty);
+  s.w10 = tx * (1.0f - ty);
+  s.w01 = (1.0f - tx) * ty;
+  s.w11 = tx * ty;
+  return s;
+}
+
+static inline void accumulate(const Splat &s, float *weights)
+{
+  weights[s.index] += s.w00;
+  weights[s.index + 1] += s.w10;
+  weights[s.index + s.stride] += s.w01;
+  weights[s.index + s.stride + 1] += s.w11;
+}
+
+static inline void scatter(const Splat &s, float *values, float *weights, float v)
+{
+  values[s.index] += s.w00 * v;
+  values[s.index + 1] += s.w10 * v;
+  values[s.index + s.stride] += s.w01 * v;
+  values[s.index + s.stride + 1] += s.w11 * v;
+  accumulate(s, weights);
+}
+
+// Splat weights restricted to valid faces; returns their sum.
+static inline float gather(const Splat &s, const float *valid, const float *a, const float *b, float &sumA, float &sumB)
+{
+  const uint16_t k[4] = {s.index, (uint16_t)(s.index + 1), (uint16_t)(s.index + s.stride), (uint16_t)(s.index + s.stride + 1)};
+  const float w[4] = {s.w00, s.w10, s.w01, s.w11};
+  float total = 0.0f;
+  sumA = 0.0f;
+  sumB = 0.0f;
+  for (uint8_t n = 0; n < 4; ++n)
+  {
+    const float wv = w[n] * valid[k[n]];
+    total += wv;
+    sumA += wv * a[k[n]];
+    sumB += wv * b[k[n]];
+  }
+  return total;
+}
+
+static inline uint16_t uIndex(int i, int j)
+{
+  return (uint16_t)(j * (FLIP_GRID + 1) + i);
+}
+
+static inline uint16_t vIndex(int i, int j)
+{
+  return (uint16_t)(j * FLIP_GRID + i);
+}
+
 void FluidFLIP::clear()
 {
   memset(pressure_, 0, sizeof(pressure_));
   memset(divergence_, 0, sizeof(divergence_));
+  solidShape_ = 0xFF;
+  stats_ = FluidStats();
+}
+
+FluidStats FluidFLIP::consumeStats()
+{
+  const FluidStats s = stats_;
+  stats_ = FluidStats();
+  return s;
+}
+
+void FluidFLIP::step(const Boundary &boundary, const float *x, const float *y, float *vx, float *vy, uint16_t count, float dt)
+{
+  const float posScale = dt * config_->timeScale;
+  if (config_->picFlipRatio <= 0.0f || count == 0 || posScale <= 0.0f)
+  {
+    return;
+  }
+  if (config_->boundaryShape != solidShape_ || config_->boundaryScale != solidScale_)
+  {
+    markSolids(boundary);
+  }
+  transferToGrid(x, y, vx, vy, count);
+  applyBoundaryConditions();
+  solveIncompressibility(posScale);
+  transferToParticles(x, y, vx, vy, count);
+  ++stats_.steps;
+}
+
+void FluidFLIP::markSolids(const Boundary &boundary)
+{
+  for (uint8_t j = 0; j < FLIP_GRID; ++j)
+  {
+    for (uint8_t i = 0; i < FLIP_GRID; ++i)
+    {
+      solid_[j * FLIP_GRID + i] = boundary.signedDistance((i + 0.5f) * kCellSize, (j + 0.5f) * kCellSize) > 0.0f ? 1 : 0;
+    }
+  }
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      const uint8_t open = (isOpen(i - 1, j) ? OPEN_LEFT : 0) | (isOpen(i + 1, j) ? OPEN_RIGHT : 0) |
+                           (isOpen(i, j - 1) ? OPEN_DOWN : 0) | (isOpen(i, j + 1) ? OPEN_UP : 0);
+      const uint8_t sides = (open & 1) + (open >> 1 & 1) + (open >> 2 & 1) + (open >> 3 & 1);
+      open_[j * FLIP_GRID + i] = open;
+      relax_[j * FLIP_GRID + i] = sides > 0 ? kOverRelaxation / sides : 0.0f;
+    }
+  }
+  solidShape_ = config_->boundaryShape;
+  solidScale_ = config_->boundaryScale;
+}
+
+bool FluidFLIP::isOpen(int i, int j) const
+{
+  return i >= 0 && i < FLIP_GRID && j >= 0 && j < FLIP_GRID && !solid_[j * FLIP_GRID + i];
+}
+
+void FluidFLIP::transferToGrid(const float *x, const float *y, const float *vx, const float *vy, uint16_t count)
+{
+  memset(u_, 0, sizeof(u_));
+  memset(v_, 0, sizeof(v_));
+  memset(weightU_, 0, sizeof(weightU_));
+  memset(weightV_, 0, sizeof(weightV_));
+  memset(density_, 0, sizeof(density_));
+  for (uint16_t c = 0; c < FLIP_CELLS; ++c)
+  {
+    cellType_[c] = solid_[c] ? CELL_SOLID : CELL_AIR;
+  }
+
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const float gx = x[i] * FLIP_GRID;
+    const float gy = y[i] * FLIP_GRID;
+    int cx = (int)gx;
+    int cy = (int)gy;
+    cx = cx < 0 ? 0 : (cx >= FLIP_GRID ? FLIP_GRID - 1 : cx);
+    cy = cy < 0 ? 0 : (cy >= FLIP_GRID ? FLIP_GRID - 1 : cy);
+    uint8_t &type = cellType_[cy * FLIP_GRID + cx];
+    type = type == CELL_SOLID ? CELL_SOLID : CELL_FLUID;
+    scatter(splat(gx, gy - 0.5f, FLIP_GRID + 1, FLIP_GRID), u_, weightU_, vx[i]);
+    scatter(splat(gx - 0.5f, gy, FLIP_GRID, FLIP_GRID + 1), v_, weightV_, vy[i]);
+    accumulate(splat(gx - 0.5f, gy - 0.5f, FLIP_GRID, FLIP_GRID), density_);
+  }
+
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i <= FLIP_GRID; ++i)
+    {
+      const uint16_t f = uIndex(i, j);
+      u_[f] = weightU_[f] > 0.0f ? u_[f] / weightU_[f] : 0.0f;
+      const bool left = i > 0 && cellType_[j * FLIP_GRID + i - 1] == CELL_FLUID;
+      const bool right = i < FLIP_GRID && cellType_[j * FLIP_GRID + i] == CELL_FLUID;
+      weightU_[f] = left || right ? 1.0f : 0.0f;
+    }
+  }
+  for (int j = 0; j <= FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      const uint16_t f = vIndex(i, j);
+      v_[f] = weightV_[f] > 0.0f ? v_[f] / weightV_[f] : 0.0f;
+      const bool below = j > 0 && cellType_[(j - 1) * FLIP_GRID + i] == CELL_FLUID;
+      const bool above = j < FLIP_GRID && cellType_[j * FLIP_GRID + i] == CELL_FLUID;
+      weightV_[f] = below || above ? 1.0f : 0.0f;
+    }
+  }
+  memcpy(prevU_, u_, sizeof(u_));
+  memcpy(prevV_, v_, sizeof(v_));
+}
+
+// No flow through faces that touch a solid cell or the edge of the grid.
+void FluidFLIP::applyBoundaryConditions()
+{
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i <= FLIP_GRID; ++i)
+    {
+      if (!isOpen(i - 1, j) || !isOpen(i, j))
+      {
+        u_[uIndex(i, j)] = 0.0f;
+      }
+    }
+  }
+  for (int j = 0; j <= FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      if (!isOpen(i, j - 1) || !isOpen(i, j))
+      {
+        v_[vIndex(i, j)] = 0.0f;
+      }
+    }
+  }
+}
+
+void FluidFLIP::push(int i, int j, uint8_t open, float p)
+{
+  // Faces toward closed neighbors are zero and stay zero.
+  u_[uIndex(i, j)] -= (open & OPEN_LEFT) ? p : 0.0f;
+  u_[uIndex(i + 1, j)] += (open & OPEN_RIGHT) ? p : 0.0f;
+  v_[vIndex(i, j)] -= (open & OPEN_DOWN) ? p : 0.0f;
+  v_[vIndex(i, j + 1)] += (open & OPEN_UP) ? p : 0.0f;
+}
+
+float FluidFLIP::residual(int i, int j) const
+{
+  return target_[j * FLIP_GRID + i] - (u_[uIndex(i + 1, j)] - u_[uIndex(i, j)] + v_[vIndex(i, j + 1)] - v_[vIndex(i, j)]);
+}
+
+void FluidFLIP::solveIncompressibility(float posScale)
+{
+  const float rest = config_->restDensity;
+  const float drift = rest > 0.0f ? kDriftStiffness * kCellSize / posScale : 0.0f;
+
+  uint16_t fluidCells = 0;
+  float sumIn = 0.0f;
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      const uint16_t c = j * FLIP_GRID + i;
+      const float crowding = drift > 0.0f && density_[c] > rest ? density_[c] / rest - 1.0f : 0.0f;
+      target_[c] = drift * crowding;
+      divergence_[c] = u_[uIndex(i + 1, j)] - u_[uIndex(i, j)] + v_[vIndex(i, j + 1)] - v_[vIndex(i, j)];
+      if (cellType_[c] != CELL_FLUID)
+      {
+        pressure_[c] = 0.0f;
+        continue;
+      }
+      ++fluidCells;
+      sumIn += (divergence_[c] - target_[c]) * (divergence_[c] - target_[c]);
+    }
+  }
+  if (fluidCells == 0)
+  {
+    return;
+  }
+
+  // Warm start: the previous step's pressure on the cells that are still fluid.
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      const uint16_t c = j * FLIP_GRID + i;
+      if (pressure_[c] != 0.0f)
+      {
+        push(i, j, open_[c], pressure_[c]);
+      }
+    }
+  }
+
+  // Red-black sweeps: cells of one color share no faces, so each half-sweep is order-free.
+  // The residual is summed as each cell is relaxed, so it lags the final state by one sweep.
+  const float limit = config_->fluidTolerance * sqrtf(sumIn / fluidCells);
+  uint8_t sweeps = 0;
+  float rms = limit + 1.0f;
+  while (sweeps < config_->fluidIterations && rms > limit)
+  {
+    float sum = 0.0f;
+    for (uint8_t color = 0; color < 2; ++color)
+    {
+      for (int j = 0; j < FLIP_GRID; ++j)
+      {
+        for (int i = (j + color) & 1; i < FLIP_GRID; i += 2)
+        {
+          const uint16_t c = j * FLIP_GRID + i;
+          if (cellType_[c] != CELL_FLUID || open_[c] == 0)
+          {
+            continue;
+          }
+          const float r = residual(i, j);
+          const float p = r * relax_[c];
+          push(i, j, open_[c], p);
+          pressure_[c] += p;
+          sum += r * r;
+        }
+      }
+    }
+    rms = sqrtf(sum / fluidCells);
+    ++sweeps;
+  }
+
+  float sumOut = 0.0f;
+  for (int j = 0; j < FLIP_GRID; ++j)
+  {
+    for (int i = 0; i < FLIP_GRID; ++i)
+    {
+      if (cellType_[j * FLIP_GRID + i] == CELL_FLUID)
+      {
+        const float r = residual(i, j);
+        sumOut += r * r;
+      }
+    }
+  }
+  stats_.fluidCells += fluidCells;
+  stats_.sweeps += sweeps;
+  stats_.divergenceIn += sqrtf(sumIn / fluidCells);
+  stats_.divergenceOut += sqrtf(sumOut / fluidCells);
 }
 
-void FluidFLIP::step(float dt)
+void FluidFLIP::transferToParticles(const float *x, const float *y, float *vx, float *vy, uint16_t count) const
 {
-  (void)dt;
-  (void)config_;
+  const float pic = config_->picFlipRatio < 1.0f ? config_->picFlipRatio : 1.0f;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const float gx = x[i] * FLIP_GRID;
+    const float gy = y[i] * FLIP_GRID;
+    float grid;
+    float before;
+    float w = gather(splat(gx, gy - 0.5f, FLIP_GRID + 1, FLIP_GRID), weightU_, u_, prevU_, grid, before);
+    if (w > 0.0f)
+    {
+      grid /= w;
+      vx[i] = pic * grid + (1.0f - pic) * (vx[i] + grid - before / w);
+    }
+    w = gather(splat(gx - 0.5f, gy, FLIP_GRID, FLIP_GRID + 1), weightV_, v_, prevV_, grid, before);
+    if (w > 0.0f)
+    {
+      grid /= w;
+      vy[i] = pic * grid + (1.0f - pic) * (vy[i] + grid - before / w);
+    }
+  }
 }
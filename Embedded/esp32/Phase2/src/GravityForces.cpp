@@ -1,13 +1,18 @@
 #include "GravityForces.h"
 
+#include "SimdF4.h"
+
 namespace GravityForces
 {
 void apply(float gx, float gy, float dt, float *velX, float *velY, uint16_t count)
 {
-  for (uint16_t i = 0; i < count; ++i)
+  const Simd::F4 dvx = Simd::set1(gx * dt);
+  const Simd::F4 dvy = Simd::set1(gy * dt);
+  const uint16_t lanes = Simd::paddedCount(count);
+  for (uint16_t i = 0; i < lanes; i += SIMD_WIDTH)
   {
-    velX[i] += gx * dt;
-    velY[i] += gy * dt;
+    Simd::store(velX + i, Simd::add(Simd::load(velX + i), dvx));
+    Simd::store(velY + i, Simd::add(Simd::load(velY + i), dvy));
   }
 }
 }
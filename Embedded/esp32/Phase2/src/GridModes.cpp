@@ -3,6 +3,107 @@
 #include <math.h>
 #include <string.h>
 
+static inline size_t alignedBytes(size_t bytes)
+{
+  return (bytes + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+// Pair falloff distance: twice the summed radii (4r for uniform particles).
+static inline float pairRadius(const float *radius, float uniform, uint16_t i, uint16_t j)
+{
+  const float r = (radius ? radius[i] + radius[j] : 2.0f * uniform) * 2.0f;
+  return r <= 1e-6f ? 1e-6f : r;
+}
+
+struct GatherVisitor
+{
+  uint16_t *out;
+  uint16_t count;
+
+  void operator()(uint16_t j) { out[count++] = j; }
+};
+
+// ProximityB, first pass: for each particle, closeness to and number of the higher-index
+// particles within the pair radius.
+struct ClosenessVisitor
+{
+  const float *radius;
+  float uniform;
+  float *sum;
+  float *pairs;
+
+  void operator()(uint16_t i, uint16_t j, float, float, float d2)
+  {
+    const float reach = pairRadius(radius, uniform, i, j);
+    const float d = sqrtf(d2);
+    if (d < reach)
+    {
+      sum[i] += 1.0f - d / reach;
+      pairs[i] += 1.0f;
+    }
+  }
+};
+
+bool GridModes::begin(uint16_t capacity)
+{
+  if (arena_.isReady())
+  {
+    return true;
+  }
+  const size_t indexBytes = alignedBytes((size_t)capacity * sizeof(uint16_t));
+  const size_t floatBytes = alignedBytes((size_t)capacity * sizeof(float));
+  // Touched once per render frame, so it lives in the bulk (PSRAM) region like the snapshots.
+  if (!arena_.begin(0, NeighborGrid::storageBytes(capacity) + indexBytes + 2 * floatBytes))
+  {
+    return false;
+  }
+  grid_.begin(arena_, ARENA_BULK, capacity);
+  near_ = (uint16_t *)arena_.alloc(ARENA_BULK, indexBytes);
+  sum_ = (float *)arena_.alloc(ARENA_BULK, floatBytes);
+  weight_ = (float *)arena_.alloc(ARENA_BULK, floatBytes);
+  capacity_ = capacity;
+  return true;
+}
+
+const NeighborGrid *GridModes::neighborsFor(const ParticleView &sim, float cutoff)
+{
+  if (!near_ || sim.getCount() > capacity_)
+  {
+    return nullptr;
+  }
+  if (sim.getNeighbors())
+  {
+    return sim.getNeighbors();
+  }
+  if (!grid_.matches(sim.getX(), sim.getY(), sim.getCount()) || grid_.getGridSize() > NeighborGrid::fitGridSize(cutoff, sim.getCount()))
+  {
+    grid_.build(sim.getX(), sim.getY(), sim.getCount(), NeighborGrid::fitGridSize(cutoff, sim.getCount()));
+  }
+  return &grid_;
+}
+
+float GridModes::maxRadius(const ParticleView &sim) const
+{
+  const float *radius = sim.getRadius();
+  float rMax = config_->particleRadius;
+  if (radius && sim.getCount() > 0)
+  {
+    rMax = radius[0];
+    for (uint16_t i = 1; i < sim.getCount(); ++i)
+    {
+      rMax = radius[i] > rMax ? radius[i] : rMax;
+    }
+  }
+  return rMax;
+}
+
+uint16_t GridModes::gatherCell(const NeighborGrid &grid, float cellX, float cellY, float halfW, float halfH, float reach)
+{
+  GatherVisitor gather = {near_, 0};
+  grid.forEachInBox(cellX - halfW - reach, cellY - halfH - reach, cellX + halfW + reach, cellY + halfH + reach, gather);
+  return gather.count;
+}
+
 uint16_t GridModes::activeCellCount(const GridGeometry &geom, uint16_t outCount) const
 {
   const uint16_t geomCells = geom.getCellCount();
@@ -42,6 +143,11 @@ float GridModes::cellContribution(float px, float py, float cellX, float cellY,
   return 1.0f - (sqrtf(distSq) / radius);
 }
 
+float GridModes::radiusOf(const float *radius, uint16_t i) const
+{
+  return radius ? radius[i] : config_->particleRadius;
+}
+
 void GridModes::smoothAndStore(const float *target, uint16_t cells, uint8_t *outValues, uint16_t outCount)
 {
   for (uint16_t c = 0; c < cells; ++c)
@@ -85,7 +191,7 @@ void GridModes::clearToZero(uint16_t cells, uint8_t *outValues, uint16_t outCoun
   smoothAndStore(zeroTarget, cells, outValues, outCount);
 }
 
-void GridModes::compute(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::compute(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   switch (config_->gridMode)
   {
@@ -110,6 +216,9 @@ void GridModes::compute(const SimCore &sim, const GridGeometry &geom, uint8_t *o
   case 8:
     computeOverlap(sim, geom, outValues, outCount);
     break;
+  case 9:
+    computeAutomata(sim, geom, outValues, outCount);
+    break;
   // 0=Noise and 6=Vorticity are intentionally deferred in Phase2.
   default:
     clearToZero(activeCellCount(geom, outCount), outValues, outCount);
@@ -117,7 +226,7 @@ void GridModes::compute(const SimCore &sim, const GridGeometry &geom, uint8_t *o
   }
 }
 
-void GridModes::computeProximity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeProximity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
@@ -148,7 +257,7 @@ void GridModes::computeProximity(const SimCore &sim, const GridGeometry &geom, u
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computeProximityB(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeProximityB(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
@@ -159,37 +268,40 @@ void GridModes::computeProximityB(const SimCore &sim, const GridGeometry &geom,
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float baseRadius = config_->particleRadius * 3.0f;
-  const float pairRadius = config_->particleRadius * 4.0f;
-  const float pairRadiusSafe = pairRadius <= 1e-6f ? 1e-6f : pairRadius;
+  const float *pr = sim.getRadius();
   const float maxDensity = config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity;
+  const float rMax = maxRadius(sim);
+  const NeighborGrid *neighbors = neighborsFor(sim, rMax * 4.0f);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
 
+  // A cell sums closeness * w over the pairs (i, j > i) of every particle i reaching it, with w
+  // i's weight in that cell; the pair sums do not depend on the cell, so they are taken once.
+  memset(sum_, 0, pCount * sizeof(float));
+  memset(weight_, 0, pCount * sizeof(float));
+  ClosenessVisitor closeness = {pr, config_->particleRadius, sum_, weight_};
+  neighbors->forEachPair(rMax * 4.0f, closeness);
+
   for (uint16_t c = 0; c < cells; ++c)
   {
     float sum = 0.0f;
     float weightSum = 0.0f;
-    for (uint16_t i = 0; i < pCount; ++i)
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, rMax * 3.0f);
+    for (uint16_t k = 0; k < n; ++k)
     {
-      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, baseRadius);
+      const uint16_t i = near_[k];
+      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 3.0f);
       if (w <= 0.0f)
       {
         continue;
       }
-      for (uint16_t j = i + 1; j < pCount; ++j)
-      {
-        const float dx = px[j] - px[i];
-        const float dy = py[j] - py[i];
-        const float d = sqrtf(dx * dx + dy * dy);
-        if (d >= pairRadiusSafe)
-        {
-          continue;
-        }
-        const float closeness = 1.0f - (d / pairRadiusSafe);
-        sum += closeness * w;
-        weightSum += w;
-      }
+      sum += sum_[i] * w;
+      weightSum += weight_[i] * w;
     }
     if (weightSum > 1e-6f)
     {
@@ -200,28 +312,36 @@ void GridModes::computeProximityB(const SimCore &sim, const GridGeometry &geom,
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computeDensity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeDensity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
   const float *px = sim.getX();
   const float *py = sim.getY();
-  const uint16_t pCount = sim.getCount();
   const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float radius = config_->particleRadius * 2.0f;
+  const float *pr = sim.getRadius();
   const float maxDensity = config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity;
+  const float reach = maxRadius(sim) * 2.0f;
+  const NeighborGrid *neighbors = neighborsFor(sim, reach);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
 
   for (uint16_t c = 0; c < cells; ++c)
   {
     float density = 0.0f;
-    for (uint16_t i = 0; i < pCount; ++i)
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
+    for (uint16_t k = 0; k < n; ++k)
     {
-      density += cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radius);
+      const uint16_t i = near_[k];
+      density += cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.0f);
     }
     target[c] = density / maxDensity;
   }
@@ -229,7 +349,7 @@ void GridModes::computeDensity(const SimCore &sim, const GridGeometry &geom, uin
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computeVelocity(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeVelocity(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
@@ -237,23 +357,31 @@ void GridModes::computeVelocity(const SimCore &sim, const GridGeometry &geom, ui
   const float *py = sim.getY();
   const float *vx = sim.getVx();
   const float *vy = sim.getVy();
-  const uint16_t pCount = sim.getCount();
   const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float radius = config_->particleRadius * 2.0f;
+  const float *pr = sim.getRadius();
   const float maxVelocity = config_->maxVelocity <= 1e-6f ? 1.0f : config_->maxVelocity;
   const float norm = maxVelocity * (config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity);
+  const float reach = maxRadius(sim) * 2.0f;
+  const NeighborGrid *neighbors = neighborsFor(sim, reach);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
 
   for (uint16_t c = 0; c < cells; ++c)
   {
     float accum = 0.0f;
-    for (uint16_t i = 0; i < pCount; ++i)
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
+    for (uint16_t k = 0; k < n; ++k)
     {
-      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radius);
+      const uint16_t i = near_[k];
+      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.0f);
       if (w <= 0.0f)
       {
         continue;
@@ -267,41 +395,49 @@ void GridModes::computeVelocity(const SimCore &sim, const GridGeometry &geom, ui
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computePressure(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computePressure(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
   const float *px = sim.getX();
   const float *py = sim.getY();
-  const uint16_t pCount = sim.getCount();
   const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float radius = config_->particleRadius * 2.5f;
+  const float *pr = sim.getRadius();
   const float maxDensity = config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity;
+  const float reach = maxRadius(sim) * 2.5f;
+  const NeighborGrid *neighbors = neighborsFor(sim, reach);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
 
   for (uint16_t c = 0; c < cells; ++c)
   {
     float coverage = 0.0f;
-    for (uint16_t i = 0; i < pCount; ++i)
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
+    for (uint16_t k = 0; k < n; ++k)
     {
-      coverage += cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radius);
+      const uint16_t i = near_[k];
+      coverage += cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.5f);
     }
-    float n = coverage / maxDensity;
-    if (n > 1.0f)
+    float fill = coverage / maxDensity;
+    if (fill > 1.0f)
     {
-      n = 1.0f;
+      fill = 1.0f;
     }
-    target[c] = n * n;
+    target[c] = fill * fill;
   }
 
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computeCollision(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeCollision(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
@@ -309,48 +445,52 @@ void GridModes::computeCollision(const SimCore &sim, const GridGeometry &geom, u
   const float *py = sim.getY();
   const float *vx = sim.getVx();
   const float *vy = sim.getVy();
-  const uint16_t pCount = sim.getCount();
   const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float radius = config_->particleRadius * 2.0f;
-  const float pairRadius = config_->particleRadius * 4.0f;
-  const float pairRadiusSafe = pairRadius <= 1e-6f ? 1e-6f : pairRadius;
+  const float *pr = sim.getRadius();
   const float norm = (config_->maxVelocity <= 1e-6f ? 1.0f : config_->maxVelocity) * (config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity);
+  const float reach = maxRadius(sim) * 2.0f;
+  const NeighborGrid *neighbors = neighborsFor(sim, reach);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
-  static uint16_t nearIdx[MAX_PARTICLES];
-  static float nearWeight[MAX_PARTICLES];
 
   for (uint16_t c = 0; c < cells; ++c)
   {
+    // Candidates reaching the cell are compacted in place, weights alongside; the pairs only
+    // span that short list.
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
     uint16_t nearCount = 0;
-    for (uint16_t i = 0; i < pCount; ++i)
+    for (uint16_t k = 0; k < n; ++k)
     {
-      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radius);
+      const uint16_t i = near_[k];
+      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.0f);
       if (w <= 0.0f)
       {
         continue;
       }
-      if (nearCount < MAX_PARTICLES)
-      {
-        nearIdx[nearCount] = i;
-        nearWeight[nearCount] = w;
-        ++nearCount;
-      }
+      near_[nearCount] = i;
+      weight_[nearCount] = w;
+      ++nearCount;
     }
 
     float intensity = 0.0f;
     for (uint16_t a = 0; a < nearCount; ++a)
     {
-      const uint16_t i = nearIdx[a];
+      const uint16_t i = near_[a];
       for (uint16_t b = a + 1; b < nearCount; ++b)
       {
-        const uint16_t j = nearIdx[b];
+        const uint16_t j = near_[b];
         const float dx = px[j] - px[i];
         const float dy = py[j] - py[i];
         const float dist = sqrtf(dx * dx + dy * dy);
+        const float pairRadiusSafe = pairRadius(pr, config_->particleRadius, i, j);
         if (dist >= pairRadiusSafe)
         {
           continue;
@@ -360,7 +500,7 @@ void GridModes::computeCollision(const SimCore &sim, const GridGeometry &geom, u
         const float dvy = vy[j] - vy[i];
         const float relSpeed = sqrtf(dvx * dvx + dvy * dvy);
         const float closeness = 1.0f - (dist / pairRadiusSafe);
-        const float w = (nearWeight[a] + nearWeight[b]) * 0.5f;
+        const float w = (weight_[a] + weight_[b]) * 0.5f;
         intensity += closeness * relSpeed * w;
       }
     }
@@ -370,28 +510,36 @@ void GridModes::computeCollision(const SimCore &sim, const GridGeometry &geom, u
   smoothAndStore(target, cells, outValues, outCount);
 }
 
-void GridModes::computeOverlap(const SimCore &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+void GridModes::computeOverlap(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
 {
   const uint16_t cells = activeCellCount(geom, outCount);
   const GridCell *grid = geom.getCells();
   const float *px = sim.getX();
   const float *py = sim.getY();
-  const uint16_t pCount = sim.getCount();
   const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
   const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
   const float halfW = 0.5f / (float)cols;
   const float halfH = 0.5f / (float)rows;
-  const float radius = config_->particleRadius * 2.0f;
+  const float *pr = sim.getRadius();
   const float maxDensity = config_->maxDensity <= 1e-6f ? 1.0f : config_->maxDensity;
+  const float reach = maxRadius(sim) * 2.0f;
+  const NeighborGrid *neighbors = neighborsFor(sim, reach);
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
   float target[MAX_GRID_CELLS];
   memset(target, 0, sizeof(target));
 
   for (uint16_t c = 0; c < cells; ++c)
   {
     float overlap = 0.0f;
-    for (uint16_t i = 0; i < pCount; ++i)
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
+    for (uint16_t k = 0; k < n; ++k)
     {
-      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radius);
+      const uint16_t i = near_[k];
+      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.0f);
       overlap += w * w;
     }
     target[c] = overlap / maxDensity;
@@ -399,3 +547,51 @@ void GridModes::computeOverlap(const SimCore &sim, const GridGeometry &geom, uin
 
   smoothAndStore(target, cells, outValues, outCount);
 }
+
+void GridModes::computeAutomata(const ParticleView &sim, const GridGeometry &geom, uint8_t *outValues, uint16_t outCount)
+{
+  const uint16_t cells = activeCellCount(geom, outCount);
+  const GridCell *grid = geom.getCells();
+  const float *px = sim.getX();
+  const float *py = sim.getY();
+  const uint32_t *states = sim.getStates();
+  const uint8_t cols = geom.getCols() == 0 ? 1 : geom.getCols();
+  const uint8_t rows = geom.getRows() == 0 ? 1 : geom.getRows();
+  const float halfW = 0.5f / (float)cols;
+  const float halfH = 0.5f / (float)rows;
+  const float *pr = sim.getRadius();
+  const float reach = maxRadius(sim) * 2.0f;
+  const NeighborGrid *neighbors = states ? neighborsFor(sim, reach) : nullptr;
+  if (!neighbors)
+  {
+    clearToZero(cells, outValues, outCount);
+    return;
+  }
+  float target[MAX_GRID_CELLS];
+  memset(target, 0, sizeof(target));
+
+  for (uint16_t c = 0; c < cells; ++c)
+  {
+    float coverage = 0.0f;
+    float accum = 0.0f;
+    const uint16_t n = gatherCell(*neighbors, grid[c].x, grid[c].y, halfW, halfH, reach);
+    for (uint16_t k = 0; k < n; ++k)
+    {
+      const uint16_t i = near_[k];
+      const float w = cellContribution(px[i], py[i], grid[c].x, grid[c].y, halfW, halfH, radiusOf(pr, i) * 2.0f);
+      if (w <= 0.0f)
+      {
+        continue;
+      }
+      coverage += w;
+      accum += (readParticleState(states, i) + 1) * w;
+    }
+    // State 0 still lights a covered cell, so (state + 1) / (PARTICLE_STATE_MAX + 1).
+    if (coverage > 0.0f)
+    {
+      target[c] = accum / (coverage * (PARTICLE_STATE_MAX + 1)) * fminf(coverage, 1.0f);
+    }
+  }
+
+  smoothAndStore(target, cells, outValues, outCount);
+}
@@ -0,0 +1,19 @@
+#include "InputMailbox.h"
+
+void InputMailbox::publish(const SimInputs &in)
+{
+  slots_[back_] = in;
+  // Release orders the sample before the index becomes visible to the reader.
+  const uint8_t prev = ready_.exchange((uint8_t)(back_ | kFreshBit), std::memory_order_acq_rel);
+  back_ = prev & ~kFreshBit;
+}
+
+const SimInputs &InputMailbox::acquire()
+{
+  if (ready_.load(std::memory_order_relaxed) & kFreshBit)
+  {
+    const uint8_t prev = ready_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & ~kFreshBit;
+  }
+  return slots_[front_];
+}
@@ -1,48 +1,146 @@
 #include <Arduino.h>
 
+#include <atomic>
+
 #include "Acc.h"
 #include "ConfigWeb.h"
-#include "FluidFLIP.h"
 #include "Graphics.h"
 #include "GridGeometry.h"
 #include "GridModes.h"
 #include "ImuForces.h"
+#include "InputMailbox.h"
 #include "Main.h"
 #include "Modulator.h"
 #include "OrganicBehavior.h"
 #include "SimConfig.h"
 #include "SimCore.h"
+#include "SimTask.h"
+#include "SnapshotBuffer.h"
+#include "SubstepScheduler.h"
 #include "TouchForces.h"
-#include "Voronoi.h"
 #include "WifUdp.h"
 #include "FastLED.h"
 
+// SIM_DUAL_CORE=1 steps SimCore in its own task on kSimCore; loop() only renders
+// from the latest published snapshot.
+#ifndef SIM_DUAL_CORE
+#define SIM_DUAL_CORE 0
+#endif
+static constexpr uint8_t kSimCore = 0;
+// Frames caught up per loop() pass; later time is reported as dropped.
+static constexpr uint8_t kMaxFramesPerLoop = 4;
+
 static SimConfig gConfig;
 static SimCore gSimCore(&gConfig);
+static SubstepScheduler gScheduler(&gConfig, 60.0f);
 static TouchForces gTouchForces(&gConfig);
 static GridGeometry gGridGeometry(&gConfig);
 static GridModes gGridModes(&gConfig);
 static ImuForces gImuForces(&gConfig);
 
-static Voronoi gVoronoi(&gConfig);
-static FluidFLIP gFlip(&gConfig);
 static Modulator gModulator;
-static OrganicBehavior gOrganic;
+static OrganicBehavior gOrganic(&gConfig);
+static InputMailbox gInputs;
+
+#if SIM_DUAL_CORE
+static SnapshotBuffer gSnapshot;
+static SimTask gSimTask;
+#endif
 
 static uint8_t gCellValues[MAX_GRID_CELLS];
 
 static bool gValidatedParticles = false;
 static bool gValidatedTouch = false;
 static bool gValidatedBoundary = false;
-static uint32_t gPerfSimFrameCount = 0;
 static uint32_t gPerfRenderFrameCount = 0;
 static uint32_t gPerfWindowStartMs = 0;
 static uint32_t gLastFrameUs = 0;
-static float gAvgFrameMs = 0.0f;
+// Written by the sim frame, read by the perf line in loop(), possibly on the other core.
+static std::atomic<float> gAvgFrameMs{0.0f};
 static uint32_t gLoopLastUs = 0;
-static float gSimAccumMs = 0.0f;
 static uint32_t gLastRenderMs = 0;
 
+static void validatePhase2A(const ParticleView &view)
+{
+  const uint16_t count = view.getCount();
+  const float *x = view.getX();
+  const float *y = view.getY();
+  if (count > 0)
+  {
+    gValidatedParticles = true;
+  }
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    if (x[i] < 0.0f || x[i] > 1.0f || y[i] < 0.0f || y[i] > 1.0f)
+    {
+      gValidatedBoundary = false;
+      return;
+    }
+  }
+  gValidatedBoundary = true;
+  if (getTouching())
+  {
+    gValidatedTouch = true;
+  }
+
+  static uint32_t lastLogMs = 0;
+  if (millis() - lastLogMs > 2500)
+  {
+    lastLogMs = millis();
+    if (IsWebDebugEnabled())
+    {
+      char buf[128];
+      snprintf(buf, sizeof(buf), "[Validate] particles=%u touch=%u boundary=%u",
+               (unsigned)gValidatedParticles,
+               (unsigned)gValidatedTouch,
+               (unsigned)gValidatedBoundary);
+      WebDebugLog(buf);
+    }
+  }
+}
+
+// One fixed-rate simulation frame: inputs, substepped SimCore, advanced blocks.
+// Runs from loop() in single-core mode and from SimTask in dual-core mode; nowSec is sim time.
+static void stepSimulation(float nowSec)
+{
+  const uint32_t stepUs = micros();
+  const float frameMs = (stepUs - gLastFrameUs) / 1000.0f;
+  gLastFrameUs = stepUs;
+  const float avgMs = gAvgFrameMs.load(std::memory_order_relaxed);
+  gAvgFrameMs.store(avgMs <= 0.0f ? frameMs : avgMs * 0.92f + frameMs * 0.08f, std::memory_order_relaxed);
+
+  // Touch and IMU come from the sample loop() last published, never from the drivers directly.
+  const SimInputs &in = gInputs.acquire();
+  gTouchForces.setTouchPixels(in.touchX, in.touchY, in.touching);
+  gTouchForces.apply(gSimCore);
+
+  // IMU gravity is opt-in; UI gravity remains authoritative until IMU mode is enabled.
+  if (gConfig.imuEnabled)
+  {
+    gImuForces.setAccel(in.accelX, in.accelY, in.accelZ);
+    gImuForces.apply();
+  }
+
+  // Core simulation frame, split into CFL-bounded substeps
+  gScheduler.runFrame(gSimCore);
+
+  // Optional advanced blocks in Phase2 scaffold
+  (void)gModulator.sample(nowSec);
+  gOrganic.apply(gSimCore, gConfig.timeStep);
+
+#if !SIM_DUAL_CORE
+  validatePhase2A(gSimCore.getView());
+#endif
+}
+
+// Touch and IMU state as of now, taken on the core whose drivers update it.
+static void publishInputs()
+{
+  const AccelData a = GetAccelData();
+  const SimInputs in = {getTouchX(), getTouchY(), getTouching(), a.x, a.y, a.z};
+  gInputs.publish(in);
+}
+
 void setup()
 {
   Serial.begin(250000);
@@ -63,11 +161,26 @@ void setup()
   SetupAcc();
   gGridGeometry.rebuild();
   gSimCore.init();
+  if (!gGridModes.begin(gSimCore.getCapacity()))
+  {
+    Serial.println("[Phase2] GridModes storage failed");
+  }
+  if (!gOrganic.begin(gSimCore.getCapacity()))
+  {
+    Serial.println("[Phase2] OrganicBehavior storage failed");
+  }
   memset(gCellValues, 0, sizeof(gCellValues));
+  publishInputs();
+#if SIM_DUAL_CORE
+  if (!gSnapshot.begin(gSimCore.getCapacity()) ||
+      !gSimTask.start(&gSimCore, &gSnapshot, &gScheduler, stepSimulation, kSimCore))
+  {
+    Serial.println("[Phase2] Dual-core start failed");
+  }
+#endif
   gPerfWindowStartMs = millis();
   gLastFrameUs = micros();
   gLoopLastUs = micros();
-  gSimAccumMs = 0.0f;
   gLastRenderMs = millis();
 }
 
@@ -81,49 +194,11 @@ void ProcessIncomingData()
   }
 }
 
-static void validatePhase2A()
-{
-  const uint16_t count = gSimCore.getCount();
-  const float *x = gSimCore.getX();
-  const float *y = gSimCore.getY();
-  if (count > 0)
-  {
-    gValidatedParticles = true;
-  }
-  for (uint16_t i = 0; i < count; ++i)
-  {
-    if (x[i] < 0.0f || x[i] > 1.0f || y[i] < 0.0f || y[i] > 1.0f)
-    {
-      gValidatedBoundary = false;
-      return;
-    }
-  }
-  gValidatedBoundary = true;
-  if (getTouching())
-  {
-    gValidatedTouch = true;
-  }
-
-  static uint32_t lastLogMs = 0;
-  if (millis() - lastLogMs > 2500)
-  {
-    lastLogMs = millis();
-    if (IsWebDebugEnabled())
-    {
-      char buf[128];
-      snprintf(buf, sizeof(buf), "[Validate] particles=%u touch=%u boundary=%u",
-               (unsigned)gValidatedParticles,
-               (unsigned)gValidatedTouch,
-               (unsigned)gValidatedBoundary);
-      WebDebugLog(buf);
-    }
-  }
-}
-
 void loop()
 {
   LoopAcc();
   UiLoop();
+  publishInputs();
   LoopConfigWeb();
   ProcessIncomingData();
   if (ConsumeConfigGridDirtyFlag())
@@ -133,7 +208,11 @@ void loop()
   if (ConsumeConfigRestartFlag())
   {
     gGridGeometry.rebuild();
+#if SIM_DUAL_CORE
+    gSimTask.requestRestart();
+#else
     gSimCore.init();
+#endif
     memset(gCellValues, 0, sizeof(gCellValues));
     Serial.println("[Phase2] Restart requested from ConfigWeb");
     if (IsWebDebugEnabled())
@@ -142,69 +221,28 @@ void loop()
     }
   }
 
+#if !SIM_DUAL_CORE
   const uint32_t nowUs = micros();
-  float loopDeltaMs = (nowUs - gLoopLastUs) / 1000.0f;
+  const uint8_t framesDue = gScheduler.advance((nowUs - gLoopLastUs) / 1000.0f, kMaxFramesPerLoop);
   gLoopLastUs = nowUs;
-  if (loopDeltaMs < 0.0f)
+  for (uint8_t f = 0; f < framesDue; ++f)
   {
-    loopDeltaMs = 0.0f;
-  }
-  if (loopDeltaMs > 100.0f)
-  {
-    loopDeltaMs = 100.0f;
-  }
-  gSimAccumMs += loopDeltaMs;
-
-  const float simStepMs = 1000.0f / 60.0f;
-  uint8_t simStepsThisLoop = 0;
-  while (gSimAccumMs >= simStepMs && simStepsThisLoop < 4)
-  {
-    const uint32_t stepUs = micros();
-    const float frameMs = (stepUs - gLastFrameUs) / 1000.0f;
-    gLastFrameUs = stepUs;
-    if (gPerfSimFrameCount == 0)
-    {
-      gAvgFrameMs = frameMs;
-    }
-    else
-    {
-      gAvgFrameMs = gAvgFrameMs * 0.92f + frameMs * 0.08f;
-    }
-    ++gPerfSimFrameCount;
-
-    // Touch -> force mapping
-    gTouchForces.setTouchPixels(getTouchX(), getTouchY(), getTouching());
-    gTouchForces.apply(gSimCore);
-
-    // IMU gravity is opt-in; UI gravity remains authoritative until IMU mode is enabled.
-    if (gConfig.imuEnabled)
-    {
-      const AccelData a = GetAccelData();
-      gImuForces.setAccel(a.x, a.y, a.z);
-      gImuForces.apply();
-    }
-
-    // Core simulation step
-    const float nowSec = millis() * 0.001f;
-    gSimCore.step(gConfig.timeStep, nowSec);
-
-    // Optional advanced blocks in Phase2 scaffold
-    (void)gModulator.sample(nowSec);
-    gVoronoi.step(gConfig.timeStep);
-    gFlip.step(gConfig.timeStep);
-    gOrganic.applySwarm(gSimCore, gConfig.timeStep);
-
-    validatePhase2A();
-    gSimAccumMs -= simStepMs;
-    ++simStepsThisLoop;
+    stepSimulation(gScheduler.getSimTimeSec());
   }
+#endif
 
   // Render decoupled from sim; run independently at target cadence.
   const uint32_t nowMs = millis();
   if (nowMs - gLastRenderMs >= (1000 / 60))
   {
     gLastRenderMs = nowMs;
-    gGridModes.compute(gSimCore, gGridGeometry, gCellValues, MAX_GRID_CELLS);
+#if SIM_DUAL_CORE
+    const ParticleView view = gSnapshot.acquire();
+    validatePhase2A(view);
+#else
+    const ParticleView view = gSimCore.getView();
+#endif
+    gGridModes.compute(view, gGridGeometry, gCellValues, MAX_GRID_CELLS);
     renderGrid(gCellValues, gGridGeometry.getCellCount(), gGridGeometry.getCols(), gGridGeometry.getRows(), gConfig.gridGap, gConfig.theme);
     ++gPerfRenderFrameCount;
   }
@@ -212,21 +250,35 @@ void loop()
   if (nowMs - gPerfWindowStartMs >= 1000)
   {
     const float seconds = (nowMs - gPerfWindowStartMs) / 1000.0f;
-    const float simFps = seconds > 0.0f ? (gPerfSimFrameCount / seconds) : 0.0f;
+#if SIM_DUAL_CORE
+    const SchedulerStats sched = gSimTask.consumeStats();
+#else
+    const SchedulerStats sched = gScheduler.consumeStats();
+#endif
+    const float simFps = seconds > 0.0f ? (sched.frames / seconds) : 0.0f;
     const float renderFps = seconds > 0.0f ? (gPerfRenderFrameCount / seconds) : 0.0f;
-    Serial.printf("[Phase2 FPS] sim %.1f | render %.1f | avg frame %.2f ms | cells=%u\n",
-                  simFps, renderFps, gAvgFrameMs, (unsigned)gGridGeometry.getCellCount());
+    const float avgSubsteps = sched.frames > 0 ? (float)sched.substeps / sched.frames : 0.0f;
+    Serial.printf("[Phase2 FPS] sim %.1f | render %.1f | avg frame %.2f ms | cells=%u | substeps %.2f (last %u) | dropped %.1f ms\n",
+                  simFps, renderFps, gAvgFrameMs.load(std::memory_order_relaxed), (unsigned)gGridGeometry.getCellCount(),
+                  avgSubsteps, (unsigned)sched.lastSubsteps, sched.droppedMs);
+    const CollisionStats coll = gSimCore.consumeCollisionStats();
+    if (coll.steps > 0)
+    {
+      Serial.printf("[Phase2 Collision] grid %ux%u | rebuild %.0f%% | pairs %lu | contacts %lu per step | passes %.2f | overflow %lu\n",
+                    (unsigned)coll.gridSize, (unsigned)coll.gridSize, 100.0f * coll.rebuilds / coll.steps,
+                    (unsigned long)(coll.pairsTested / coll.steps), (unsigned long)(coll.contacts / coll.steps),
+                    (float)coll.passes / coll.steps, (unsigned long)coll.overflows);
+    }
     
     if (IsWebDebugEnabled())
     {
       char buf[128];
-      snprintf(buf, sizeof(buf), "[FPS] sim %.1f | render %.1f | frame %.2f ms | cells=%u",
-               simFps, renderFps, gAvgFrameMs, (unsigned)gGridGeometry.getCellCount());
+      snprintf(buf, sizeof(buf), "[FPS] sim %.1f | render %.1f | frame %.2f ms | cells=%u | substeps %.2f | dropped %.1f ms",
+               simFps, renderFps, gAvgFrameMs.load(std::memory_order_relaxed), (unsigned)gGridGeometry.getCellCount(), avgSubsteps, sched.droppedMs);
       WebDebugLog(buf);
     }
     
     gPerfWindowStartMs = nowMs;
-    gPerfSimFrameCount = 0;
     gPerfRenderFrameCount = 0;
   }
 }
@@ -0,0 +1,192 @@
+#include "NeighborGrid.h"
+
+#include <math.h>
+#include <string.h>
+
+static inline size_t alignedBytes(size_t bytes)
+{
+  return (bytes + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+size_t NeighborGrid::storageBytes(uint16_t capacity)
+{
+  return 2 * alignedBytes((size_t)capacity * sizeof(uint16_t)) +
+         alignedBytes((MAX_NEIGHBOR_CELLS + 1) * sizeof(uint16_t));
+}
+
+bool NeighborGrid::begin(ParticleArena &arena, ArenaRegion region, uint16_t capacity)
+{
+  cellOf_ = (uint16_t *)arena.alloc(region, alignedBytes((size_t)capacity * sizeof(uint16_t)));
+  order_ = (uint16_t *)arena.alloc(region, alignedBytes((size_t)capacity * sizeof(uint16_t)));
+  cellStart_ = (uint16_t *)arena.alloc(region, alignedBytes((MAX_NEIGHBOR_CELLS + 1) * sizeof(uint16_t)));
+  if (!cellOf_ || !order_ || !cellStart_)
+  {
+    cellOf_ = nullptr;
+    order_ = nullptr;
+    cellStart_ = nullptr;
+    capacity_ = 0;
+    return false;
+  }
+  capacity_ = capacity;
+  valid_ = false;
+  return true;
+}
+
+uint8_t NeighborGrid::fitCutoff(float cutoff)
+{
+  if (cutoff <= 1.0f / MAX_NEIGHBOR_GRID)
+  {
+    return MAX_NEIGHBOR_GRID;
+  }
+  return cutoff >= 1.0f ? 1 : (uint8_t)(1.0f / cutoff);
+}
+
+uint8_t NeighborGrid::fitGridSize(float cutoff, uint16_t count)
+{
+  const uint8_t fit = fitCutoff(cutoff);
+  // About two cells per particle; a finer grid only adds empty cells to sweep.
+  const uint8_t target = (uint8_t)fminf(ceilf(sqrtf(2.0f * count)), (float)MAX_NEIGHBOR_GRID);
+  const uint8_t size = target < fit ? target : fit;
+  return size < 1 ? 1 : size;
+}
+
+void NeighborGrid::build(const float *x, const float *y, uint16_t count, uint8_t gridSize)
+{
+  if (!order_)
+  {
+    return;
+  }
+  if (count > capacity_)
+  {
+    count = capacity_;
+  }
+  gridSize = gridSize < 1 ? 1 : (gridSize > MAX_NEIGHBOR_GRID ? MAX_NEIGHBOR_GRID : gridSize);
+  x_ = x;
+  y_ = y;
+  count_ = count;
+  gridSize_ = gridSize;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    cellOf_[i] = (uint16_t)(cellCoord(y[i]) * gridSize + cellCoord(x[i]));
+  }
+  sortByCell(cellOf_, count, (uint16_t)(gridSize * gridSize), cellStart_, order_);
+  valid_ = true;
+  ++builds_;
+}
+
+void NeighborGrid::sortByCell(const uint16_t *cellOf, uint16_t count, uint16_t cellCount, uint16_t *cellStart,
+                              uint16_t *order)
+{
+  memset(cellStart, 0, (cellCount + 1) * sizeof(uint16_t));
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    ++cellStart[cellOf[i]];
+  }
+  // Inclusive prefix sums give cell ends; the backwards scatter walks them down to cell starts
+  // and keeps ascending particle order inside each cell.
+  for (uint16_t c = 1; c < cellCount; ++c)
+  {
+    cellStart[c] += cellStart[c - 1];
+  }
+  for (uint16_t i = count; i-- > 0;)
+  {
+    order[--cellStart[cellOf[i]]] = i;
+  }
+  cellStart[cellCount] = count;
+}
+
+// Collects query hits into a bounded buffer, counting the ones that did not fit.
+struct CollectVisitor
+{
+  uint16_t *out;
+  uint16_t maxOut;
+  uint16_t found;
+
+  void operator()(uint16_t j, float, float, float)
+  {
+    if (found < maxOut)
+    {
+      out[found] = j;
+    }
+    ++found;
+  }
+};
+
+uint16_t NeighborGrid::queryRadius(float px, float py, float radius, uint16_t *out, uint16_t maxOut) const
+{
+  CollectVisitor collect = {out, maxOut, 0};
+  forEachNear(px, py, radius, collect);
+  return collect.found;
+}
+
+uint8_t NeighborGrid::queryNearest(float px, float py, float radius, uint16_t self, uint8_t k, uint16_t *out, float *outD2) const
+{
+  if (!valid_ || k == 0)
+  {
+    return 0;
+  }
+  const float h = 1.0f / gridSize_;
+  const float radiusSq = radius * radius;
+  const int cx = cellCoord(px);
+  const int cy = cellCoord(py);
+  // Ring r (the cells r steps from (cx, cy)) is at least (r - 1) * h + edge away from the query.
+  const float fx = px - cx * h;
+  const float fy = py - cy * h;
+  float edge = fminf(fminf(fx, h - fx), fminf(fy, h - fy));
+  edge = edge < 0.0f ? 0.0f : edge;
+  const int reach = (int)(radius * gridSize_) + 1;
+  const int last = gridSize_ - 1;
+
+  uint8_t found = 0;
+  for (int r = 0; r <= reach; ++r)
+  {
+    if (r > 0)
+    {
+      const float ringMin = (r - 1) * h + edge;
+      const float ringMinSq = ringMin * ringMin;
+      if (ringMinSq >= radiusSq || (found == k && ringMinSq >= outD2[k - 1]))
+      {
+        break;
+      }
+    }
+    const int y0 = cy - r < 0 ? 0 : cy - r;
+    const int y1 = cy + r > last ? last : cy + r;
+    for (int y = y0; y <= y1; ++y)
+    {
+      // Top and bottom rows of the ring are full; the rows between only add their two ends.
+      const bool fullRow = y == cy - r || y == cy + r;
+      const int step = fullRow ? 1 : 2 * r;
+      for (int x = cx - r; x <= cx + r; x += step)
+      {
+        if (x < 0 || x > last)
+        {
+          continue;
+        }
+        const uint16_t c = (uint16_t)(y * gridSize_ + x);
+        const uint16_t end = cellStart_[c + 1];
+        for (uint16_t b = cellStart_[c]; b < end; ++b)
+        {
+          const uint16_t j = order_[b];
+          const float dx = x_[j] - px;
+          const float dy = y_[j] - py;
+          const float d2 = dx * dx + dy * dy;
+          if (j == self || d2 >= radiusSq || (found == k && d2 >= outD2[k - 1]))
+          {
+            continue;
+          }
+          // Insertion into the sorted list; a full list drops its farthest entry.
+          uint8_t slot = found < k ? found++ : (uint8_t)(k - 1);
+          while (slot > 0 && outD2[slot - 1] > d2)
+          {
+            out[slot] = out[slot - 1];
+            outD2[slot] = outD2[slot - 1];
+            --slot;
+          }
+          out[slot] = j;
+          outD2[slot] = d2;
+        }
+      }
+    }
+  }
+  return found;
+}
@@ -0,0 +1,194 @@
+#include "Noise.h"
+
+#include "SimdF4.h"
+
+// Skew / unskew factors of the 3D simplex grid.
+static constexpr float kF3 = 1.0f / 3.0f;
+static constexpr float kG3 = 1.0f / 6.0f;
+// Scales the summed corner contributions to about [-1, 1].
+static constexpr float kNorm = 32.0f;
+// Hash bits that pick a corner's gradient: g = (h >> 4) & 15.
+static constexpr uint32_t kGradBit0 = 1u << 4;
+static constexpr uint32_t kGradBit1 = 1u << 5;
+static constexpr uint32_t kGradBit2 = 1u << 6;
+static constexpr uint32_t kGradBit3 = 1u << 7;
+
+static inline int32_t fastFloor(float v)
+{
+  const int32_t i = (int32_t)v;
+  return v < (float)i ? i - 1 : i;
+}
+
+static inline uint32_t hash3(int32_t i, int32_t j, int32_t k, uint32_t seed)
+{
+  uint32_t h = seed ^ ((uint32_t)i * 0x8da6b343u) ^ ((uint32_t)j * 0xd8163841u) ^ ((uint32_t)k * 0xcb1ab31fu);
+  h ^= h >> 15;
+  h *= 0x2c1b3c6du;
+  h ^= h >> 12;
+  return h;
+}
+
+// Gradient from the hash bits (Perlin's improved-noise selection), g = (h >> 4) & 15: g < 8
+// takes x as the first axis, else y; g < 4 pairs it with y, 12 and 14 with x, the rest with z;
+// bits 0 and 1 flip the two signs. Covers the 12 cube-edge directions, four of them twice. The
+// scalar path reads the choice from these tables, the four-lane one rebuilds it with masks.
+static const uint8_t kGradU[16] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1};
+static const uint8_t kGradV[16] = {1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 2, 0, 2};
+static const float kGradSignU[16] = {1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1, 1, -1};
+static const float kGradSignV[16] = {1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1, 1, 1, -1, -1};
+
+static inline float corner(float x, float y, float z, uint32_t h)
+{
+  const float t = 0.6f - x * x - y * y - z * z;
+  const uint32_t g = (h >> 4) & 15;
+  const float axis[3] = {x, y, z};
+  const float dot = axis[kGradU[g]] * kGradSignU[g] + axis[kGradV[g]] * kGradSignV[g];
+  const float t2 = t * t;
+  return t > 0.0f ? t2 * t2 * dot : 0.0f;
+}
+
+static inline float simplexCore(float x, float y, float z, uint32_t seed)
+{
+  const float s = (x + y + z) * kF3;
+  const int32_t i = fastFloor(x + s);
+  const int32_t j = fastFloor(y + s);
+  const int32_t k = fastFloor(z + s);
+  const float t = (float)(i + j + k) * kG3;
+  const float x0 = x - ((float)i - t);
+  const float y0 = y - ((float)j - t);
+  const float z0 = z - ((float)k - t);
+
+  // Second and third corners of the simplex, from the rank order of x0, y0, z0.
+  const int32_t xy = x0 >= y0;
+  const int32_t yz = y0 >= z0;
+  const int32_t xz = x0 >= z0;
+  const int32_t i1 = xy & xz;
+  const int32_t j1 = (1 - xy) & yz;
+  const int32_t k1 = (1 - xz) & (1 - yz);
+  const int32_t i2 = xy | xz;
+  const int32_t j2 = (1 - xy) | yz;
+  const int32_t k2 = (1 - xz) | (1 - yz);
+
+  const float x1 = x0 - i1 + kG3;
+  const float y1 = y0 - j1 + kG3;
+  const float z1 = z0 - k1 + kG3;
+  const float x2 = x0 - i2 + 2.0f * kG3;
+  const float y2 = y0 - j2 + 2.0f * kG3;
+  const float z2 = z0 - k2 + 2.0f * kG3;
+  const float x3 = x0 - 1.0f + 3.0f * kG3;
+  const float y3 = y0 - 1.0f + 3.0f * kG3;
+  const float z3 = z0 - 1.0f + 3.0f * kG3;
+
+  const float n = corner(x0, y0, z0, hash3(i, j, k, seed)) +
+                  corner(x1, y1, z1, hash3(i + i1, j + j1, k + k1, seed)) +
+                  corner(x2, y2, z2, hash3(i + i2, j + j2, k + k2, seed)) +
+                  corner(x3, y3, z3, hash3(i + 1, j + 1, k + 1, seed));
+  const float v = kNorm * n;
+  return v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// Four-lane versions of the above, operation for operation, so each lane rounds exactly as the
+// scalar path does. Comparisons become masks and branches become selects.
+using Simd::F4;
+using Simd::I4;
+using Simd::M4;
+
+static inline F4 floor4(F4 v)
+{
+  const F4 truncated = Simd::toFloat(Simd::toInt(v));
+  return Simd::select(Simd::lt(v, truncated), Simd::sub(truncated, Simd::set1(1.0f)), truncated);
+}
+
+static inline I4 hash3(F4 i, F4 j, F4 k, uint32_t seed)
+{
+  I4 h = Simd::xori(Simd::xori(Simd::set1i(seed), Simd::muli(Simd::toInt(i), Simd::set1i(0x8da6b343u))),
+                    Simd::xori(Simd::muli(Simd::toInt(j), Simd::set1i(0xd8163841u)),
+                               Simd::muli(Simd::toInt(k), Simd::set1i(0xcb1ab31fu))));
+  h = Simd::xori(h, Simd::shri<15>(h));
+  h = Simd::muli(h, Simd::set1i(0x2c1b3c6du));
+  return Simd::xori(h, Simd::shri<12>(h));
+}
+
+static inline F4 corner(F4 x, F4 y, F4 z, I4 h)
+{
+  const F4 zero = Simd::set1(0.0f);
+  const F4 one = Simd::set1(1.0f);
+  const F4 minusOne = Simd::set1(-1.0f);
+  const F4 t = Simd::sub(Simd::sub(Simd::sub(Simd::set1(0.6f), Simd::mul(x, x)), Simd::mul(y, y)), Simd::mul(z, z));
+  const M4 bit0 = Simd::testBits(h, kGradBit0);
+  const M4 bit3 = Simd::testBits(h, kGradBit3);
+  const F4 u = Simd::select(bit3, y, x);
+  const F4 pairXz = Simd::select(bit0, z, Simd::select(Simd::andMask(bit3, Simd::testBits(h, kGradBit2)), x, z));
+  const F4 v = Simd::select(Simd::testBits(h, kGradBit3 | kGradBit2), pairXz, y);
+  const F4 dot = Simd::add(Simd::mul(u, Simd::select(bit0, minusOne, one)),
+                           Simd::mul(v, Simd::select(Simd::testBits(h, kGradBit1), minusOne, one)));
+  const F4 t2 = Simd::mul(t, t);
+  return Simd::select(Simd::gt(t, zero), Simd::mul(Simd::mul(t2, t2), dot), zero);
+}
+
+static inline F4 simplexCore(F4 x, F4 y, F4 z, uint32_t seed)
+{
+  const F4 zero = Simd::set1(0.0f);
+  const F4 one = Simd::set1(1.0f);
+  const F4 g3 = Simd::set1(kG3);
+  const F4 s = Simd::mul(Simd::add(Simd::add(x, y), z), Simd::set1(kF3));
+  const F4 i = floor4(Simd::add(x, s));
+  const F4 j = floor4(Simd::add(y, s));
+  const F4 k = floor4(Simd::add(z, s));
+  const F4 t = Simd::mul(Simd::add(Simd::add(i, j), k), g3);
+  const F4 x0 = Simd::sub(x, Simd::sub(i, t));
+  const F4 y0 = Simd::sub(y, Simd::sub(j, t));
+  const F4 z0 = Simd::sub(z, Simd::sub(k, t));
+
+  // The scalar rank flags inverted: yx is !(x0 >= y0) and so on.
+  const M4 yx = Simd::lt(x0, y0);
+  const M4 zy = Simd::lt(y0, z0);
+  const M4 zx = Simd::lt(x0, z0);
+  const F4 i1 = Simd::select(Simd::orMask(yx, zx), zero, one);
+  const F4 j1 = Simd::select(zy, zero, Simd::select(yx, one, zero));
+  const F4 k1 = Simd::select(Simd::andMask(zx, zy), one, zero);
+  const F4 i2 = Simd::select(Simd::andMask(yx, zx), zero, one);
+  const F4 j2 = Simd::select(zy, Simd::select(yx, one, zero), one);
+  const F4 k2 = Simd::select(Simd::orMask(zx, zy), one, zero);
+
+  const F4 g3x2 = Simd::set1(2.0f * kG3);
+  const F4 g3x3 = Simd::set1(3.0f * kG3);
+  const F4 x1 = Simd::add(Simd::sub(x0, i1), g3);
+  const F4 y1 = Simd::add(Simd::sub(y0, j1), g3);
+  const F4 z1 = Simd::add(Simd::sub(z0, k1), g3);
+  const F4 x2 = Simd::add(Simd::sub(x0, i2), g3x2);
+  const F4 y2 = Simd::add(Simd::sub(y0, j2), g3x2);
+  const F4 z2 = Simd::add(Simd::sub(z0, k2), g3x2);
+  const F4 x3 = Simd::add(Simd::sub(x0, one), g3x3);
+  const F4 y3 = Simd::add(Simd::sub(y0, one), g3x3);
+  const F4 z3 = Simd::add(Simd::sub(z0, one), g3x3);
+
+  F4 n = corner(x0, y0, z0, hash3(i, j, k, seed));
+  n = Simd::add(n, corner(x1, y1, z1, hash3(Simd::add(i, i1), Simd::add(j, j1), Simd::add(k, k1), seed)));
+  n = Simd::add(n, corner(x2, y2, z2, hash3(Simd::add(i, i2), Simd::add(j, j2), Simd::add(k, k2), seed)));
+  n = Simd::add(n, corner(x3, y3, z3, hash3(Simd::add(i, one), Simd::add(j, one), Simd::add(k, one), seed)));
+  const F4 v = Simd::mul(Simd::set1(kNorm), n);
+  return Simd::max(Simd::set1(-1.0f), Simd::min(v, one));
+}
+
+namespace Noise
+{
+float simplex3(float x, float y, float z, uint32_t seed)
+{
+  return simplexCore(x, y, z, seed);
+}
+
+void simplex3(const float *x, const float *y, float z, float *out, uint16_t count, uint32_t seed)
+{
+  const F4 zv = Simd::set1(z);
+  uint16_t i = 0;
+  for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH)
+  {
+    Simd::storeu(out + i, simplexCore(Simd::loadu(x + i), Simd::loadu(y + i), zv, seed));
+  }
+  for (; i < count; ++i)
+  {
+    out[i] = simplexCore(x[i], y[i], z, seed);
+  }
+}
+}
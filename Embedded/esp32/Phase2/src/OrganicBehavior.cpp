@@ -1,19 +1,498 @@
 #include "OrganicBehavior.h"
 
+#include <math.h>
+#include <string.h>
+
+// The JS works on its 240 px canvas; the swarm separation falloff 1 / (dist + 1) and the chain
+// springs depend on it.
+static constexpr float kJsPixels = 240.0f;
+// organicForces.js: per-term weight scale and the damping applied after the clamp.
+static constexpr float kSwarmWeight = 0.05f;
+static constexpr float kForceDamping = 0.85f;
+// calculateChainForces: spring and straightening gains, forceScales.Chain.base and the clamp.
+static constexpr float kChainGain = 2.0f;
+static constexpr float kChainBase = 1.5f;
+static constexpr float kChainMaxForce = 2.0f;
+// Nearest neighbours a particle links to per frame, as the JS's indexOf(neighbor) < 2.
+static constexpr uint8_t kChainCandidates = 2;
+// calculateAutomataForces: per-component clamp and forceScales.Automata.base.
+static constexpr float kAutomataMaxForce = 0.5f;
+static constexpr float kAutomataBase = 0.1f;
+// updateStates: fraction of the gap to the neighbours' mean a state moves per frame.
+static constexpr float kAutomataRate = 0.1f;
+// Tally layout: neighbour count below the shift, state sum above (15 * 16383 fits in 18 bits).
+static constexpr uint8_t kTallyShift = 14;
+static constexpr uint32_t kTallyCountMask = (1u << kTallyShift) - 1;
+
+static inline size_t alignedBytes(size_t bytes)
+{
+  return (bytes + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+// Scales (x, y) to unit length; leaves a zero vector alone.
+static inline void normalize(float &x, float &y)
+{
+  const float len = sqrtf(x * x + y * y);
+  if (len > 0.0f)
+  {
+    x /= len;
+    y /= len;
+  }
+}
+
+bool OrganicBehavior::begin(uint16_t capacity)
+{
+  if (arena_.isReady())
+  {
+    return true;
+  }
+  // Forces are written and read by every particle each frame, so internal DRAM; links are
+  // mostly idle slots and go to the bulk region.
+  const size_t floatBytes = alignedBytes((size_t)capacity * sizeof(float));
+  const size_t linkBytes = alignedBytes((size_t)capacity * CHAIN_MAX_LINKS * sizeof(uint16_t));
+  const size_t countBytes = alignedBytes(capacity);
+  // Automata states and tallies are likewise touched per particle and per pair every frame.
+  const size_t stateBytes = alignedBytes((size_t)particleStateWords(capacity) * sizeof(uint32_t));
+  const size_t tallyBytes = alignedBytes((size_t)capacity * sizeof(uint32_t));
+  if (!arena_.begin(2 * floatBytes + 2 * stateBytes + tallyBytes, linkBytes + countBytes))
+  {
+    return false;
+  }
+  forceX_ = (float *)arena_.alloc(ARENA_HOT, floatBytes);
+  forceY_ = (float *)arena_.alloc(ARENA_HOT, floatBytes);
+  states_[0] = (uint32_t *)arena_.alloc(ARENA_HOT, stateBytes);
+  states_[1] = (uint32_t *)arena_.alloc(ARENA_HOT, stateBytes);
+  tally_ = (uint32_t *)arena_.alloc(ARENA_HOT, tallyBytes);
+  links_ = (uint16_t *)arena_.alloc(ARENA_BULK, linkBytes);
+  linkCount_ = (uint8_t *)arena_.alloc(ARENA_BULK, countBytes);
+  capacity_ = capacity;
+  clearLinks();
+  memset(states_[0], 0, stateBytes);
+  memset(states_[1], 0, stateBytes);
+  return true;
+}
+
+void OrganicBehavior::apply(SimCore &sim, float dt)
+{
+  const uint8_t mode = config_->organicBehavior;
+  if (mode == ORGANIC_CHAIN && lastMode_ != ORGANIC_CHAIN)
+  {
+    // Chains start over whenever the behavior is switched to, as in the JS.
+    clearLinks();
+  }
+  if (mode == ORGANIC_AUTOMATA && lastMode_ != ORGANIC_AUTOMATA)
+  {
+    // Fresh random states on every switch, as initializeStates() in the JS.
+    seededCount_ = 0;
+  }
+  else if (mode != ORGANIC_AUTOMATA && lastMode_ == ORGANIC_AUTOMATA)
+  {
+    sim.setParticleStates(nullptr);
+  }
+  lastMode_ = mode;
+  switch (mode)
+  {
+  case ORGANIC_SWARM:
+    applySwarm(sim, dt);
+    break;
+  case ORGANIC_CHAIN:
+    applyChain(sim, dt);
+    break;
+  case ORGANIC_AUTOMATA:
+    applyAutomata(sim, dt);
+    break;
+  default:
+    break;
+  }
+}
+
 void OrganicBehavior::applySwarm(SimCore &sim, float dt)
 {
-  (void)sim;
-  (void)dt;
+  const uint16_t count = sim.getCount();
+  if (!forceX_ || count > capacity_ || count < 2)
+  {
+    return;
+  }
+  const NeighborGrid &grid = sim.getNeighbors();
+  const float *x = sim.getX();
+  const float *y = sim.getY();
+  const float *vx = sim.getVx();
+  const float *vy = sim.getVy();
+  const float radius = config_->organicRadius;
+  const uint8_t k = config_->swarmNeighbors < 1 ? 1 : (config_->swarmNeighbors > SWARM_MAX_NEIGHBORS ? SWARM_MAX_NEIGHBORS : config_->swarmNeighbors);
+  const float cohesion = config_->swarmCohesion * kSwarmWeight;
+  const float alignment = config_->swarmAlignment * kSwarmWeight;
+  const float separation = config_->swarmSeparation * kSwarmWeight;
+  const float maxForce = config_->swarmMaxSpeed;
+
+  uint16_t near[SWARM_MAX_NEIGHBORS];
+  float nearD2[SWARM_MAX_NEIGHBORS];
+  uint32_t used = 0;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const float xi = x[i];
+    const float yi = y[i];
+    const uint8_t n = grid.queryNearest(xi, yi, radius, i, k, near, nearD2);
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float headingX = 0.0f;
+    float headingY = 0.0f;
+    float sepX = 0.0f;
+    float sepY = 0.0f;
+    uint8_t m = 0;
+    for (uint8_t a = 0; a < n; ++a)
+    {
+      if (nearD2[a] <= 0.0f)
+      {
+        continue;
+      }
+      const uint16_t j = near[a];
+      const float dist = sqrtf(nearD2[a]);
+      const float push = 1.0f / ((dist * kJsPixels + 1.0f) * dist);
+      sepX -= (x[j] - xi) * push;
+      sepY -= (y[j] - yi) * push;
+      centerX += x[j];
+      centerY += y[j];
+      headingX += vx[j];
+      headingY += vy[j];
+      ++m;
+    }
+    if (m == 0)
+    {
+      forceX_[i] = 0.0f;
+      forceY_[i] = 0.0f;
+      continue;
+    }
+    used += m;
+    // Directions only, so the mean heading needs no division by m.
+    centerX = centerX / m - xi;
+    centerY = centerY / m - yi;
+    normalize(centerX, centerY);
+    normalize(headingX, headingY);
+    normalize(sepX, sepY);
+
+    float fx = centerX * cohesion + headingX * alignment + sepX * separation;
+    float fy = centerY * cohesion + headingY * alignment + sepY * separation;
+    const float mag = sqrtf(fx * fx + fy * fy);
+    const float scale = (mag > maxForce ? maxForce / mag : 1.0f) * kForceDamping;
+    forceX_[i] = fx * scale;
+    forceY_[i] = fy * scale;
+  }
+
+  applyForces(sim, count, dt);
+  stats_.neighbors += used;
 }
 
 void OrganicBehavior::applyChain(SimCore &sim, float dt)
 {
-  (void)sim;
-  (void)dt;
+  const uint16_t count = sim.getCount();
+  if (!forceX_ || count > capacity_)
+  {
+    return;
+  }
+  if (count != linkedCount_)
+  {
+    clearLinks();
+    linkedCount_ = count;
+  }
+  const uint8_t branches = config_->chainBranches < 1 ? 1 : (config_->chainBranches > CHAIN_MAX_LINKS ? CHAIN_MAX_LINKS : config_->chainBranches);
+  updateLinks(sim, branches);
+
+  const float *x = sim.getX();
+  const float *y = sim.getY();
+  const float rest = config_->chainLinkDistance * kJsPixels;
+  const float spring = config_->chainLinkStrength * kChainGain;
+  const float straighten = config_->chainAlignment * kChainGain;
+  uint32_t used = 0;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    const uint8_t n = linkCount_[i];
+    const uint16_t *partners = links_ + (size_t)i * CHAIN_MAX_LINKS;
+    float dirX[CHAIN_MAX_LINKS];
+    float dirY[CHAIN_MAX_LINKS];
+    float fx = 0.0f;
+    float fy = 0.0f;
+    for (uint8_t a = 0; a < n; ++a)
+    {
+      // Pixel distances as in the JS, so linkStrength keeps its meaning.
+      const float dx = (x[partners[a]] - x[i]) * kJsPixels;
+      const float dy = (y[partners[a]] - y[i]) * kJsPixels;
+      const float dist = sqrtf(dx * dx + dy * dy);
+      dirX[a] = dist > 0.0f ? dx / dist : 0.0f;
+      dirY[a] = dist > 0.0f ? dy / dist : 0.0f;
+      const float pull = (dist - rest) * spring;
+      fx += dirX[a] * pull;
+      fy += dirY[a] * pull;
+    }
+    if (straighten > 0.0f)
+    {
+      // Two links at an angle: 1 + dot is 0 when they are opposite. The push is along their
+      // sum, toward the line through both partners; the JS rotates it by 90 degrees, which
+      // turns the chain instead of straightening it.
+      for (uint8_t a = 0; a + 1 < n; ++a)
+      {
+        for (uint8_t b = a + 1; b < n; ++b)
+        {
+          const float bend = (1.0f + dirX[a] * dirX[b] + dirY[a] * dirY[b]) * straighten;
+          float sumX = dirX[a] + dirX[b];
+          float sumY = dirY[a] + dirY[b];
+          if (bend > 0.01f)
+          {
+            normalize(sumX, sumY);
+            fx += sumX * bend;
+            fy += sumY * bend;
+          }
+        }
+      }
+    }
+    fx *= kChainBase;
+    fy *= kChainBase;
+    const float mag = sqrtf(fx * fx + fy * fy);
+    const float scale = (mag > kChainMaxForce ? kChainMaxForce / mag : 1.0f) * kForceDamping;
+    forceX_[i] = fx * scale;
+    forceY_[i] = fy * scale;
+    used += n;
+  }
+  applyForces(sim, count, dt);
+  stats_.neighbors += used;
 }
 
+// Accumulates the automata forces and neighbour tallies of every pair within the radius, both
+// ends at once, from the front (old) states.
+struct AutomataPairVisitor
+{
+  const uint32_t *states;
+  uint32_t *tally;
+  float *forceX;
+  float *forceY;
+  float invRadius;
+  // automataThreshold in state levels.
+  float threshold;
+  float attraction;
+  float repulsion;
+  uint32_t pairs;
+
+  void operator()(uint16_t i, uint16_t j, float dx, float dy, float d2)
+  {
+    if (d2 <= 0.0f)
+    {
+      return;
+    }
+    const uint8_t si = readParticleState(states, i);
+    const uint8_t sj = readParticleState(states, j);
+    tally[i] += 1u + ((uint32_t)sj << kTallyShift);
+    tally[j] += 1u + ((uint32_t)si << kTallyShift);
+    const float dist = sqrtf(d2);
+    const float gap = (float)(si > sj ? si - sj : sj - si);
+    const float mag = (gap < threshold ? attraction : -repulsion) * (1.0f - dist * invRadius);
+    const float fx = dx / dist * mag;
+    const float fy = dy / dist * mag;
+    forceX[i] += fx;
+    forceY[i] += fy;
+    forceX[j] -= fx;
+    forceY[j] -= fy;
+    ++pairs;
+  }
+};
+
 void OrganicBehavior::applyAutomata(SimCore &sim, float dt)
 {
-  (void)sim;
-  (void)dt;
+  const uint16_t count = sim.getCount();
+  if (!forceX_ || count > capacity_)
+  {
+    return;
+  }
+  if (count > seededCount_)
+  {
+    seedStates(seededCount_, count);
+  }
+  seededCount_ = count;
+
+  memset(forceX_, 0, (size_t)count * sizeof(float));
+  memset(forceY_, 0, (size_t)count * sizeof(float));
+  memset(tally_, 0, (size_t)count * sizeof(uint32_t));
+  const float radius = config_->organicRadius;
+  AutomataPairVisitor visit = {states_[front_], tally_, forceX_, forceY_, 1.0f / radius,
+                               config_->automataThreshold * PARTICLE_STATE_MAX,
+                               config_->automataAttraction, config_->automataRepulsion, 0};
+  sim.getNeighbors().forEachPair(radius, visit);
+
+  const float scale = kAutomataBase * kForceDamping;
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    forceX_[i] = fmaxf(-kAutomataMaxForce, fminf(kAutomataMaxForce, forceX_[i])) * scale;
+    forceY_[i] = fmaxf(-kAutomataMaxForce, fminf(kAutomataMaxForce, forceY_[i])) * scale;
+  }
+  applyForces(sim, count, dt);
+  updateStates(count);
+  sim.setParticleStates(states_[front_]);
+  stats_.neighbors += 2 * visit.pairs;
+}
+
+void OrganicBehavior::updateStates(uint16_t count)
+{
+  const uint32_t *current = states_[front_];
+  uint32_t *next = states_[front_ ^ 1];
+  const float threshold = config_->automataThreshold * PARTICLE_STATE_MAX;
+  const uint16_t words = particleStateWords(count);
+  for (uint16_t w = 0; w < words; ++w)
+  {
+    uint32_t packed = 0;
+    const uint16_t first = (uint16_t)(w * PARTICLE_STATES_PER_WORD);
+    const uint16_t last = count - first < PARTICLE_STATES_PER_WORD ? count : (uint16_t)(first + PARTICLE_STATES_PER_WORD);
+    for (uint16_t i = first; i < last; ++i)
+    {
+      int state = readParticleState(current, i);
+      const uint32_t neighbors = tally_[i] & kTallyCountMask;
+      if (neighbors > 0)
+      {
+        const float gap = (float)(tally_[i] >> kTallyShift) / neighbors - state;
+        if (fabsf(gap) > threshold)
+        {
+          // A tenth of the gap, rounded, but at least one level so small gaps still close.
+          int step = (int)lroundf(gap * kAutomataRate);
+          step = step != 0 ? step : (gap > 0.0f ? 1 : -1);
+          state += step;
+          state = state < 0 ? 0 : (state > PARTICLE_STATE_MAX ? PARTICLE_STATE_MAX : state);
+        }
+      }
+      packed |= (uint32_t)state << ((i - first) * PARTICLE_STATE_BITS);
+    }
+    next[w] = packed;
+  }
+  front_ ^= 1;
+}
+
+void OrganicBehavior::seedStates(uint16_t from, uint16_t count)
+{
+  uint32_t *words = states_[front_];
+  if (!words || count > capacity_)
+  {
+    return;
+  }
+  for (uint16_t i = from; i < count; ++i)
+  {
+    writeParticleState(words, i, (uint8_t)random(0, PARTICLE_STATE_MAX + 1));
+  }
+}
+
+void OrganicBehavior::updateLinks(SimCore &sim, uint8_t branches)
+{
+  const uint16_t count = sim.getCount();
+  const float *x = sim.getX();
+  const float *y = sim.getY();
+  const float radius = config_->organicRadius;
+  const float radiusSq = radius * radius;
+
+  // Each link is held by both ends; the lower index decides whether it survives. Links past
+  // organicRadius would have left the JS's neighbour list, and a lowered chainBranches trims
+  // the extras.
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    uint16_t *partners = links_ + (size_t)i * CHAIN_MAX_LINKS;
+    for (uint8_t a = 0; a < linkCount_[i];)
+    {
+      const uint16_t j = partners[a];
+      const float dx = x[j] - x[i];
+      const float dy = y[j] - y[i];
+      if (j > i && dx * dx + dy * dy >= radiusSq)
+      {
+        dropLink(i, j);
+        dropLink(j, i);
+        ++stats_.linksBroken;
+        continue;
+      }
+      ++a;
+    }
+    while (linkCount_[i] > branches)
+    {
+      const uint16_t j = partners[linkCount_[i] - 1];
+      dropLink(i, j);
+      dropLink(j, i);
+      ++stats_.linksBroken;
+    }
+  }
+
+  // Particles with a free slot try their nearest neighbours, which need a free slot too.
+  const NeighborGrid &grid = sim.getNeighbors();
+  uint16_t near[kChainCandidates];
+  float nearD2[kChainCandidates];
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    if (linkCount_[i] >= branches)
+    {
+      continue;
+    }
+    const uint8_t n = grid.queryNearest(x[i], y[i], radius, i, kChainCandidates, near, nearD2);
+    for (uint8_t a = 0; a < n && linkCount_[i] < branches; ++a)
+    {
+      const uint16_t j = near[a];
+      if (linkCount_[j] >= branches || isLinked(i, j))
+      {
+        continue;
+      }
+      link(i, j);
+      ++stats_.linksMade;
+    }
+  }
+}
+
+bool OrganicBehavior::isLinked(uint16_t i, uint16_t j) const
+{
+  const uint16_t *partners = links_ + (size_t)i * CHAIN_MAX_LINKS;
+  for (uint8_t a = 0; a < linkCount_[i]; ++a)
+  {
+    if (partners[a] == j)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void OrganicBehavior::link(uint16_t i, uint16_t j)
+{
+  links_[(size_t)i * CHAIN_MAX_LINKS + linkCount_[i]++] = j;
+  links_[(size_t)j * CHAIN_MAX_LINKS + linkCount_[j]++] = i;
+}
+
+void OrganicBehavior::dropLink(uint16_t i, uint16_t j)
+{
+  uint16_t *partners = links_ + (size_t)i * CHAIN_MAX_LINKS;
+  for (uint8_t a = 0; a < linkCount_[i]; ++a)
+  {
+    if (partners[a] == j)
+    {
+      partners[a] = partners[--linkCount_[i]];
+      return;
+    }
+  }
+}
+
+void OrganicBehavior::clearLinks()
+{
+  if (linkCount_)
+  {
+    memset(linkCount_, 0, capacity_);
+  }
+}
+
+void OrganicBehavior::applyForces(SimCore &sim, uint16_t count, float dt)
+{
+  float *vx = sim.mutableVx();
+  float *vy = sim.mutableVy();
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    vx[i] += forceX_[i] * dt;
+    vy[i] += forceY_[i] * dt;
+  }
+  ++stats_.steps;
+  stats_.particles += count;
+}
+
+OrganicStats OrganicBehavior::consumeStats()
+{
+  const OrganicStats out = stats_;
+  stats_ = {};
+  return out;
 }
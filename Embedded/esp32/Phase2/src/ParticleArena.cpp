@@ -0,0 +1,90 @@
+#include "ParticleArena.h"
+
+#include <stdlib.h>
+
+#if !SIM_NATIVE
+#include <esp_heap_caps.h>
+#endif
+
+static size_t alignUp(size_t v)
+{
+  return (v + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+}
+
+static uint8_t *reserveInternal(size_t bytes)
+{
+#if SIM_NATIVE
+  return (uint8_t *)aligned_alloc(ARENA_ALIGN, alignUp(bytes));
+#else
+  return (uint8_t *)heap_caps_aligned_alloc(ARENA_ALIGN, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#endif
+}
+
+static uint8_t *reservePsram(size_t bytes)
+{
+#if SIM_NATIVE
+  (void)bytes;
+  return nullptr;
+#else
+  return (uint8_t *)heap_caps_aligned_alloc(ARENA_ALIGN, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+}
+
+bool ParticleArena::begin(size_t hotBytes, size_t bulkBytes)
+{
+  if (ready_)
+  {
+    return true;
+  }
+
+  hotBytes = alignUp(hotBytes);
+  bulkBytes = alignUp(bulkBytes);
+
+  Region &hot = regions_[ARENA_HOT];
+  hot.base = hotBytes > 0 ? reserveInternal(hotBytes) : nullptr;
+  hot.size = hot.base ? hotBytes : 0;
+  hot.used = 0;
+
+  Region &bulk = regions_[ARENA_BULK];
+  bulk.base = bulkBytes > 0 ? reservePsram(bulkBytes) : nullptr;
+  bulkInPsram_ = bulk.base != nullptr;
+  if (!bulk.base && bulkBytes > 0)
+  {
+    bulk.base = reserveInternal(bulkBytes);
+  }
+  bulk.size = bulk.base ? bulkBytes : 0;
+  bulk.used = 0;
+
+  ready_ = (hotBytes == 0 || hot.base) && (bulkBytes == 0 || bulk.base);
+  return ready_;
+}
+
+void *ParticleArena::alloc(ArenaRegion region, size_t bytes)
+{
+  Region &r = regions_[region];
+  const size_t need = alignUp(bytes);
+  if (!r.base || r.used + need > r.size)
+  {
+    return nullptr;
+  }
+  void *p = r.base + r.used;
+  r.used += need;
+  return p;
+}
+
+size_t ParticleArena::available(ArenaRegion region) const
+{
+  const Region &r = regions_[region];
+  return r.size - r.used;
+}
+
+ArenaBudget ParticleArena::getBudget() const
+{
+  ArenaBudget b;
+  b.hotBytes = regions_[ARENA_HOT].size;
+  b.hotUsed = regions_[ARENA_HOT].used;
+  b.bulkBytes = regions_[ARENA_BULK].size;
+  b.bulkUsed = regions_[ARENA_BULK].used;
+  b.bulkInPsram = bulkInPsram_;
+  return b;
+}
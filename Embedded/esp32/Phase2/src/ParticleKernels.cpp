@@ -0,0 +1,66 @@
+#include "ParticleKernels.h"
+
+#include <math.h>
+
+namespace ParticleKernels
+{
+void integrate(const IntegrateParams &p, float *x, float *y, float *vx, float *vy, uint16_t count)
+{
+  const uint16_t lanes = Simd::paddedCount(count);
+  for (uint16_t i = 0; i < lanes; i += SIMD_WIDTH)
+  {
+    Simd::F4 px = Simd::load(x + i);
+    Simd::F4 py = Simd::load(y + i);
+    Simd::F4 pvx = Simd::load(vx + i);
+    Simd::F4 pvy = Simd::load(vy + i);
+    integrateLanes(p, px, py, pvx, pvy);
+    Simd::store(x + i, px);
+    Simd::store(y + i, py);
+    Simd::store(vx + i, pvx);
+    Simd::store(vy + i, pvy);
+  }
+}
+
+void enforceBoundary(const BoundaryParams &p, float *x, float *y, float *vx, float *vy, uint16_t count)
+{
+  const uint16_t lanes = Simd::paddedCount(count);
+  for (uint16_t i = 0; i < lanes; i += SIMD_WIDTH)
+  {
+    Simd::F4 px = Simd::load(x + i);
+    Simd::F4 py = Simd::load(y + i);
+    Simd::F4 pvx = Simd::load(vx + i);
+    Simd::F4 pvy = Simd::load(vy + i);
+    enforceBoundaryLanes(p, px, py, pvx, pvy);
+    Simd::store(x + i, px);
+    Simd::store(y + i, py);
+    Simd::store(vx + i, pvx);
+    Simd::store(vy + i, pvy);
+  }
+}
+
+void integrateScalar(const IntegrateParams &p, float *x, float *y, float *vx, float *vy, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    vx[i] *= p.damping;
+    vy[i] *= p.damping;
+    const float v2 = vx[i] * vx[i] + vy[i] * vy[i];
+    if (v2 > p.vmax2)
+    {
+      const float inv = p.vmax / sqrtf(v2);
+      vx[i] *= inv;
+      vy[i] *= inv;
+    }
+    x[i] += vx[i] * p.posScale;
+    y[i] += vy[i] * p.posScale;
+  }
+}
+
+void enforceBoundaryScalar(const BoundaryParams &p, float *x, float *y, float *vx, float *vy, uint16_t count)
+{
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    Boundary::enforce(p, x[i], y[i], vx[i], vy[i]);
+  }
+}
+}
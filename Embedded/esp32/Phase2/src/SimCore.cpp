@@ -1,20 +1,104 @@
 #include "SimCore.h"
 
 #include "GravityForces.h"
+#include "ParticleKernels.h"
 
 #include <Arduino.h>
 #include <math.h>
+#include <string.h>
 
-SimCore::SimCore(SimConfig *cfg) : config_(cfg), boundary_(cfg), collision_(cfg), turbulence_(cfg) {}
+// Arena columns are ARENA_ALIGN-sized, which keeps every column padded to whole vectors.
+static_assert(ARENA_ALIGN % (SIMD_WIDTH * sizeof(float)) == 0, "particle columns must pad to SIMD_WIDTH");
+
+SimCore::SimCore(SimConfig *cfg) : config_(cfg), boundary_(cfg), collision_(cfg), turbulence_(cfg), voronoi_(cfg), fluid_(cfg) {}
+
+bool SimCore::allocateStorage()
+{
+  if (arena_.isReady())
+  {
+    return true;
+  }
+
+  uint16_t capacity = config_->particleCapacity;
+  if (capacity < 2)
+  {
+    capacity = 2;
+  }
+  if (capacity > MAX_PARTICLE_CAPACITY)
+  {
+    capacity = MAX_PARTICLE_CAPACITY;
+  }
+
+  // Columns ordered hottest first; they fill internal DRAM until SIM_HOT_ARENA_BYTES runs out.
+  // radius / mass are only touched with turbAffectScale on, so they come last.
+  float **columns[] = {&x_, &y_, &vx_, &vy_, &radius_, &mass_};
+  const uint8_t columnCount = sizeof(columns) / sizeof(columns[0]);
+  const size_t columnBytes = ((size_t)capacity * sizeof(float) + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+  size_t hotColumns = SIM_HOT_ARENA_BYTES / columnBytes;
+  if (hotColumns > columnCount)
+  {
+    hotColumns = columnCount;
+  }
+
+  // The neighbor grid and the collision level index take whatever DRAM the columns leave,
+  // PSRAM otherwise; the Verlet list is streamed sequentially and always goes to bulk.
+  const size_t collisionBytes = NeighborGrid::storageBytes(capacity) + Collision::indexStorageBytes(capacity);
+  const bool collisionHot = hotColumns * columnBytes + collisionBytes <= SIM_HOT_ARENA_BYTES;
+  const size_t hotBytes = hotColumns * columnBytes + (collisionHot ? collisionBytes : 0);
+  const size_t bulkBytes = (columnCount - hotColumns) * columnBytes + (collisionHot ? 0 : collisionBytes) +
+                           Collision::listStorageBytes(capacity);
+  if (!arena_.begin(hotBytes, bulkBytes))
+  {
+    storageFailed_ = true;
+    Serial.printf("[SimCore] particle arena allocation failed (capacity=%u)\n", (unsigned)capacity);
+    return false;
+  }
+  for (uint8_t c = 0; c < columnCount; ++c)
+  {
+    float *col = (float *)arena_.alloc(c < hotColumns ? ARENA_HOT : ARENA_BULK, columnBytes);
+    memset(col, 0, columnBytes);
+    *columns[c] = col;
+  }
+  neighbors_.begin(arena_, collisionHot ? ARENA_HOT : ARENA_BULK, capacity);
+  collision_.begin(arena_, collisionHot ? ARENA_HOT : ARENA_BULK, capacity, neighbors_);
+  capacity_ = capacity;
+
+  const ArenaBudget b = arena_.getBudget();
+  Serial.printf("[SimCore] capacity=%u | hot %u/%u B DRAM | bulk %u/%u B %s\n",
+                (unsigned)capacity_,
+                (unsigned)b.hotUsed, (unsigned)b.hotBytes,
+                (unsigned)b.bulkUsed, (unsigned)b.bulkBytes,
+                b.bulkInPsram ? "PSRAM" : "DRAM");
+  return true;
+}
 
 void SimCore::init()
 {
+  if (!allocateStorage())
+  {
+    count_ = 0;
+    return;
+  }
+  collision_.reset();
+  neighbors_.invalidate();
+  turbulence_.reset();
+  voronoi_.reset();
+  fluid_.clear();
   count_ = config_->particleCount;
-  if (count_ > MAX_PARTICLES)
+  if (count_ > capacity_)
+  {
+    count_ = capacity_;
+  }
+  resetSizes(0, count_);
+  if (boundary_.getBoundaryType() >= BOUNDARY_ROUNDED_RECT)
   {
-    count_ = MAX_PARTICLES;
+    // Table-driven shapes have no closed-form layout; fill them like a count increase.
+    const uint16_t target = count_;
+    count_ = 0;
+    spawnParticles(target);
+    return;
   }
-  const bool circular = config_->boundaryShape == 0;
+  const bool circular = boundary_.getBoundaryType() == BOUNDARY_CIRCULAR;
   if (circular)
   {
     const uint16_t rings = (uint16_t)ceilf(sqrtf((float)count_));
@@ -100,31 +184,312 @@ void SimCore::addForceAtPoint(float tx, float ty, float radius, float strength,
 
 void SimCore::step(float dt, float timeSec)
 {
-  if (count_ != config_->particleCount && config_->particleCount <= MAX_PARTICLES)
+  if (config_->fusedStep)
+  {
+    stepFused(dt, timeSec);
+  }
+  else
+  {
+    stepStaged(dt, timeSec);
+  }
+}
+
+void SimCore::stepStaged(float dt, float timeSec)
+{
+  syncCount();
+  applyGravity(dt);
+  applyTurbulence(dt, timeSec);
+  applyVoronoi(dt);
+  applyFluid(dt);
+  resolveCollisions();
+  integrate(dt);
+}
+
+void SimCore::stepFused(float dt, float timeSec)
+{
+  syncCount();
+  // Collision is pairwise and the fluid pass goes through a grid; neither can join the
+  // per-particle pass, so they run first on the previous step's state and everything else
+  // happens in one sweep.
+  resolveCollisions();
+  applyFluid(dt);
+
+  const Simd::F4 gdx = Simd::set1(config_->gravityX * dt);
+  const Simd::F4 gdy = Simd::set1(config_->gravityY * dt);
+  const IntegrateParams integ = getIntegrateParams(dt);
+  const BoundaryParams bounds = boundary_.getParams(dt);
+  const TurbulenceFrame turb = turbulence_.beginFrame(dt, timeSec);
+  const VoronoiFrame cells = voronoi_.beginFrame(boundary_, dt);
+
+  const uint16_t lanes = Simd::paddedCount(count_);
+  for (uint16_t i = 0; i < lanes; i += SIMD_WIDTH)
+  {
+    if (sizesActive_)
+    {
+      updateSizes(turb, i, (uint16_t)(i + SIMD_WIDTH));
+    }
+    Simd::F4 px = Simd::load(x_ + i);
+    Simd::F4 py = Simd::load(y_ + i);
+    Simd::F4 vx = Simd::add(Simd::load(vx_ + i), gdx);
+    Simd::F4 vy = Simd::add(Simd::load(vy_ + i), gdy);
+    if (turb.active || cells.active)
+    {
+      // Field fetches are a gather; round-trip the four lanes through the stack.
+      alignas(16) float lx[SIMD_WIDTH];
+      alignas(16) float ly[SIMD_WIDTH];
+      alignas(16) float lvx[SIMD_WIDTH];
+      alignas(16) float lvy[SIMD_WIDTH];
+      Simd::store(lx, px);
+      Simd::store(ly, py);
+      Simd::store(lvx, vx);
+      Simd::store(lvy, vy);
+      for (uint8_t l = 0; l < SIMD_WIDTH; ++l)
+      {
+        if (turb.active)
+        {
+          turbulence_.accumulate(turb, lx[l], ly[l], lvx[l], lvy[l]);
+        }
+        if (cells.active)
+        {
+          voronoi_.accumulate(cells, lx[l], ly[l], lvx[l], lvy[l]);
+        }
+      }
+      vx = Simd::load(lvx);
+      vy = Simd::load(lvy);
+    }
+    ParticleKernels::integrateLanes(integ, px, py, vx, vy);
+    ParticleKernels::enforceBoundaryLanes(bounds, px, py, vx, vy);
+    Simd::store(x_ + i, px);
+    Simd::store(y_ + i, py);
+    Simd::store(vx_ + i, vx);
+    Simd::store(vy_ + i, vy);
+  }
+  neighbors_.invalidate();
+}
+
+void SimCore::syncCount()
+{
+  if (!arena_.isReady())
+  {
+    if (!storageFailed_)
+    {
+      init();
+    }
+    return;
+  }
+  if (config_->turbAffectScale != sizesActive_)
+  {
+    // Sizes start from particleRadius; the next turbulence pass moves them onto the field.
+    resetSizes(0, count_);
+    sizesActive_ = config_->turbAffectScale;
+  }
+  const uint16_t target = config_->particleCount > capacity_ ? capacity_ : config_->particleCount;
+  if (target > count_)
+  {
+    spawnParticles(target);
+  }
+  else if (target < count_)
+  {
+    retireParticles(target);
+  }
+}
+
+void SimCore::spawnParticles(uint16_t target)
+{
+  // Coarse occupancy histogram; each new particle goes to the emptiest of a few random candidates.
+  static uint16_t occupancy[SPAWN_GRID * SPAWN_GRID];
+  memset(occupancy, 0, sizeof(occupancy));
+  for (uint16_t i = 0; i < count_; ++i)
   {
-    init();
+    ++occupancy[spawnCell(x_[i], y_[i])];
   }
 
+  const bool circular = boundary_.getBoundaryType() == BOUNDARY_CIRCULAR;
+  const bool shaped = boundary_.getBoundaryType() >= BOUNDARY_ROUNDED_RECT;
+  const float spawnRadius = boundary_.getRadius() * 0.95f;
+  while (count_ < target)
+  {
+    float bestX = 0.5f;
+    float bestY = 0.5f;
+    uint16_t bestCell = spawnCell(bestX, bestY);
+    uint16_t bestOccupancy = 0xFFFF;
+    for (uint8_t k = 0; k < SPAWN_CANDIDATES; ++k)
+    {
+      const float u = (float)random(0, 10000) / 10000.0f;
+      const float v = (float)random(0, 10000) / 10000.0f;
+      float cx;
+      float cy;
+      if (circular)
+      {
+        const float r = spawnRadius * sqrtf(u);
+        const float angle = v * 6.2831853f;
+        cx = 0.5f + cosf(angle) * r;
+        cy = 0.5f + sinf(angle) * r;
+      }
+      else
+      {
+        cx = 0.025f + u * 0.95f;
+        cy = 0.025f + v * 0.95f;
+        if (shaped && boundary_.signedDistance(cx, cy) > -0.025f)
+        {
+          continue;
+        }
+      }
+      const uint16_t cell = spawnCell(cx, cy);
+      if (occupancy[cell] < bestOccupancy)
+      {
+        bestOccupancy = occupancy[cell];
+        bestCell = cell;
+        bestX = cx;
+        bestY = cy;
+      }
+    }
+    ++occupancy[bestCell];
+    x_[count_] = bestX;
+    y_[count_] = bestY;
+    vx_[count_] = 0.0f;
+    vy_[count_] = 0.0f;
+    resetSizes(count_, (uint16_t)(count_ + 1));
+    ++count_;
+  }
+  neighbors_.invalidate();
+}
+
+void SimCore::retireParticles(uint16_t target)
+{
+  // Random victims keep the remaining distribution even; removal order does not matter.
+  while (count_ > target)
+  {
+    removeParticle((uint16_t)random(0, count_));
+  }
+}
+
+void SimCore::removeParticle(uint16_t index)
+{
+  if (index >= count_)
+  {
+    return;
+  }
+  const uint16_t last = count_ - 1;
+  collision_.invalidate();
+  neighbors_.invalidate();
+  x_[index] = x_[last];
+  y_[index] = y_[last];
+  vx_[index] = vx_[last];
+  vy_[index] = vy_[last];
+  radius_[index] = radius_[last];
+  mass_[index] = mass_[last];
+  if (states_)
+  {
+    writeParticleState(states_, index, readParticleState(states_, last));
+  }
+  count_ = last;
+}
+
+uint16_t SimCore::spawnCell(float x, float y) const
+{
+  int cx = (int)(x * SPAWN_GRID);
+  int cy = (int)(y * SPAWN_GRID);
+  cx = cx < 0 ? 0 : (cx >= SPAWN_GRID ? SPAWN_GRID - 1 : cx);
+  cy = cy < 0 ? 0 : (cy >= SPAWN_GRID ? SPAWN_GRID - 1 : cy);
+  return (uint16_t)(cy * SPAWN_GRID + cx);
+}
+
+void SimCore::resetSizes(uint16_t begin, uint16_t end)
+{
+  for (uint16_t i = begin; i < end; ++i)
+  {
+    radius_[i] = config_->particleRadius;
+    mass_[i] = 1.0f;
+  }
+}
+
+void SimCore::updateSizes(const TurbulenceFrame &turb, uint16_t begin, uint16_t end)
+{
+  const float invBaseSq = config_->particleRadius > 1e-6f ? 1.0f / (config_->particleRadius * config_->particleRadius) : 1.0f;
+  for (uint16_t i = begin; i < end; ++i)
+  {
+    const float r = turbulence_.particleRadius(turb, x_[i], y_[i]);
+    radius_[i] = r;
+    mass_[i] = r * r * invBaseSq;
+  }
+}
+
+void SimCore::applyGravity(float dt)
+{
   GravityForces::apply(config_->gravityX, config_->gravityY, dt, vx_, vy_, count_);
+}
+
+void SimCore::applyTurbulence(float dt, float timeSec)
+{
   turbulence_.apply(x_, y_, vx_, vy_, count_, dt, timeSec);
-  collision_.resolve(x_, y_, vx_, vy_, count_, config_->particleRadius);
+  if (sizesActive_)
+  {
+    updateSizes(turbulence_.beginFrame(dt, timeSec), 0, count_);
+  }
+}
 
-  const float damping = config_->velocityDamping;
-  const float vmax = config_->maxVelocity;
-  const float vmax2 = vmax * vmax;
+void SimCore::applyVoronoi(float dt)
+{
+  voronoi_.apply(boundary_, x_, y_, vx_, vy_, count_, dt);
+}
+
+void SimCore::applyFluid(float dt)
+{
+  fluid_.step(boundary_, x_, y_, vx_, vy_, count_, dt);
+}
+
+void SimCore::resolveCollisions()
+{
+  collision_.resolve(x_, y_, vx_, vy_, count_, config_->particleRadius, getRadius(), getMass());
+}
+
+void SimCore::integrate(float dt)
+{
+  ParticleKernels::integrate(getIntegrateParams(dt), x_, y_, vx_, vy_, count_);
+  ParticleKernels::enforceBoundary(boundary_.getParams(dt), x_, y_, vx_, vy_, count_);
+  neighbors_.invalidate();
+}
+
+const NeighborGrid &SimCore::getNeighbors()
+{
+  if (!neighbors_.matches(x_, y_, count_))
+  {
+    neighbors_.build(x_, y_, count_, collision_.preferredGridSize(count_, config_->particleRadius, getRadius()));
+  }
+  return neighbors_;
+}
+
+float SimCore::getMaxSpeed() const
+{
+  float maxV2 = 0.0f;
   for (uint16_t i = 0; i < count_; ++i)
   {
-    vx_[i] *= damping;
-    vy_[i] *= damping;
-    float v2 = vx_[i] * vx_[i] + vy_[i] * vy_[i];
-    if (v2 > vmax2)
+    const float v2 = vx_[i] * vx_[i] + vy_[i] * vy_[i];
+    if (v2 > maxV2)
     {
-      float inv = vmax / sqrtf(v2);
-      vx_[i] *= inv;
-      vy_[i] *= inv;
+      maxV2 = v2;
     }
-    x_[i] += vx_[i] * dt * config_->timeScale;
-    y_[i] += vy_[i] * dt * config_->timeScale;
-    boundary_.enforce(x_[i], y_[i], vx_[i], vy_[i]);
   }
+  return sqrtf(maxV2);
+}
+
+float SimCore::getMinRadius() const
+{
+  if (!sizesActive_)
+  {
+    return config_->particleRadius;
+  }
+  return config_->turbMinScale < config_->particleRadius ? config_->turbMinScale : config_->particleRadius;
+}
+
+IntegrateParams SimCore::getIntegrateParams(float dt) const
+{
+  IntegrateParams p;
+  // velocityDamping is per timeStep; substeps compound to the same per-frame damping.
+  p.damping = dt == config_->timeStep ? config_->velocityDamping : powf(config_->velocityDamping, dt / config_->timeStep);
+  p.vmax = config_->maxVelocity;
+  p.vmax2 = p.vmax * p.vmax;
+  p.posScale = dt * config_->timeScale;
+  return p;
 }
@@ -0,0 +1,113 @@
+#include "SimTask.h"
+
+#include <Arduino.h>
+
+#if !SIM_NATIVE
+static constexpr uint32_t kSimTaskStackBytes = 8192;
+static constexpr UBaseType_t kSimTaskPriority = 2;
+#endif
+// Frames caught up per wake; later time is reported as dropped by the scheduler.
+static constexpr uint8_t kMaxFramesPerWake = 4;
+
+bool SimTask::start(SimCore *sim, SnapshotBuffer *snapshot, SubstepScheduler *scheduler, SimStepFn stepFn, uint8_t core)
+{
+  if (running_.load() || !sim || !snapshot || !scheduler || !stepFn)
+  {
+    return false;
+  }
+  sim_ = sim;
+  snapshot_ = snapshot;
+  scheduler_ = scheduler;
+  stepFn_ = stepFn;
+  stopRequested_.store(false);
+  running_.store(true);
+  snapshot_->publish(sim_->getView(), frame_);
+
+#if SIM_NATIVE
+  (void)core;
+  thread_ = std::thread(taskEntry, this);
+  return true;
+#else
+  if (xTaskCreatePinnedToCore(taskEntry, "sim", kSimTaskStackBytes, this, kSimTaskPriority, &handle_, core) != pdPASS)
+  {
+    running_.store(false);
+    return false;
+  }
+  return true;
+#endif
+}
+
+void SimTask::stop()
+{
+  if (!running_.load())
+  {
+    return;
+  }
+  stopRequested_.store(true);
+#if SIM_NATIVE
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+#else
+  while (running_.load())
+  {
+    vTaskDelay(1);
+  }
+  handle_ = nullptr;
+#endif
+}
+
+void SimTask::taskEntry(void *arg)
+{
+  static_cast<SimTask *>(arg)->run();
+#if !SIM_NATIVE
+  vTaskDelete(nullptr);
+#endif
+}
+
+SchedulerStats SimTask::consumeStats()
+{
+  SchedulerStats out;
+  out.frames = frames_.exchange(0, std::memory_order_relaxed);
+  out.substeps = substeps_.exchange(0, std::memory_order_relaxed);
+  out.droppedMs = droppedUs_.exchange(0, std::memory_order_relaxed) / 1000.0f;
+  out.lastSubsteps = lastSubsteps_.load(std::memory_order_relaxed);
+  return out;
+}
+
+void SimTask::run()
+{
+  uint32_t lastUs = micros();
+  while (!stopRequested_.load(std::memory_order_relaxed))
+  {
+    if (restartRequested_.exchange(false, std::memory_order_relaxed))
+    {
+      sim_->init();
+      snapshot_->publish(sim_->getView(), ++frame_);
+    }
+
+    const uint32_t nowUs = micros();
+    const uint8_t due = scheduler_->advance((nowUs - lastUs) / 1000.0f, kMaxFramesPerWake);
+    lastUs = nowUs;
+    for (uint8_t f = 0; f < due; ++f)
+    {
+      stepFn_(scheduler_->getSimTimeSec());
+      snapshot_->publish(sim_->getView(), ++frame_);
+    }
+
+    // The scheduler is only touched on this task; hand its counters over atomically.
+    const SchedulerStats stats = scheduler_->consumeStats();
+    frames_.fetch_add(stats.frames, std::memory_order_relaxed);
+    substeps_.fetch_add(stats.substeps, std::memory_order_relaxed);
+    droppedUs_.fetch_add((uint32_t)(stats.droppedMs * 1000.0f), std::memory_order_relaxed);
+    lastSubsteps_.store(stats.lastSubsteps, std::memory_order_relaxed);
+
+#if SIM_NATIVE
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#else
+    vTaskDelay(1);
+#endif
+  }
+  running_.store(false);
+}
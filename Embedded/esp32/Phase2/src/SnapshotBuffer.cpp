@@ -0,0 +1,80 @@
+#include "SnapshotBuffer.h"
+
+#include <string.h>
+
+bool SnapshotBuffer::begin(uint16_t capacity)
+{
+  if (arena_.isReady())
+  {
+    return true;
+  }
+  const size_t columnBytes = ((size_t)capacity * sizeof(float) + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+  const size_t stateBytes = ((size_t)particleStateWords(capacity) * sizeof(uint32_t) + (ARENA_ALIGN - 1)) & ~(ARENA_ALIGN - 1);
+  // Snapshots are only read once per render frame, so they live in the bulk (PSRAM) region.
+  if (!arena_.begin(0, (columnBytes * 5 + stateBytes) * kSlotCount))
+  {
+    return false;
+  }
+  for (uint8_t s = 0; s < kSlotCount; ++s)
+  {
+    Slot &slot = slots_[s];
+    slot.x = (float *)arena_.alloc(ARENA_BULK, columnBytes);
+    slot.y = (float *)arena_.alloc(ARENA_BULK, columnBytes);
+    slot.vx = (float *)arena_.alloc(ARENA_BULK, columnBytes);
+    slot.vy = (float *)arena_.alloc(ARENA_BULK, columnBytes);
+    slot.radius = (float *)arena_.alloc(ARENA_BULK, columnBytes);
+    slot.states = (uint32_t *)arena_.alloc(ARENA_BULK, stateBytes);
+    slot.sized = false;
+    slot.stated = false;
+    slot.count = 0;
+    slot.frame = 0;
+  }
+  capacity_ = capacity;
+  return true;
+}
+
+void SnapshotBuffer::publish(const ParticleView &src, uint32_t frame)
+{
+  if (!arena_.isReady())
+  {
+    return;
+  }
+  Slot &slot = slots_[back_];
+  const uint16_t count = src.getCount() > capacity_ ? capacity_ : src.getCount();
+  const size_t bytes = (size_t)count * sizeof(float);
+  memcpy(slot.x, src.getX(), bytes);
+  memcpy(slot.y, src.getY(), bytes);
+  memcpy(slot.vx, src.getVx(), bytes);
+  memcpy(slot.vy, src.getVy(), bytes);
+  slot.sized = src.getRadius() != nullptr;
+  if (slot.sized)
+  {
+    memcpy(slot.radius, src.getRadius(), bytes);
+  }
+  slot.stated = src.getStates() != nullptr;
+  if (slot.stated)
+  {
+    memcpy(slot.states, src.getStates(), particleStateWords(count) * sizeof(uint32_t));
+  }
+  slot.count = count;
+  slot.frame = frame;
+  // Release orders the slot contents before the index becomes visible to the reader.
+  const uint8_t prev = ready_.exchange((uint8_t)(back_ | kFreshBit), std::memory_order_acq_rel);
+  back_ = prev & ~kFreshBit;
+}
+
+ParticleView SnapshotBuffer::acquire()
+{
+  if (!arena_.isReady())
+  {
+    return ParticleView();
+  }
+  if (ready_.load(std::memory_order_relaxed) & kFreshBit)
+  {
+    const uint8_t prev = ready_.exchange(front_, std::memory_order_acq_rel);
+    front_ = prev & ~kFreshBit;
+  }
+  const Slot &slot = slots_[front_];
+  return ParticleView(slot.x, slot.y, slot.vx, slot.vy, slot.count, slot.sized ? slot.radius : nullptr, nullptr,
+                      slot.stated ? slot.states : nullptr);
+}
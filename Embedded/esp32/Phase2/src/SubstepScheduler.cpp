@@ -0,0 +1,75 @@
+#include "SubstepScheduler.h"
+
+#include "SimCore.h"
+
+#include <math.h>
+
+// Longest wall-time gap accepted in one call; anything beyond is dropped.
+static constexpr float kMaxElapsedMs = 100.0f;
+
+uint8_t SubstepScheduler::advance(float elapsedMs, uint8_t maxFramesPerCall)
+{
+  if (elapsedMs < 0.0f)
+  {
+    elapsedMs = 0.0f;
+  }
+  if (elapsedMs > kMaxElapsedMs)
+  {
+    stats_.droppedMs += elapsedMs - kMaxElapsedMs;
+    elapsedMs = kMaxElapsedMs;
+  }
+  accumMs_ += elapsedMs;
+
+  uint32_t owed = (uint32_t)(accumMs_ / frameMs_);
+  if (owed > maxFramesPerCall)
+  {
+    stats_.droppedMs += (float)(owed - maxFramesPerCall) * frameMs_;
+    accumMs_ -= (float)(owed - maxFramesPerCall) * frameMs_;
+    owed = maxFramesPerCall;
+  }
+  accumMs_ -= (float)owed * frameMs_;
+  return (uint8_t)owed;
+}
+
+uint8_t SubstepScheduler::planSubsteps(float maxSpeed, float minRadius) const
+{
+  const uint8_t maxSubsteps = config_->maxSubsteps < 1 ? 1 : config_->maxSubsteps;
+  const float limit = config_->substepCfl * minRadius;
+  if (limit <= 1e-6f)
+  {
+    return maxSubsteps;
+  }
+  // Positions advance by v * dt * timeScale per frame (see IntegrateParams::posScale).
+  const float travel = maxSpeed * config_->timeStep * config_->timeScale;
+  const float needed = ceilf(travel / limit);
+  if (needed <= 1.0f)
+  {
+    return 1;
+  }
+  return needed >= (float)maxSubsteps ? maxSubsteps : (uint8_t)needed;
+}
+
+void SubstepScheduler::runFrame(SimCore &sim)
+{
+  const uint8_t substeps = planSubsteps(sim.getMaxSpeed(), sim.getMinRadius());
+  const float dt = config_->timeStep;
+  const float subDt = dt / (float)substeps;
+  for (uint8_t k = 0; k < substeps; ++k)
+  {
+    sim.step(subDt, simTimeSec_ + subDt * (float)k);
+  }
+  simTimeSec_ += dt;
+
+  ++stats_.frames;
+  stats_.substeps += substeps;
+  stats_.lastSubsteps = substeps;
+}
+
+SchedulerStats SubstepScheduler::consumeStats()
+{
+  const SchedulerStats out = stats_;
+  stats_.frames = 0;
+  stats_.substeps = 0;
+  stats_.droppedMs = 0.0f;
+  return out;
+}
@@ -2,32 +2,53 @@
 
 #include <math.h>
 
-static float fractf(float v)
+TurbulenceFrame Turbulence::beginFrame(float dt, float tNow)
 {
-  return v - floorf(v);
+  TurbulenceFrame f;
+  const float strength = config_->turbStrength;
+  f.active = strength > 1e-6f;
+  if (f.active || config_->turbAffectScale)
+  {
+    field_.refresh(tNow);
+  }
+  f.gain = strength * dt;
+  f.decay = config_->turbDecayRate < 1.0f && config_->timeStep > 0.0f ? powf(config_->turbDecayRate, dt / config_->timeStep) : 1.0f;
+  f.biasX = config_->turbAffectPosition ? config_->turbDirectionBiasX * strength * dt : 0.0f;
+  f.biasY = config_->turbAffectPosition ? config_->turbDirectionBiasY * strength * dt : 0.0f;
+  f.scaleField = config_->turbScaleField;
+  f.scaleGain = strength * 0.1f;
+  f.minScale = config_->turbMinScale;
+  f.scaleRange = config_->turbMaxScale > config_->turbMinScale ? config_->turbMaxScale - config_->turbMinScale : 0.0f;
+  return f;
 }
 
-float Turbulence::noise2d(float x, float y) const
+void Turbulence::accumulate(const TurbulenceFrame &frame, float x, float y, float &vx, float &vy) const
 {
-  float h = sinf(x * 12.9898f + y * 78.233f) * 43758.5453f;
-  return fractf(h) * 2.0f - 1.0f;
+  const TurbulenceCell s = field_.sample(x, y);
+  vx = vx * frame.decay + frame.biasX + s.fx * frame.gain;
+  vy = vy * frame.decay + frame.biasY + s.fy * frame.gain;
+  if (frame.scaleField)
+  {
+    const float k = 1.0f + (s.value - 0.5f) * frame.scaleGain;
+    vx *= k;
+    vy *= k;
+  }
+}
+
+float Turbulence::particleRadius(const TurbulenceFrame &frame, float x, float y) const
+{
+  return frame.minScale + field_.sample(x, y).value * frame.scaleRange;
 }
 
 void Turbulence::apply(float *x, float *y, float *vx, float *vy, uint16_t count, float dt, float tNow)
 {
-  const float strength = config_->turbStrength;
-  if (strength <= 1e-6f)
+  const TurbulenceFrame frame = beginFrame(dt, tNow);
+  if (!frame.active)
   {
     return;
   }
-  const float scale = config_->turbScale;
-  const float speed = config_->turbSpeed;
-  const float z = tNow * speed;
   for (uint16_t i = 0; i < count; ++i)
   {
-    float n1 = noise2d(x[i] * scale + z, y[i] * scale - z);
-    float n2 = noise2d(y[i] * scale - z, x[i] * scale + z);
-    vx[i] += n1 * strength * dt;
-    vy[i] += n2 * strength * dt;
+    accumulate(frame, x[i], y[i], vx[i], vy[i]);
   }
 }
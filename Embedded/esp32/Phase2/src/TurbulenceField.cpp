@@ -0,0 +1,452 @@
+#include "TurbulenceField.h"
+
+#include "Noise.h"
+
+#include <math.h>
+
+static constexpr float kTwoPi = 6.2831853f;
+static constexpr float kPi = 3.14159265f;
+static constexpr float kNodeStep = 1.0f / (TURB_FIELD_SIZE - 1);
+// JS blur samples a ring of 0.05 * blurAmount; here it is a box of that half-width.
+static constexpr float kBlurReach = 0.05f;
+// Fixed-point value channel: [0, 1] in 1 / kFixedOne steps; persistence weights in 1 / kPersistOne.
+static constexpr float kFixedOne = 65535.0f;
+static constexpr float kPersistOne = 32767.0f;
+// Steady-state pattern drift of the JS bias physics, in pattern units per second at full bias.
+static constexpr float kBiasDrift = 4.0f;
+
+// Bandpass contrast curve points (JS defaults).
+static constexpr float kShadowPoint = 0.1f;
+static constexpr float kMidPoint = 0.35f;
+static constexpr float kHighlightPoint = 0.7f;
+static constexpr float kDarkBoost = 1.5f;
+
+// JS patternOffsets, applied after rotation / scale / warp / symmetry.
+static const float kPatternOffset[TURB_PATTERN_COUNT][2] = {
+    {0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.5f, -0.5f}, {0.0f, 0.0f},
+    {0.1f, -0.12f}, {0.0f, 0.0f}, {0.5f, -0.5f}, {0.0f, 0.0f}, {0.5f, -0.5f},
+    {0.5f, -0.5f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f},
+    {0.0f, 0.0f}};
+
+// TURB_NOISE: noise cells per pattern unit at turbPatternFrequency 1, and the octave seeds.
+static constexpr float kNoiseFreq = 0.5f;
+static constexpr uint32_t kNoiseSeed = 0x5eed1234u;
+
+static inline float clamp01(float v)
+{
+  return v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+}
+
+// JS applyContrast: pull-factor curve, bandpass contrast, then the separation sigmoid.
+static float applyContrast(float value, float pull, float contrast, float separation)
+{
+  if (pull < 0.0f)
+  {
+    value = value * (1.0f + pull) + (1.0f - value) * -pull;
+  }
+  else if (pull > 0.0f)
+  {
+    value = value > 0.5f ? 0.5f + (value - 0.5f) * (1.0f + pull * 3.0f) : value * (1.0f - pull * 0.5f);
+    value = clamp01(value);
+  }
+
+  if (contrast > 0.0f)
+  {
+    if (value < kMidPoint)
+    {
+      const float shadowRange = (value - kShadowPoint) / (kMidPoint - kShadowPoint);
+      if (shadowRange > 0.0f)
+      {
+        const float boosted = kShadowPoint + shadowRange * (kMidPoint - kShadowPoint) *
+                                                 powf(shadowRange, 1.0f / (1.0f + kDarkBoost * contrast));
+        value = value * (1.0f - contrast) + boosted * contrast;
+      }
+    }
+    else if (value < kHighlightPoint)
+    {
+      const float range = (value - kMidPoint) / (kHighlightPoint - kMidPoint);
+      const float adjusted = contrast * (1.0f - sqrtf(range));
+      const float midCurve = kMidPoint + (value - kMidPoint) * powf(range, 1.0f - adjusted * 0.5f);
+      value = value * (1.0f - adjusted) + midCurve * adjusted;
+    }
+  }
+
+  if (separation > 0.0f)
+  {
+    value = 1.0f / (1.0f + expf(-(value - 0.5f) * (1.0f + separation * 12.0f)));
+  }
+  return clamp01(value);
+}
+
+void TurbulenceField::reset()
+{
+  baked_ = false;
+  bakedAt_ = 0.0f;
+  biasOffsetX_ = 0.0f;
+  biasOffsetY_ = 0.0f;
+}
+
+bool TurbulenceField::refresh(float tNow)
+{
+  const float period = config_->turbFieldRate > 0.0f ? 1.0f / config_->turbFieldRate : 0.0f;
+  // A little slack so a 60 Hz step clock hits a 20 Hz bake every third step despite rounding.
+  if (baked_ && tNow >= bakedAt_ && tNow - bakedAt_ < period * 0.99f)
+  {
+    return false;
+  }
+  const float elapsed = baked_ && tNow > bakedAt_ ? tNow - bakedAt_ : 0.0f;
+  const float drift = config_->turbBiasStrength * kBiasDrift * elapsed;
+  biasOffsetX_ -= config_->turbDirectionBiasX * drift;
+  biasOffsetY_ += config_->turbDirectionBiasY * drift;
+  bake(tNow);
+  return true;
+}
+
+void TurbulenceField::bake(float tNow)
+{
+  beginFrame(tNow);
+  float px[TURB_FIELD_SIZE];
+  float py[TURB_FIELD_SIZE];
+  float n[TURB_FIELD_SIZE];
+  for (uint8_t gy = 0; gy < TURB_FIELD_SIZE; ++gy)
+  {
+    for (uint8_t gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+    {
+      transform(gx * kNodeStep, gy * kNodeStep, px[gx], py[gx]);
+    }
+    if (frame_.style == TURB_NOISE)
+    {
+      noiseRow(px, py, n);
+    }
+    else
+    {
+      for (uint8_t gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+      {
+        n[gx] = pattern(px[gx], py[gx]);
+      }
+    }
+    for (uint8_t gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+    {
+      fixed_[gy * TURB_FIELD_SIZE + gx] = (uint16_t)(finish(n[gx]) * kFixedOne + 0.5f);
+    }
+  }
+  blurValues((uint8_t)(config_->turbBlurAmount * kBlurReach * (TURB_FIELD_SIZE - 1) + 0.5f));
+  const float elapsed = baked_ && tNow > bakedAt_ ? tNow - bakedAt_ : 0.0f;
+  const float keep = config_->turbFieldPersistence > 0.0f && config_->timeStep > 0.0f && elapsed > 0.0f
+                         ? powf(config_->turbFieldPersistence, elapsed / config_->timeStep)
+                         : 0.0f;
+  persistValues((int32_t)(keep * kPersistOne + 0.5f));
+  bakeForces();
+  baked_ = true;
+  bakedAt_ = tNow;
+}
+
+void TurbulenceField::beginFrame(float tNow)
+{
+  Frame &f = frame_;
+  const float speed = config_->turbSpeed;
+  const float phaseSpeed = config_->turbPhaseSpeed;
+  f.style = config_->turbPatternStyle < TURB_PATTERN_COUNT ? config_->turbPatternStyle : (uint8_t)TURB_CHECKERBOARD;
+  const float rotation = config_->turbRotation + tNow * config_->turbRotationSpeed;
+  f.cosR = cosf(-rotation);
+  f.sinR = sinf(-rotation);
+  f.scale = config_->turbScale;
+  // JS `time` advances by dt * speed and the animated terms scale it by speed again.
+  const float time = tNow * speed;
+  f.warp = config_->turbDomainWarp;
+  f.warpPhase = speed > 0.0f && config_->turbDomainWarpSpeed > 0.0f ? time * speed * config_->turbDomainWarpSpeed : 0.0f;
+  f.symmetry = config_->turbSymmetryAmount;
+  f.offsetX = biasOffsetX_ - kPatternOffset[f.style][0];
+  f.offsetY = biasOffsetY_ + kPatternOffset[f.style][1];
+  f.freq = config_->turbPatternFrequency;
+  f.motion = time * speed;
+  f.phaseTime = time * (fabsf(phaseSpeed) > 1.0f ? fabsf(phaseSpeed) : 1.0f) * speed;
+  f.phaseOffset = (speed > 0.0f ? time * speed * phaseSpeed : 0.0f) + config_->turbPhase * kTwoPi;
+  f.pull = config_->turbPullFactor;
+  f.contrast = config_->turbContrast;
+  f.separation = config_->turbSeparation;
+
+  dropCount_ = 0;
+  if (f.style != TURB_CLASSIC_DROP)
+  {
+    return;
+  }
+  // Drop positions and ripple radii only depend on time; hoist them out of the node loop.
+  const int wanted = (int)floorf(f.freq * 3.0f);
+  const uint8_t maxDrops = (uint8_t)(wanted < 3 ? 3 : (wanted > TURB_MAX_DROPS ? TURB_MAX_DROPS : wanted));
+  const float cycleLength = 8.0f / f.freq;
+  const float activeTime = cycleLength * 0.75f;
+  const float timeVariation = f.phaseTime * 0.05f;
+  for (uint8_t i = 0; i < maxDrops; ++i)
+  {
+    const float dropSeed = 12.9898f * (i + 1) + 4.1414f;
+    const float timeSeed = 78.233f * (i + 1) + 7.7575f;
+    const float sizeSeed = 43758.5453f * (i + 1) + 1.8989f;
+    const float cycleOffset = i * kTwoPi / maxDrops * (1.0f + sinf(sizeSeed * 3.333f + i * 7.1f) * 0.1f);
+    const float age = fmodf(f.phaseTime + cycleOffset, cycleLength);
+    if (age >= activeTime)
+    {
+      continue;
+    }
+    const float ring = 1.0f + sinf(dropSeed * 13.33f + timeVariation) * 0.3f;
+    const float angle = sinf(timeSeed * 0.75f + timeVariation * 0.3f) * 0.2f;
+    const float norm = age / activeTime;
+    const float width = 0.12f + 0.18f * (1.0f - norm);
+    Drop &d = drops_[dropCount_++];
+    d.x = 0.5f + ring * cosf(dropSeed + i * 2.2f + angle);
+    d.y = 0.5f + ring * sinf(timeSeed + i * 4.3f + angle);
+    d.radius = norm * (1.0f + sinf(sizeSeed) * 0.4f);
+    d.invWidthSq = 1.0f / (width * width);
+    d.intensity = 1.0f - norm * 0.8f;
+  }
+}
+
+float TurbulenceField::evaluate(float x, float y) const
+{
+  float px;
+  float py;
+  transform(x, y, px, py);
+  return finish(pattern(px, py));
+}
+
+void TurbulenceField::transform(float x, float y, float &px, float &py) const
+{
+  const Frame &f = frame_;
+  float tx = x - 0.5f;
+  float ty = y - 0.5f;
+  const float rx = tx * f.cosR - ty * f.sinR;
+  const float ry = tx * f.sinR + ty * f.cosR;
+  tx = rx * f.scale;
+  ty = ry * f.scale;
+  if (f.warp > 0.0f)
+  {
+    const float wx = tx + f.warp * sinf(ty * 2.0f + f.warpPhase);
+    const float wy = ty + f.warp * cosf(tx * 2.0f + f.warpPhase);
+    tx = wx;
+    ty = wy;
+  }
+  if (f.symmetry > 0.0f)
+  {
+    const float dist = sqrtf(tx * tx + ty * ty);
+    const float angle = atan2f(ty, tx) * (1.0f + f.symmetry);
+    tx = dist * cosf(angle);
+    ty = dist * sinf(angle);
+  }
+  px = tx + 0.5f + f.offsetX;
+  py = ty + 0.5f + f.offsetY;
+}
+
+float TurbulenceField::finish(float n) const
+{
+  const Frame &f = frame_;
+  return applyContrast((sinf(n * kTwoPi + f.phaseOffset) + 1.0f) * 0.5f, f.pull, f.contrast, f.separation);
+}
+
+void TurbulenceField::noiseRow(const float *px, const float *py, float *out) const
+{
+  const float k = frame_.freq * kNoiseFreq;
+  float sx[TURB_FIELD_SIZE];
+  float sy[TURB_FIELD_SIZE];
+  float fine[TURB_FIELD_SIZE];
+  for (uint8_t i = 0; i < TURB_FIELD_SIZE; ++i)
+  {
+    sx[i] = px[i] * k;
+    sy[i] = py[i] * k;
+  }
+  Noise::simplex3(sx, sy, frame_.motion * 0.5f, out, TURB_FIELD_SIZE, kNoiseSeed);
+  for (uint8_t i = 0; i < TURB_FIELD_SIZE; ++i)
+  {
+    sx[i] *= 2.0f;
+    sy[i] *= 2.0f;
+  }
+  Noise::simplex3(sx, sy, frame_.motion, fine, TURB_FIELD_SIZE, kNoiseSeed + 1);
+  for (uint8_t i = 0; i < TURB_FIELD_SIZE; ++i)
+  {
+    out[i] = (out[i] + 0.5f * fine[i]) * (1.0f / 1.5f);
+  }
+}
+
+float TurbulenceField::pattern(float x, float y) const
+{
+  const float freq = frame_.freq;
+  const float dx = x - 0.5f;
+  const float dy = y - 0.5f;
+  switch (frame_.style)
+  {
+  case TURB_WAVES:
+    return sinf(x * freq + y * freq * 0.5f);
+  case TURB_SPIRAL:
+    return sinf(atan2f(dy, dx) * freq + sqrtf(dx * dx + dy * dy) * freq * 0.1f);
+  case TURB_GRID:
+    return sinf(x * freq) + sinf(y * freq);
+  case TURB_CIRCLES:
+    return sinf(sqrtf(dx * dx + dy * dy) * freq * kPi * 0.3f);
+  case TURB_DIAMONDS:
+    return sinf(x * freq + y * freq) * cosf(x * freq - y * freq) * 0.8f;
+  case TURB_RIPPLES:
+    return sinf(sqrtf(dx * dx + dy * dy) * freq * kPi * 0.4f - frame_.motion);
+  case TURB_DOTS:
+  {
+    const float dotX = sinf(x * freq * 0.17f * kPi);
+    const float dotY = sinf(y * freq * 0.17f * kPi);
+    return cosf(sqrtf(dotX * dotX + dotY * dotY) * kPi);
+  }
+  case TURB_VORONOI:
+  {
+    // Four fixed seeds on a ring of 1.5 around the center.
+    const float seeds[4][2] = {{1.5f, 0.0f}, {0.0f, 1.5f}, {-1.5f, 0.0f}, {0.0f, -1.5f}};
+    float minSq = 1e30f;
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+      const float ex = dx - seeds[i][0];
+      const float ey = dy - seeds[i][1];
+      const float d2 = ex * ex + ey * ey;
+      minSq = d2 < minSq ? d2 : minSq;
+    }
+    return sinf(sqrtf(minSq) * freq * kPi * 0.5f);
+  }
+  case TURB_CELLS:
+  {
+    const float cellSize = 2.4f / freq;
+    const float gx = floorf(x / cellSize);
+    const float gy = floorf(y / cellSize);
+    float minSq = 1e30f;
+    for (uint8_t oy = 0; oy <= 1; ++oy)
+    {
+      for (uint8_t ox = 0; ox <= 1; ++ox)
+      {
+        const float ex = x - (gx + ox + 0.5f) * cellSize;
+        const float ey = y - (gy + oy + 0.5f) * cellSize;
+        const float d2 = ex * ex + ey * ey;
+        minSq = d2 < minSq ? d2 : minSq;
+      }
+    }
+    return sinf(sqrtf(minSq) * kPi * 1.5f);
+  }
+  case TURB_FRACTAL:
+    // Three octaves at the same frequency with halving amplitude, as in the JS.
+    return 1.0f + 1.75f * sinf(x * freq) * sinf(y * freq);
+  case TURB_VORTEX:
+    return sinf(atan2f(dy, dx) * freq + sqrtf(dx * dx + dy * dy) * 2.0f);
+  case TURB_BUBBLES:
+  {
+    const float bx = dx * freq;
+    const float by = dy * freq;
+    return sinf(sqrtf(bx * bx + by * by)) * cosf(bx) * sinf(by);
+  }
+  case TURB_WATER:
+    return sinf(y * freq * 0.5f + x * freq * 0.2f + frame_.motion * 0.5f) * 0.5f +
+           sinf(x * freq * 1.5f + y * freq * 1.2f + frame_.motion * 0.3f) * 0.3f;
+  case TURB_CLASSIC_DROP:
+  {
+    float v = sinf(x * freq * 0.2f + y * freq * 0.3f + frame_.phaseTime * 0.2f) * 0.1f;
+    for (uint8_t i = 0; i < dropCount_; ++i)
+    {
+      const Drop &d = drops_[i];
+      const float ex = x - d.x;
+      const float ey = y - d.y;
+      const float ring = sqrtf(ex * ex + ey * ey) - d.radius;
+      v += expf(-ring * ring * d.invWidthSq) * d.intensity;
+    }
+    v *= 0.7f;
+    return v < 1.0f ? v : 1.0f;
+  }
+  case TURB_NOISE:
+  {
+    // Same sums as noiseRow; the scalar and batch simplex3 agree bit for bit.
+    const float k = frame_.freq * kNoiseFreq;
+    const float a = Noise::simplex3(x * k, y * k, frame_.motion * 0.5f, kNoiseSeed);
+    const float b = Noise::simplex3(x * k * 2.0f, y * k * 2.0f, frame_.motion, kNoiseSeed + 1);
+    return (a + 0.5f * b) * (1.0f / 1.5f);
+  }
+  default:
+    return sinf(x * freq) * sinf(y * freq);
+  }
+}
+
+// Separable box blur of the fixed-point values: one running sum per row, then per column, so the
+// cost is O(cells) whatever the radius. Edges clamp.
+void TurbulenceField::blurValues(uint8_t radius)
+{
+  if (radius == 0)
+  {
+    return;
+  }
+  const int r = radius < TURB_FIELD_SIZE / 2 ? radius : TURB_FIELD_SIZE / 2;
+  const uint32_t width = 2 * r + 1;
+  uint16_t line[TURB_FIELD_SIZE];
+  for (uint8_t pass = 0; pass < 2; ++pass)
+  {
+    // Pass 0 walks rows, pass 1 columns.
+    const int stride = pass == 0 ? 1 : TURB_FIELD_SIZE;
+    const int step = pass == 0 ? TURB_FIELD_SIZE : 1;
+    for (int l = 0; l < TURB_FIELD_SIZE; ++l)
+    {
+      uint16_t *row = fixed_ + l * step;
+      for (int i = 0; i < TURB_FIELD_SIZE; ++i)
+      {
+        line[i] = row[i * stride];
+      }
+      uint32_t sum = 0;
+      for (int k = -r; k <= r; ++k)
+      {
+        sum += line[k < 0 ? 0 : k];
+      }
+      for (int i = 0; i < TURB_FIELD_SIZE; ++i)
+      {
+        row[i * stride] = (uint16_t)((sum + width / 2) / width);
+        const int out = i - r;
+        const int in = i + r + 1;
+        sum += line[in < TURB_FIELD_SIZE ? in : TURB_FIELD_SIZE - 1];
+        sum -= line[out < 0 ? 0 : out];
+      }
+    }
+  }
+}
+
+// Temporal decay: the new bake moves toward the fresh values, keeping `keep` / kPersistOne of the
+// previous field, then the float value channel is written for sample().
+void TurbulenceField::persistValues(int32_t keep)
+{
+  for (uint16_t i = 0; i < TURB_FIELD_SIZE * TURB_FIELD_SIZE; ++i)
+  {
+    const int32_t fresh = fixed_[i];
+    const int32_t v = fresh + (((int32_t)history_[i] - fresh) * keep >> 15);
+    history_[i] = (uint16_t)v;
+    cells_[i].value = v * (1.0f / kFixedOne);
+  }
+}
+
+// Central-difference gradient of the value, turned into the force direction and normalized so the
+// strongest node has length 1 (scaled by |turbPullFactor| in pull / push mode).
+void TurbulenceField::bakeForces()
+{
+  const bool pullMode = config_->turbAffectPosition;
+  const float pull = config_->turbPullFactor;
+  // JS: positive pulls up the gradient, mild negative pushes down it, strong negative pulls again.
+  const float sign = pull > 0.0f || pull <= -0.5f ? 1.0f : -1.0f;
+  float maxSq = 0.0f;
+  for (int gy = 0; gy < TURB_FIELD_SIZE; ++gy)
+  {
+    const int y0 = gy > 0 ? gy - 1 : gy;
+    const int y1 = gy < TURB_FIELD_SIZE - 1 ? gy + 1 : gy;
+    for (int gx = 0; gx < TURB_FIELD_SIZE; ++gx)
+    {
+      const int x0 = gx > 0 ? gx - 1 : gx;
+      const int x1 = gx < TURB_FIELD_SIZE - 1 ? gx + 1 : gx;
+      const float ddx = (cells_[gy * TURB_FIELD_SIZE + x1].value - cells_[gy * TURB_FIELD_SIZE + x0].value) / (x1 - x0);
+      const float ddy = (cells_[y1 * TURB_FIELD_SIZE + gx].value - cells_[y0 * TURB_FIELD_SIZE + gx].value) / (y1 - y0);
+      TurbulenceCell &c = cells_[gy * TURB_FIELD_SIZE + gx];
+      c.fx = pullMode ? sign * ddx : -ddy;
+      c.fy = pullMode ? sign * ddy : ddx;
+      const float sq = c.fx * c.fx + c.fy * c.fy;
+      maxSq = sq > maxSq ? sq : maxSq;
+    }
+  }
+  const float gain = maxSq > 1e-12f ? (pullMode ? fabsf(pull) : 1.0f) / sqrtf(maxSq) : 0.0f;
+  for (uint16_t i = 0; i < TURB_FIELD_SIZE * TURB_FIELD_SIZE; ++i)
+  {
+    cells_[i].fx *= gain;
+    cells_[i].fy *= gain;
+  }
+}
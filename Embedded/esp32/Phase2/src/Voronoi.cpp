@@ -1,7 +1,501 @@
 #include "Voronoi.h"
 
-void Voronoi::step(float dt)
+#include <math.h>
+
+// Seeds stay this far inside the boundary (the JS keeps them within 0.9 of the radius).
+static constexpr float kSeedMargin = 0.05f;
+// A seed that moved this far since the last flood triggers the next one.
+static constexpr float kRebuildDrift = 0.5f / VORONOI_GRID;
+// Chance per timeStep that a seed picks a new velocity, as in the JS update().
+static constexpr float kRerollChance = 0.01f;
+// Force multipliers from the JS applyTurbulence(): approaching an edge, holding on it, and
+// sliding along it.
+static constexpr float kApproachGain = 0.3f;
+static constexpr float kHoldGain = 0.1f;
+static constexpr float kAlongGain = 0.05f;
+// Edge factor above which a particle counts as on the edge.
+static constexpr float kOnEdge = 0.7f;
+
+static inline float random01()
+{
+  return (float)random(0, 10000) / 10000.0f;
+}
+
+void Voronoi::reset()
+{
+  seedCount_ = 0;
+  seedShape_ = 0xFF;
+  dirty_ = true;
+  stats_ = VoronoiStats();
+}
+
+VoronoiStats Voronoi::consumeStats()
+{
+  const VoronoiStats s = stats_;
+  stats_ = VoronoiStats();
+  return s;
+}
+
+void Voronoi::randomVelocity(Seed &s) const
+{
+  const float angle = random01() * 6.2831853f;
+  const float speed = random01() * config_->voronoiCellSpeed;
+  s.vx = cosf(angle) * speed;
+  s.vy = sinf(angle) * speed;
+}
+
+void Voronoi::scatterSeeds(const Boundary &boundary)
+{
+  uint8_t count = config_->voronoiCellCount;
+  count = count < 2 ? 2 : (count > VORONOI_MAX_SEEDS ? VORONOI_MAX_SEEDS : count);
+  for (uint8_t s = 0; s < count; ++s)
+  {
+    Seed &seed = seeds_[s];
+    seed.x = 0.5f;
+    seed.y = 0.5f;
+    for (uint8_t attempt = 0; attempt < 16; ++attempt)
+    {
+      const float x = random01();
+      const float y = random01();
+      if (boundary.signedDistance(x, y) < -kSeedMargin)
+      {
+        seed.x = x;
+        seed.y = y;
+        break;
+      }
+    }
+    seed.builtX = seed.x;
+    seed.builtY = seed.y;
+    randomVelocity(seed);
+  }
+  seedCount_ = count;
+  seedShape_ = config_->boundaryShape;
+  seedScale_ = config_->boundaryScale;
+  dirty_ = true;
+}
+
+void Voronoi::moveSeeds(const Boundary &boundary, float dt)
+{
+  const float reroll = config_->timeStep > 0.0f ? kRerollChance * dt / config_->timeStep : kRerollChance;
+  for (uint8_t s = 0; s < seedCount_; ++s)
+  {
+    Seed &seed = seeds_[s];
+    const float nx = seed.x + seed.vx * dt;
+    const float ny = seed.y + seed.vy * dt;
+    if (boundary.signedDistance(nx, ny) > -kSeedMargin)
+    {
+      // Reflect off the radial normal and stay put for this step.
+      float rx = nx - 0.5f;
+      float ry = ny - 0.5f;
+      const float len = sqrtf(rx * rx + ry * ry);
+      if (len > 1e-6f)
+      {
+        rx /= len;
+        ry /= len;
+        const float dot = seed.vx * rx + seed.vy * ry;
+        if (dot > 0.0f)
+        {
+          seed.vx -= 2.0f * dot * rx;
+          seed.vy -= 2.0f * dot * ry;
+        }
+      }
+    }
+    else
+    {
+      seed.x = nx;
+      seed.y = ny;
+    }
+    if (random01() < reroll)
+    {
+      randomVelocity(seed);
+    }
+    const float driftX = seed.x - seed.builtX;
+    const float driftY = seed.y - seed.builtY;
+    if (driftX * driftX + driftY * driftY > kRebuildDrift * kRebuildDrift)
+    {
+      dirty_ = true;
+    }
+  }
+}
+
+VoronoiFrame Voronoi::beginFrame(const Boundary &boundary, float dt)
+{
+  VoronoiFrame f;
+  const float strength = config_->voronoiStrength;
+  f.active = strength > 1e-6f;
+  if (!f.active)
+  {
+    return f;
+  }
+
+  uint8_t count = config_->voronoiCellCount;
+  count = count < 2 ? 2 : (count > VORONOI_MAX_SEEDS ? VORONOI_MAX_SEEDS : count);
+  if (count != seedCount_ || config_->boundaryShape != seedShape_ || config_->boundaryScale != seedScale_)
+  {
+    scatterSeeds(boundary);
+  }
+  moveSeeds(boundary, dt);
+  if (dirty_)
+  {
+    rebuild();
+  }
+
+  // voronoiDecayRate is per timeStep like turbDecayRate; on an edge the JS damps with 0.7x of it.
+  const float steps = config_->timeStep > 0.0f ? dt / config_->timeStep : 1.0f;
+  const float decay = powf(config_->voronoiDecayRate, steps);
+  const float edgeDecay = powf(config_->voronoiDecayRate * 0.7f, steps);
+  f.keep = 1.0f - config_->voronoiBlend * (1.0f - decay);
+  f.edgeKeep = 1.0f - config_->voronoiBlend * (1.0f - edgeDecay);
+  f.gain = strength * config_->voronoiAttraction * dt;
+  f.invEdgeWidth = config_->voronoiEdgeWidth > 1e-4f ? 1.0f / config_->voronoiEdgeWidth : 1e4f;
+  f.sign = config_->voronoiPullMode ? 1.0f : -1.0f;
+  f.edgeSpeed = 0.1f * strength;
+  return f;
+}
+
+bool Voronoi::edgeDistance(float x, float y, float &dist, float &dirX, float &dirY) const
+{
+  const uint16_t c = cellOf(x, y);
+  const uint8_t a = nearest_[c];
+  const uint8_t b = second_[c];
+  if (seedCount_ < 2 || a == VORONOI_NO_SEED || b == VORONOI_NO_SEED)
+  {
+    return false;
+  }
+  const Seed &sa = seeds_[a];
+  const Seed &sb = seeds_[b];
+  const float abx = sb.x - sa.x;
+  const float aby = sb.y - sa.y;
+  const float len = sqrtf(abx * abx + aby * aby);
+  if (len < 1e-6f)
+  {
+    return false;
+  }
+  const float nx = abx / len;
+  const float ny = aby / len;
+  // Signed offset from the bisector, negative on a's side.
+  const float s = (x - 0.5f * (sa.x + sb.x)) * nx + (y - 0.5f * (sa.y + sb.y)) * ny;
+  dist = fabsf(s);
+  dirX = s < 0.0f ? nx : -nx;
+  dirY = s < 0.0f ? ny : -ny;
+  return true;
+}
+
+void Voronoi::accumulate(const VoronoiFrame &frame, float x, float y, float &vx, float &vy) const
+{
+  float dist;
+  float gx;
+  float gy;
+  if (!edgeDistance(x, y, dist, gx, gy))
+  {
+    return;
+  }
+  const float t = dist * frame.invEdgeWidth;
+  if (t >= 1.0f)
+  {
+    vx *= frame.keep;
+    vy *= frame.keep;
+    return;
+  }
+  const float edgeFactor = 1.0f - t * sqrtf(t);
+  const bool onEdge = edgeFactor > kOnEdge;
+  const float speed2 = vx * vx + vy * vy;
+  const float keep = onEdge ? frame.edgeKeep : frame.keep;
+  float nvx = vx * keep;
+  float nvy = vy * keep;
+
+  const float force = edgeFactor * frame.gain;
+  gx *= frame.sign;
+  gy *= frame.sign;
+  if (!onEdge || vx * gx + vy * gy < 0.0f)
+  {
+    nvx += gx * force * kApproachGain;
+    nvy += gy * force * kApproachGain;
+  }
+  else
+  {
+    nvx += (gx * kHoldGain - gy * kAlongGain) * force;
+    nvy += (gy * kHoldGain + gx * kAlongGain) * force;
+  }
+
+  if (onEdge)
+  {
+    const float limit = fmaxf(frame.edgeSpeed, 0.6f * sqrtf(speed2));
+    const float s2 = nvx * nvx + nvy * nvy;
+    if (s2 > limit * limit)
+    {
+      const float k = limit / sqrtf(s2);
+      nvx *= k;
+      nvy *= k;
+    }
+  }
+  vx = nvx;
+  vy = nvy;
+}
+
+void Voronoi::apply(const Boundary &boundary, const float *x, const float *y, float *vx, float *vy, uint16_t count, float dt)
+{
+  const VoronoiFrame frame = beginFrame(boundary, dt);
+  if (!frame.active)
+  {
+    return;
+  }
+  for (uint16_t i = 0; i < count; ++i)
+  {
+    accumulate(frame, x[i], y[i], vx[i], vy[i]);
+  }
+}
+
+// Keeps the two seeds closest to a cell center, for stamping.
+static inline void offer(uint8_t id, float d2, uint8_t &best, float &bestD2, uint8_t &second, float &secondD2)
+{
+  if (d2 < bestD2)
+  {
+    second = best;
+    secondD2 = bestD2;
+    best = id;
+    bestD2 = d2;
+  }
+  else if (d2 < secondD2)
+  {
+    second = id;
+    secondD2 = d2;
+  }
+}
+
+void Voronoi::floodPass(uint8_t step, const uint8_t *fromNear, const uint8_t *fromSecond, uint8_t *toNear, uint8_t *toSecond) const
+{
+  // The nearest seed wins by distance; the partner is the candidate whose bisector with it is
+  // closest, ranked by (d2 - bestD2)^2 / |seed - best|^2 so no square root or division is
+  // needed. Far from both, that is often not the second-nearest seed.
+  const float cellSize = 1.0f / VORONOI_GRID;
+  uint8_t ids[18];
+  float d2s[18];
+  // seen[id] holds the last cell that took seed id as a candidate.
+  uint16_t seen[VORONOI_MAX_SEEDS];
+  for (uint8_t s = 0; s < VORONOI_MAX_SEEDS; ++s)
+  {
+    seen[s] = VORONOI_CELLS;
+  }
+  for (int j = 0; j < VORONOI_GRID; ++j)
+  {
+    const float cy = (j + 0.5f) * cellSize;
+    for (int i = 0; i < VORONOI_GRID; ++i)
+    {
+      const float cx = (i + 0.5f) * cellSize;
+      const uint16_t cell = (uint16_t)(j * VORONOI_GRID + i);
+      uint8_t count = 0;
+      uint8_t best = 0;
+      const int jLo = j >= step ? j - step : j;
+      const int jHi = j + step < VORONOI_GRID ? j + step : j;
+      const int iLo = i >= step ? i - step : i;
+      const int iHi = i + step < VORONOI_GRID ? i + step : i;
+      for (int nj = jLo; nj <= jHi; nj += step)
+      {
+        for (int ni = iLo; ni <= iHi; ni += step)
+        {
+          const uint16_t n = (uint16_t)(nj * VORONOI_GRID + ni);
+          const uint8_t candidates[2] = {fromNear[n], fromSecond[n]};
+          for (uint8_t k = 0; k < 2; ++k)
+          {
+            const uint8_t id = candidates[k];
+            if (id == VORONOI_NO_SEED || seen[id] == cell)
+            {
+              continue;
+            }
+            seen[id] = cell;
+            const float dx = seeds_[id].x - cx;
+            const float dy = seeds_[id].y - cy;
+            ids[count] = id;
+            d2s[count] = dx * dx + dy * dy;
+            if (d2s[count] < d2s[best])
+            {
+              best = count;
+            }
+            ++count;
+          }
+        }
+      }
+
+      toNear[cell] = count > 0 ? ids[best] : VORONOI_NO_SEED;
+      toSecond[cell] = VORONOI_NO_SEED;
+      if (count < 2)
+      {
+        continue;
+      }
+      // Scores are compared cross-multiplied, gap^2 * partnerLen2 < partnerGap2 * len2.
+      const Seed &b = seeds_[ids[best]];
+      float partnerGap2 = 1.0f;
+      float partnerLen2 = 0.0f;
+      for (uint8_t m = 0; m < count; ++m)
+      {
+        const float sx = seeds_[ids[m]].x - b.x;
+        const float sy = seeds_[ids[m]].y - b.y;
+        const float len2 = sx * sx + sy * sy;
+        if (m == best || len2 < 1e-12f)
+        {
+          continue;
+        }
+        const float gap = d2s[m] - d2s[best];
+        if (gap * gap * partnerLen2 < partnerGap2 * len2)
+        {
+          partnerGap2 = gap * gap;
+          partnerLen2 = len2;
+          toSecond[cell] = ids[m];
+        }
+      }
+    }
+  }
+}
+
+uint8_t Voronoi::stamp(uint8_t id, uint16_t c)
+{
+  const float cellSize = 1.0f / VORONOI_GRID;
+  const float cx = ((c % VORONOI_GRID) + 0.5f) * cellSize;
+  const float cy = ((c / VORONOI_GRID) + 0.5f) * cellSize;
+  uint8_t best = nearest_[c];
+  uint8_t second = second_[c];
+  float bestD2 = 1e30f;
+  float secondD2 = 1e30f;
+  if (best != VORONOI_NO_SEED)
+  {
+    bestD2 = (seeds_[best].x - cx) * (seeds_[best].x - cx) + (seeds_[best].y - cy) * (seeds_[best].y - cy);
+  }
+  if (second != VORONOI_NO_SEED)
+  {
+    secondD2 = (seeds_[second].x - cx) * (seeds_[second].x - cx) + (seeds_[second].y - cy) * (seeds_[second].y - cy);
+  }
+  const uint8_t previous = second;
+  offer(id, (seeds_[id].x - cx) * (seeds_[id].x - cx) + (seeds_[id].y - cy) * (seeds_[id].y - cy), best, bestD2, second, secondD2);
+  nearest_[c] = best;
+  second_[c] = second;
+  if (id != best && id != second)
+  {
+    return id;
+  }
+  return previous != best && previous != second ? previous : VORONOI_NO_SEED;
+}
+
+void Voronoi::rebuild()
+{
+  // Each seed stamps its own cell; the flood then spreads both candidates of a cell at strides
+  // VORONOI_GRID / 2 .. 1 plus one extra stride-1 pass (JFA+1), which fixes most of the cells
+  // plain JFA gets wrong near three-seed corners. Passes ping-pong so the last one lands in
+  // nearest_ / second_.
+  for (uint16_t c = 0; c < VORONOI_CELLS; ++c)
+  {
+    nearest_[c] = VORONOI_NO_SEED;
+    second_[c] = VORONOI_NO_SEED;
+  }
+  for (uint8_t s = 0; s < seedCount_; ++s)
+  {
+    Seed &seed = seeds_[s];
+    seed.builtX = seed.x;
+    seed.builtY = seed.y;
+    const uint16_t c = cellOf(seed.x, seed.y);
+    const uint8_t evicted = stamp(s, c);
+    if (evicted == VORONOI_NO_SEED)
+    {
+      continue;
+    }
+    // A third seed in one cell would never reach the flood; park it in a neighbor with room.
+    const int i = c % VORONOI_GRID;
+    const int j = c / VORONOI_GRID;
+    for (uint8_t k = 0; k < 9; ++k)
+    {
+      const int ni = i + k % 3 - 1;
+      const int nj = j + k / 3 - 1;
+      const uint16_t n = (uint16_t)(nj * VORONOI_GRID + ni);
+      if (ni >= 0 && ni < VORONOI_GRID && nj >= 0 && nj < VORONOI_GRID && second_[n] == VORONOI_NO_SEED)
+      {
+        stamp(evicted, n);
+        break;
+      }
+    }
+  }
+
+  uint8_t passes = 0;
+  uint8_t *fromNear = nearest_;
+  uint8_t *fromSecond = second_;
+  uint8_t *toNear = floodNear_;
+  uint8_t *toSecond = floodSecond_;
+  for (uint8_t step = VORONOI_GRID / 2;; step /= 2)
+  {
+    floodPass(step, fromNear, fromSecond, toNear, toSecond);
+    ++passes;
+    uint8_t *t = fromNear;
+    fromNear = toNear;
+    toNear = t;
+    t = fromSecond;
+    fromSecond = toSecond;
+    toSecond = t;
+    if (step == 1)
+    {
+      break;
+    }
+  }
+  floodPass(1, fromNear, fromSecond, toNear, toSecond);
+  ++passes;
+  if (toNear != nearest_)
+  {
+    for (uint16_t c = 0; c < VORONOI_CELLS; ++c)
+    {
+      nearest_[c] = toNear[c];
+      second_[c] = toSecond[c];
+    }
+  }
+  dirty_ = false;
+  ++stats_.rebuilds;
+  stats_.passes += passes;
+}
+
+uint8_t Voronoi::nearestSeed(float x, float y) const
+{
+  uint8_t best = VORONOI_NO_SEED;
+  float bestD2 = 1e30f;
+  for (uint8_t s = 0; s < seedCount_; ++s)
+  {
+    const float dx = seeds_[s].x - x;
+    const float dy = seeds_[s].y - y;
+    const float d2 = dx * dx + dy * dy;
+    if (d2 < bestD2)
+    {
+      best = s;
+      bestD2 = d2;
+    }
+  }
+  return best;
+}
+
+float Voronoi::edgeDistanceExact(float x, float y) const
 {
-  (void)dt;
-  (void)config_;
+  const uint8_t a = nearestSeed(x, y);
+  if (a == VORONOI_NO_SEED)
+  {
+    return 0.0f;
+  }
+  const float ax = seeds_[a].x - x;
+  const float ay = seeds_[a].y - y;
+  const float da2 = ax * ax + ay * ay;
+  float dist = 1e30f;
+  for (uint8_t s = 0; s < seedCount_; ++s)
+  {
+    if (s == a)
+    {
+      continue;
+    }
+    const float bx = seeds_[s].x - x;
+    const float by = seeds_[s].y - y;
+    const float abx = seeds_[s].x - seeds_[a].x;
+    const float aby = seeds_[s].y - seeds_[a].y;
+    const float len = sqrtf(abx * abx + aby * aby);
+    if (len < 1e-6f)
+    {
+      continue;
+    }
+    // Distance to the bisector of a and s: (|p - s|^2 - |p - a|^2) / (2 |s - a|).
+    const float d = (bx * bx + by * by - da2) / (2.0f * len);
+    dist = d < dist ? d : dist;
+  }
+  return dist;
 }
@@ -34,8 +34,11 @@ static bool applySimpleCommand(uint8_t idx, uint8_t value, SimConfig &cfg)
     cfg.timeScale = 0.1f + (value / 255.0f) * 7.9f;
     return true;
   case 53:
-    cfg.particleCount = 50 + (uint16_t)((value / 255.0f) * 450.0f);
+  {
+    const uint16_t count = 50 + (uint16_t)((value / 255.0f) * 450.0f);
+    cfg.particleCount = count > cfg.particleCapacity ? cfg.particleCapacity : count;
     return true;
+  }
   case 70:
     cfg.boundaryMode = value > 0 ? 1 : 0;
     return true;
@@ -0,0 +1,200 @@
+#include "WorkerPool.h"
+
+#if !SIM_NATIVE
+static constexpr uint32_t kHelperStackBytes = 4096;
+static constexpr UBaseType_t kHelperPriority = 2;
+// Barrier polls before a waiter starts sleeping a tick per poll (tens of microseconds at
+// 240 MHz). Past that the other worker has been preempted, and spinning on at helper
+// priority would starve the render loop on this core.
+static constexpr uint32_t kBarrierSpins = 4096;
+#endif
+
+#if SIM_NATIVE
+WorkerPool::~WorkerPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  for (uint8_t h = 0; h < helperCount_; ++h)
+  {
+    helpers_[h].thread.join();
+  }
+}
+#endif
+
+uint8_t WorkerPool::clampWorkers(uint8_t requested) const
+{
+  if (requested < 1)
+  {
+    return 1;
+  }
+  return requested > MAX_POOL_WORKERS ? MAX_POOL_WORKERS : requested;
+}
+
+bool WorkerPool::ensureHelpers(uint8_t count)
+{
+  while (helperCount_ < count)
+  {
+    Helper &h = helpers_[helperCount_];
+    h.pool = this;
+    h.index = (uint8_t)(helperCount_ + 1);
+#if SIM_NATIVE
+    // A helper created mid-session must wait for the next run, not replay the last one.
+    h.startGeneration = generation_;
+    h.thread = std::thread(helperEntry, &h);
+#else
+    const BaseType_t otherCore = xPortGetCoreID() == 0 ? 1 : 0;
+    if (xTaskCreatePinnedToCore(helperEntry, "simHelper", kHelperStackBytes, &h, kHelperPriority, &h.handle, otherCore) != pdPASS)
+    {
+      return false;
+    }
+#endif
+    ++helperCount_;
+  }
+  return true;
+}
+
+void WorkerPool::run(PoolJobFn job, void *ctx, uint8_t workers)
+{
+  workers = clampWorkers(workers);
+  if (workers > 1 && !ensureHelpers((uint8_t)(workers - 1)))
+  {
+    workers = (uint8_t)(helperCount_ + 1);
+  }
+  if (workers <= 1)
+  {
+    active_ = 1;
+    job(ctx, 0, 1);
+    return;
+  }
+
+  active_ = workers;
+  pending_.store((uint8_t)(workers - 1), std::memory_order_release);
+#if SIM_NATIVE
+  {
+    // Idle helpers snapshot the job under this lock too, so publish it here.
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    ctx_ = ctx;
+    workers_ = workers;
+    ++generation_;
+  }
+  wake_.notify_all();
+#else
+  job_ = job;
+  ctx_ = ctx;
+  workers_ = workers;
+  caller_ = xTaskGetCurrentTaskHandle();
+  for (uint8_t h = 0; h < workers - 1; ++h)
+  {
+    xTaskNotifyGive(helpers_[h].handle);
+  }
+#endif
+
+  job(ctx, 0, workers);
+
+#if SIM_NATIVE
+  while (pending_.load(std::memory_order_acquire) != 0)
+  {
+    std::this_thread::yield();
+  }
+#else
+  while (pending_.load(std::memory_order_acquire) != 0)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+#endif
+}
+
+void WorkerPool::barrier()
+{
+  if (active_ <= 1)
+  {
+    return;
+  }
+  // Sense-reversing barrier: the last worker to arrive resets the count and flips the phase.
+  const uint32_t phase = barrierPhase_.load(std::memory_order_acquire);
+  if (barrierCount_.fetch_add(1, std::memory_order_acq_rel) + 1 == active_)
+  {
+    barrierCount_.store(0, std::memory_order_relaxed);
+    barrierPhase_.fetch_add(1, std::memory_order_release);
+    return;
+  }
+#if SIM_NATIVE
+  while (barrierPhase_.load(std::memory_order_acquire) == phase)
+  {
+    std::this_thread::yield();
+  }
+#else
+  uint32_t spins = 0;
+  while (barrierPhase_.load(std::memory_order_acquire) == phase)
+  {
+    // taskYIELD() would only reach tasks of our priority; the loop() task sits below it.
+    if (++spins > kBarrierSpins)
+    {
+      vTaskDelay(1);
+    }
+  }
+#endif
+}
+
+void WorkerPool::helperEntry(void *arg)
+{
+  Helper *h = static_cast<Helper *>(arg);
+  h->pool->helperLoop(h->index);
+}
+
+void WorkerPool::finishHelper()
+{
+#if SIM_NATIVE
+  pending_.fetch_sub(1, std::memory_order_acq_rel);
+#else
+  if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+  {
+    xTaskNotifyGive(caller_);
+  }
+#endif
+}
+
+void WorkerPool::helperLoop(uint8_t index)
+{
+#if SIM_NATIVE
+  uint32_t seen = helpers_[index - 1].startGeneration;
+  for (;;)
+  {
+    PoolJobFn job;
+    void *ctx;
+    uint8_t workers;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (generation_ == seen && !stopping_)
+      {
+        wake_.wait(lock);
+      }
+      if (stopping_)
+      {
+        return;
+      }
+      // Snapshot under the lock so a late wake-up never mixes two runs.
+      seen = generation_;
+      job = job_;
+      ctx = ctx_;
+      workers = workers_;
+    }
+    if (index < workers)
+    {
+      job(ctx, index, workers);
+      finishHelper();
+    }
+  }
+#else
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    job_(ctx_, index, workers_);
+    finishHelper();
+  }
+#endif
+}